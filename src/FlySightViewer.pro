@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui printsupport webenginewidgets sql
+QT       += core gui printsupport webenginewidgets sql concurrent network multimedia
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -26,18 +26,40 @@ SOURCES += main.cpp \
     simulationview.cpp \
     tone.cpp \
     ubx.cpp \
+    audiocomparison.cpp \
+    audiopool.cpp \
+    audiorenderer.cpp \
+    audiosimulation.cpp \
+    simulationstream.cpp \
     waypoint.cpp \
     datapoint.cpp \
     configdialog.cpp \
+    mappath.cpp \
     mapview.cpp \
+    pathsimplifier.cpp \
+    segmentindex.cpp \
+    cursormarkers.cpp \
     common.cpp \
     videoview.cpp \
+    viewscheduler.cpp \
+    tracksummary.cpp \
+    tracksegments.cpp \
+    trackutil.cpp \
+    batchprocessor.cpp \
+    scoringserver.cpp \
+    scoringbenchmark.cpp \
     windplot.cpp \
     liftdragplot.cpp \
     scoringview.cpp \
     genome.cpp \
     orthoview.cpp \
     playbackview.cpp \
+    reprocessqueue.cpp \
+    columnwriter.cpp \
+    exportwriter.cpp \
+    kmlwriter.cpp \
+    trackarchive.cpp \
+    trackdatabase.cpp \
     ppcform.cpp \
     speedform.cpp \
     scoringmethod.cpp \
@@ -48,7 +70,10 @@ SOURCES += main.cpp \
     wideopendistancescoring.cpp \
     wideopenspeedscoring.cpp \
     geographicutil.cpp \
-    importworker.cpp \
+    lanecache.cpp \
+    lanecoordinates.cpp \
+    importserver.cpp \
+    logbookmodel.cpp \
     logbookview.cpp \
     performancescoring.cpp \
     performanceform.cpp \
@@ -108,18 +133,40 @@ HEADERS  += mainwindow.h \
     simulationview.h \
     tone.h \
     ubx.h \
+    audiocomparison.h \
+    audiopool.h \
+    audiorenderer.h \
+    audiosimulation.h \
+    simulationstream.h \
     waypoint.h \
     plotvalue.h \
     configdialog.h \
+    mappath.h \
     mapview.h \
+    pathsimplifier.h \
+    segmentindex.h \
+    cursormarkers.h \
     common.h \
     videoview.h \
+    viewscheduler.h \
+    tracksummary.h \
+    tracksegments.h \
+    trackutil.h \
+    batchprocessor.h \
+    scoringserver.h \
+    scoringbenchmark.h \
     windplot.h \
     liftdragplot.h \
     scoringview.h \
     genome.h \
     orthoview.h \
     playbackview.h \
+    reprocessqueue.h \
+    columnwriter.h \
+    exportwriter.h \
+    kmlwriter.h \
+    trackarchive.h \
+    trackdatabase.h \
     ppcform.h \
     speedform.h \
     scoringmethod.h \
@@ -132,7 +179,10 @@ HEADERS  += mainwindow.h \
     wideopendistancescoring.h \
     wideopenspeedscoring.h \
     geographicutil.h \
-    importworker.h \
+    lanecache.h \
+    lanecoordinates.h \
+    importserver.h \
+    logbookmodel.h \
     logbookview.h \
     flareform.h \
     flarescoring.h \
@@ -0,0 +1,239 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "audiocomparison.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <limits>
+
+#include "audiorenderer.h"
+#include "audiosimulation.h"
+#include "batchprocessor.h"
+#include "config.h"
+
+typedef struct {
+    QString                     configPath;
+    QString                     wavPath;
+    QString                     error;
+    AudioSimulation::ToneEvents events;
+} AudioComparisonResult;
+
+// Renders one configuration for QtConcurrent::blockingMapped
+class AudioComparisonTask
+{
+public:
+    typedef AudioComparisonResult result_type;
+
+    AudioComparisonTask(const TrackUtil::DataPoints &data,
+                        const QString &audioFolder):
+        mData(data),
+        mAudioFolder(audioFolder)
+    {
+
+    }
+
+    AudioComparisonResult operator()(const QPair< QString, QString > &paths) const;
+
+private:
+    TrackUtil::DataPoints mData;
+    QString               mAudioFolder;
+};
+
+AudioComparisonResult AudioComparisonTask::operator()(
+        const QPair< QString, QString > &paths) const
+{
+    AudioComparisonResult result;
+    result.configPath = paths.first;
+    result.wavPath = paths.second;
+
+    // Read configuration the same way the simulation view does
+    Config config;
+    config.readSingle(paths.first);
+    config.mRootConfig = paths.first;
+    config.mConfigFolder = QFileInfo(paths.first).absolutePath();
+
+    if (!mAudioFolder.isEmpty())
+    {
+        config.mAudioFolder = mAudioFolder;
+    }
+
+    AudioSimulation simulation(config, mData);
+    simulation.setToneLog(&result.events);
+
+    QFile file(paths.second);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        result.error = QString("Couldn't write %1").arg(file.fileName());
+        return result;
+    }
+
+    if (!AudioRenderer::render(simulation, &file))
+    {
+        result.error = QString("Couldn't write %1").arg(file.fileName());
+    }
+
+    return result;
+}
+
+AudioComparison::AudioComparison():
+    mThreadCount(0)
+{
+
+}
+
+int AudioComparison::run()
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!QDir().mkpath(mOutputPath))
+    {
+        err << QString("Couldn't create output folder %1").arg(mOutputPath) << endl;
+        return 1;
+    }
+
+    QString error;
+    TrackUtil::DataPoints data;
+    if (!BatchProcessor::loadTrack(mTrackPath, BatchProcessor::defaultOptions(), data, error))
+    {
+        err << error << endl;
+        return 1;
+    }
+
+    // Name each output after its configuration
+    QList< QPair< QString, QString > > paths;
+    QSet< QString > names;
+
+    foreach (const QString &configPath, mConfigPaths)
+    {
+        const QString baseName = QFileInfo(configPath).completeBaseName();
+
+        QString name = baseName;
+        for (int i = 2; names.contains(name); ++i)
+        {
+            name = QString("%1_%2").arg(baseName).arg(i);
+        }
+        names.insert(name);
+
+        paths.append(qMakePair(QFileInfo(configPath).absoluteFilePath(),
+                               QDir(mOutputPath).filePath(name + ".wav")));
+    }
+
+    if (mThreadCount > 0)
+    {
+        QThreadPool::globalInstance()->setMaxThreadCount(mThreadCount);
+    }
+
+    // Render configurations in parallel
+    QList< AudioComparisonResult > results =
+            QtConcurrent::blockingMapped< QList< AudioComparisonResult > >(
+                paths, AudioComparisonTask(data, mAudioFolder));
+
+    int failed = 0;
+    foreach (const AudioComparisonResult &result, results)
+    {
+        if (!result.error.isEmpty())
+        {
+            err << result.error << endl;
+            ++failed;
+        }
+    }
+
+    // Write tone changes side by side
+    QFile file(QDir(mOutputPath).filePath("tones.csv"));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        err << QString("Couldn't write %1").arg(file.fileName()) << endl;
+        return 1;
+    }
+
+    QTextStream stream(&file);
+
+    stream << "time";
+    foreach (const AudioComparisonResult &result, results)
+    {
+        const QString name = QFileInfo(result.wavPath).completeBaseName();
+        stream << "," << name << "_rate," << name << "_pitch";
+    }
+    stream << endl;
+
+    QVector< int > next(results.size(), 0);
+
+    while (true)
+    {
+        // Find the next change in any configuration
+        qint64 ms = std::numeric_limits< qint64 >::max();
+        for (int i = 0; i < results.size(); ++i)
+        {
+            const AudioSimulation::ToneEvents &events = results[i].events;
+            if (next[i] < events.size())
+            {
+                ms = qMin(ms, events[next[i]].ms);
+            }
+        }
+
+        if (ms == std::numeric_limits< qint64 >::max()) break;
+
+        stream << QString::number(ms / 1000., 'f', 3);
+
+        for (int i = 0; i < results.size(); ++i)
+        {
+            const AudioSimulation::ToneEvents &events = results[i].events;
+            if (next[i] < events.size() && events[next[i]].ms == ms)
+            {
+                ++next[i];
+            }
+
+            // Repeat the current values so each row stands alone
+            if (next[i] > 0)
+            {
+                const AudioSimulation::ToneEvent &event = events[next[i] - 1];
+                stream << "," << event.rate << "," << event.pitch;
+            }
+            else
+            {
+                stream << ",,";
+            }
+        }
+
+        stream << endl;
+    }
+
+    out << QString("Rendered %1 configurations (%2 failed) in %3 s")
+           .arg(results.size())
+           .arg(failed)
+           .arg(timer.elapsed() / 1000., 0, 'f', 1) << endl;
+
+    return (failed > 0) ? 2 : 0;
+}
@@ -0,0 +1,55 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef AUDIOCOMPARISON_H
+#define AUDIOCOMPARISON_H
+
+#include <QString>
+#include <QStringList>
+
+/* Headless rendering of one track with several FlySight configurations.
+ * Each configuration is simulated in parallel with its own Config, Tone
+ * and UBX, written to its own WAV, and its tone rate and pitch changes
+ * are merged into one CSV for side-by-side comparison. */
+class AudioComparison
+{
+public:
+    AudioComparison();
+
+    void setTrackPath(const QString &trackPath) { mTrackPath = trackPath; }
+    void setConfigPaths(const QStringList &configPaths) { mConfigPaths = configPaths; }
+    void setOutputPath(const QString &outputPath) { mOutputPath = outputPath; }
+    void setAudioFolder(const QString &audioFolder) { mAudioFolder = audioFolder; }
+    void setThreadCount(int threadCount) { mThreadCount = threadCount; }
+
+    int run();
+
+private:
+    QString     mTrackPath;
+    QStringList mConfigPaths;
+    QString     mOutputPath;
+    QString     mAudioFolder;
+    int         mThreadCount;
+};
+
+#endif // AUDIOCOMPARISON_H
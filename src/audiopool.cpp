@@ -0,0 +1,175 @@
+#include "audiopool.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QObject>
+#include <QWeakPointer>
+#include <QtEndian>
+
+#include <string.h>
+
+namespace
+{
+    QMutex                                               sMutex;
+    QHash< QString, QWeakPointer< const AudioPool > >    sPools;
+}
+
+AudioPool::AudioPool(
+        const QString &folder):
+    mSignature(signature(folder)),
+    mSize(0)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QDir dir(folder);
+    foreach (const QString &fileName, dir.entryList(QStringList("*.wav"), QDir::Files))
+    {
+        QByteArray samples;
+        QString error;
+
+        if (readWAV(dir.filePath(fileName), samples, error))
+        {
+            mPrompts.insert(fileName.toLower(), samples);
+            mSize += samples.size();
+        }
+        else
+        {
+            mErrors.append(QString("%1: %2").arg(fileName).arg(error));
+        }
+    }
+
+    mLoadTime = timer.elapsed();
+}
+
+QSharedPointer< const AudioPool > AudioPool::load(
+        const QString &folder)
+{
+    QMutexLocker locker(&sMutex);
+
+    // Drop pools no simulation holds any more
+    QMutableHashIterator< QString, QWeakPointer< const AudioPool > > i(sPools);
+    while (i.hasNext())
+    {
+        if (i.next().value().isNull()) i.remove();
+    }
+
+    // Reuse the pool if another simulation still holds it and the folder
+    // hasn't changed since it was read
+    QSharedPointer< const AudioPool > pool = sPools.value(folder).toStrongRef();
+    if (!pool || pool->mSignature != signature(folder))
+    {
+        pool = QSharedPointer< const AudioPool >(new AudioPool(folder));
+        sPools.insert(folder, pool);
+    }
+
+    return pool;
+}
+
+QByteArray AudioPool::samples(
+        const QString &fileName) const
+{
+    return mPrompts.value(fileName.toLower());
+}
+
+QString AudioPool::signature(
+        const QString &folder)
+{
+    // Names, sizes and modification times of the prompts
+    QStringList entries;
+
+    QDir dir(folder);
+    foreach (const QFileInfo &info, dir.entryInfoList(QStringList("*.wav"), QDir::Files, QDir::Name))
+    {
+        entries.append(QString("%1/%2/%3")
+                       .arg(info.fileName())
+                       .arg(info.size())
+                       .arg(info.lastModified().toMSecsSinceEpoch()));
+    }
+
+    return entries.join('\n');
+}
+
+bool AudioPool::readWAV(
+        const QString &fileName,
+        QByteArray &samples,
+        QString &error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        error = file.errorString();
+        return false;
+    }
+
+    const QByteArray data = file.readAll();
+    const char *p = data.constData();
+
+    if (data.size() < 12
+            || memcmp(p, "RIFF", 4)
+            || memcmp(p + 8, "WAVE", 4))
+    {
+        error = QObject::tr("not a WAV file");
+        return false;
+    }
+
+    bool hasFormat = false;
+    int pos = 12;
+
+    // Walk the RIFF chunks
+    while (pos + 8 <= data.size())
+    {
+        const char *id = p + pos;
+        const quint32 size = qFromLittleEndian< quint32 >((const uchar *) p + pos + 4);
+        const int start = pos + 8;
+
+        if (size > (quint32) (data.size() - start))
+        {
+            error = QObject::tr("truncated chunk");
+            return false;
+        }
+
+        if (!memcmp(id, "fmt ", 4))
+        {
+            if (size < 16)
+            {
+                error = QObject::tr("bad format chunk");
+                return false;
+            }
+
+            const quint16 format = qFromLittleEndian< quint16 >((const uchar *) p + start);
+            const quint16 channels = qFromLittleEndian< quint16 >((const uchar *) p + start + 2);
+            const quint16 bits = qFromLittleEndian< quint16 >((const uchar *) p + start + 14);
+
+            if (format != 1 || channels != 1 || bits != 8)
+            {
+                error = QObject::tr("expected 8-bit mono PCM");
+                return false;
+            }
+
+            hasFormat = true;
+        }
+        else if (!memcmp(id, "data", 4))
+        {
+            if (!hasFormat)
+            {
+                error = QObject::tr("data before format chunk");
+                return false;
+            }
+
+            samples = data.mid(start, size);
+            return true;
+        }
+
+        // Chunks are padded to an even size
+        pos = start + size + (size & 1);
+    }
+
+    error = QObject::tr("no data chunk");
+    return false;
+}
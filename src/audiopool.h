@@ -0,0 +1,43 @@
+#ifndef AUDIOPOOL_H
+#define AUDIOPOOL_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+
+/* Immutable set of speech prompts read from an audio folder. Each WAV is
+ * validated and its samples held in memory, so Tone can play a prompt
+ * without touching the file system. Pools are shared between every
+ * simulation using the same folder, including those on worker threads,
+ * and are reloaded when the folder contents change. Prompt names are not
+ * case-sensitive. */
+class AudioPool
+{
+public:
+    static QSharedPointer< const AudioPool > load(const QString &folder);
+
+    QByteArray samples(const QString &fileName) const;
+
+    int count() const { return mPrompts.size(); }
+    qint64 size() const { return mSize; }
+    qint64 loadTime() const { return mLoadTime; }
+
+    const QStringList &errors() const { return mErrors; }
+
+private:
+    AudioPool(const QString &folder);
+
+    static QString signature(const QString &folder);
+
+    QHash< QString, QByteArray > mPrompts;
+    QString                      mSignature;
+    qint64                       mSize;
+    qint64                       mLoadTime;
+    QStringList                  mErrors;
+
+    static bool readWAV(const QString &fileName, QByteArray &samples, QString &error);
+};
+
+#endif // AUDIOPOOL_H
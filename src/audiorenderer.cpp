@@ -0,0 +1,119 @@
+#include "audiorenderer.h"
+
+#include <QFile>
+
+#include "audiosimulation.h"
+
+#define BLOCK_SIZE  65536       // Samples written at a time
+
+AudioRenderer::AudioRenderer(
+        const Config &config,
+        const MainWindow::DataPoints &data,
+        const QString &fileName):
+    mConfig(config),
+    mData(data),
+    mFileName(fileName),
+    mCancel(0)
+{
+
+}
+
+void AudioRenderer::cancel()
+{
+    mCancel.storeRelease(1);
+}
+
+QByteArray AudioRenderer::header(
+        qint64 numSamples)
+{
+    const uint32_t numSamples32 = (uint32_t) numSamples;
+    const uint32_t chunkSize = 36 + numSamples32;
+
+    const unsigned char bytes[] =
+    {
+        0x52, 0x49, 0x46, 0x46, // ChunkID = "RIFF"
+        (unsigned char) (chunkSize),
+        (unsigned char) (chunkSize >> 8),
+        (unsigned char) (chunkSize >> 16),
+        (unsigned char) (chunkSize >> 24),
+        0x57, 0x41, 0x56, 0x45, // Format = "WAVE"
+        0x66, 0x6D, 0x74, 0x20, // Subchunk1ID = "fmt "
+        0x10, 0x00, 0x00, 0x00, // Subchunk1Size
+        0x01, 0x00,             // AudioFormat
+        0x01, 0x00,             // NumChannels
+        0x12, 0x7A, 0x00, 0x00, // SampleRate = 31250
+        0x12, 0x7A, 0x00, 0x00, // ByteRate = 31250
+        0x01, 0x00,             // BlockAlign
+        0x08, 0x00,             // BitsPerSample
+        0x64, 0x61, 0x74, 0x61, // Subchunk2ID = "data"
+        (unsigned char) (numSamples32),
+        (unsigned char) (numSamples32 >> 8),
+        (unsigned char) (numSamples32 >> 16),
+        (unsigned char) (numSamples32 >> 24)
+    };
+
+    return QByteArray((const char *) bytes, sizeof(bytes));
+}
+
+void AudioRenderer::process()
+{
+    if (mData.isEmpty())
+    {
+        emit finished(false);
+        return;
+    }
+
+    AudioSimulation simulation(mConfig, mData);
+
+    QFile file(mFileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        emit finished(false);
+        return;
+    }
+
+    const bool success = render(simulation, &file, &mCancel, this);
+
+    file.close();
+
+    emit finished(success);
+}
+
+bool AudioRenderer::render(
+        AudioSimulation &simulation,
+        QIODevice *device,
+        const QAtomicInt *cancel,
+        AudioRenderer *renderer)
+{
+    const qint64 numSamples = simulation.sampleCount();
+
+    const QByteArray wavHeader = header(numSamples);
+    if (device->write(wavHeader) != wavHeader.size()) return false;
+
+    QByteArray buffer(BLOCK_SIZE, 0);
+    char *block = buffer.data();
+
+    int percent = 0;
+
+    for (qint64 s = 0; s < numSamples; )
+    {
+        // Fill one block
+        const int n = qMin((qint64) BLOCK_SIZE, numSamples - s);
+        simulation.render(s, block, n);
+        s += n;
+
+        if (device->write(block, n) != n) return false;
+
+        if (cancel && cancel->loadAcquire()) return false;
+
+        // Report progress once per percent
+        const int newPercent = static_cast< int >(100 * s / numSamples);
+        if (renderer && newPercent != percent)
+        {
+            percent = newPercent;
+            emit renderer->progress(percent);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,46 @@
+#ifndef AUDIORENDERER_H
+#define AUDIORENDERER_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+#include "config.h"
+#include "mainwindow.h"
+
+class AudioSimulation;
+class QIODevice;
+
+/* Renders the FlySight audio for a track to a WAV file. Meant to run on a
+ * worker thread: samples are generated into a block buffer which is
+ * written in large chunks, progress is reported once per percent and
+ * cancel() may be called from any thread. */
+class AudioRenderer : public QObject
+{
+    Q_OBJECT
+public:
+    AudioRenderer(const Config &config, const MainWindow::DataPoints &data,
+                  const QString &fileName);
+
+    void cancel();
+
+    static QByteArray header(qint64 numSamples);
+    static bool render(AudioSimulation &simulation, QIODevice *device,
+                       const QAtomicInt *cancel = 0, AudioRenderer *renderer = 0);
+
+private:
+    Config                  mConfig;
+    MainWindow::DataPoints  mData;
+    QString                 mFileName;
+    QAtomicInt              mCancel;
+
+signals:
+    void progress(int percent);
+    void finished(bool success);
+
+public slots:
+    void process();
+};
+
+#endif // AUDIORENDERER_H
@@ -0,0 +1,226 @@
+#include "audiosimulation.h"
+
+#include <limits>
+
+#include "audiopool.h"
+
+#define CHUNK_SIZE        AUDIO_SAMPLE_RATE         // Samples per cached chunk
+#define CHECKPOINT_CHUNKS 5                         // Chunks between checkpoints
+#define MAX_CACHE_SIZE    (32 * 1024 * 1024)        // Cached samples
+
+// Simulation state at the start of a checkpoint interval
+class AudioCheckpoint
+{
+public:
+    AudioCheckpoint():
+        tone(config),
+        ubx(config, tone)
+    {
+
+    }
+
+    Config  config;
+    Tone    tone;
+    UBX     ubx;
+
+    qint64  sample;
+    int     nextIndex;
+    qint64  msNextSample;
+    qint64  msNextTick;
+};
+
+AudioSimulation::AudioSimulation(
+        const Config &config,
+        const MainWindow::DataPoints &data):
+    mConfig(config),
+    mTone(mConfig),
+    mUbx(mConfig, mTone),
+    mData(data),
+    mSampleCount(0),
+    mSample(0),
+    mNextIndex(0),
+    mMsNextSample(0),
+    mMsNextTick(0),
+    mToneLog(0),
+    mMsLogged(-1),
+    mChunks(MAX_CACHE_SIZE)
+{
+    // Preload speech prompts
+    if (!mConfig.mAudioPool)
+    {
+        mConfig.mAudioPool = AudioPool::load(mConfig.mAudioFolder);
+    }
+
+    if (!mData.isEmpty())
+    {
+        const DataPoint &dpStart = mData.first();
+        const DataPoint &dpEnd = mData.last();
+        mSampleCount = msecToSample(dpStart.dateTime.msecsTo(dpEnd.dateTime));
+    }
+}
+
+AudioSimulation::~AudioSimulation()
+{
+    qDeleteAll(mCheckpoints);
+}
+
+int AudioSimulation::chunkSize()
+{
+    return CHUNK_SIZE;
+}
+
+int AudioSimulation::chunkCount() const
+{
+    return (mSampleCount + CHUNK_SIZE - 1) / CHUNK_SIZE;
+}
+
+void AudioSimulation::render(
+        qint64 sample,
+        char *data,
+        qint64 count)
+{
+    seek(sample);
+    step(data, count);
+}
+
+QByteArray AudioSimulation::chunk(
+        int index)
+{
+    if (QByteArray *cached = mChunks.object(index))
+    {
+        return *cached;
+    }
+
+    const qint64 start = (qint64) index * CHUNK_SIZE;
+    const qint64 count = qMin((qint64) CHUNK_SIZE, mSampleCount - start);
+    if (count <= 0) return QByteArray();
+
+    QByteArray *data = new QByteArray(count, 0);
+    render(start, data->data(), count);
+
+    const QByteArray result = *data;
+    mChunks.insert(index, data, count);
+
+    return result;
+}
+
+void AudioSimulation::seek(
+        qint64 sample)
+{
+    if (sample == mSample) return;
+
+    const int index = qMin(sample / (CHUNK_SIZE * CHECKPOINT_CHUNKS),
+                           (qint64) mCheckpoints.size() - 1);
+
+    // Replay from the nearest checkpoint unless we're already closer
+    if (index >= 0 && (sample < mSample || mSample < mCheckpoints[index]->sample))
+    {
+        restoreCheckpoint(index);
+    }
+
+    step(0, sample - mSample);
+}
+
+void AudioSimulation::step(
+        char *data,
+        qint64 count)
+{
+    if (mData.isEmpty()) return;
+
+    const DataPoint &dpStart = mData.first();
+    const qint64 end = qMin(mSample + count, mSampleCount);
+
+    for (; mSample < end; ++mSample)
+    {
+        // Save state on first pass through each interval
+        if (mSample % (CHUNK_SIZE * CHECKPOINT_CHUNKS) == 0
+                && mSample / (CHUNK_SIZE * CHECKPOINT_CHUNKS) == mCheckpoints.size())
+        {
+            saveCheckpoint();
+        }
+
+        const qint64 ms = sampleToMsec(mSample);
+
+        const uint8_t sample = mTone.sample();
+        if (data) *data++ = sample;
+
+        if (ms >= mMsNextSample)
+        {
+            mUbx.receiveMessage(mData[mNextIndex]);
+
+            if (++mNextIndex < mData.size())
+            {
+                mMsNextSample = dpStart.dateTime.msecsTo(mData[mNextIndex].dateTime);
+            }
+            else
+            {
+                mMsNextSample = std::numeric_limits< qint64 >::max();
+            }
+        }
+
+        if (ms >= mMsNextTick)
+        {
+            mTone.update();
+
+            mUbx.task();
+            mTone.task();
+
+            if (mToneLog) logTone(mMsNextTick);
+
+            ++mMsNextTick;
+        }
+    }
+}
+
+void AudioSimulation::logTone(
+        qint64 ms)
+{
+    // Ticks replayed after a seek have already been logged
+    if (ms <= mMsLogged) return;
+    mMsLogged = ms;
+
+    if (!mToneLog->isEmpty()
+            && mToneLog->last().rate == mTone.rate()
+            && mToneLog->last().pitch == mTone.pitch())
+    {
+        return;
+    }
+
+    ToneEvent event;
+    event.ms = ms;
+    event.rate = mTone.rate();
+    event.pitch = mTone.pitch();
+
+    mToneLog->append(event);
+}
+
+void AudioSimulation::saveCheckpoint()
+{
+    AudioCheckpoint *checkpoint = new AudioCheckpoint;
+
+    checkpoint->config = mConfig;
+    checkpoint->tone.copyState(mTone);
+    checkpoint->ubx.copyState(mUbx);
+
+    checkpoint->sample = mSample;
+    checkpoint->nextIndex = mNextIndex;
+    checkpoint->msNextSample = mMsNextSample;
+    checkpoint->msNextTick = mMsNextTick;
+
+    mCheckpoints.append(checkpoint);
+}
+
+void AudioSimulation::restoreCheckpoint(
+        int index)
+{
+    const AudioCheckpoint *checkpoint = mCheckpoints[index];
+
+    mConfig = checkpoint->config;
+    mTone.copyState(checkpoint->tone);
+    mUbx.copyState(checkpoint->ubx);
+
+    mSample = checkpoint->sample;
+    mNextIndex = checkpoint->nextIndex;
+    mMsNextSample = checkpoint->msNextSample;
+    mMsNextTick = checkpoint->msNextTick;
+}
@@ -0,0 +1,80 @@
+#ifndef AUDIOSIMULATION_H
+#define AUDIOSIMULATION_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QVector>
+
+#include "config.h"
+#include "mainwindow.h"
+#include "tone.h"
+#include "ubx.h"
+
+#define AUDIO_SAMPLE_RATE 31250     // Simulated sample rate (Hz)
+
+class AudioCheckpoint;
+
+/* Seekable simulation of the FlySight audio for a track. The UBX and Tone
+ * state is saved every few seconds of audio as the simulation passes, so
+ * any position can be reached by replaying from the nearest checkpoint.
+ * Rendered chunks are cached for playback. */
+class AudioSimulation
+{
+public:
+    AudioSimulation(const Config &config, const MainWindow::DataPoints &data);
+    ~AudioSimulation();
+
+    // Change in tone rate or pitch
+    typedef struct {
+        qint64   ms;
+        uint16_t rate;
+        uint16_t pitch;
+    } ToneEvent;
+
+    typedef QVector< ToneEvent > ToneEvents;
+
+    void setToneLog(ToneEvents *toneLog) { mToneLog = toneLog; }
+
+    const MainWindow::DataPoints &data() const { return mData; }
+    qint64 sampleCount() const { return mSampleCount; }
+
+    static qint64 sampleToMsec(qint64 sample) { return sample * 256 / 8000; }
+    static qint64 msecToSample(qint64 ms) { return ms * 8000 / 256; }
+
+    void render(qint64 sample, char *data, qint64 count);
+
+    int chunkCount() const;
+    QByteArray chunk(int index);
+
+    static int chunkSize();
+
+private:
+    Config                      mConfig;
+    Tone                        mTone;
+    UBX                         mUbx;
+
+    MainWindow::DataPoints      mData;
+
+    qint64                      mSampleCount;
+
+    qint64                      mSample;
+    int                         mNextIndex;
+    qint64                      mMsNextSample;
+    qint64                      mMsNextTick;
+
+    ToneEvents                 *mToneLog;
+    qint64                      mMsLogged;
+
+    QVector< AudioCheckpoint* > mCheckpoints;
+    QCache< int, QByteArray >   mChunks;
+
+    void seek(qint64 sample);
+    void step(char *data, qint64 count);
+
+    void logTone(qint64 ms);
+
+    void saveCheckpoint();
+    void restoreCheckpoint(int index);
+};
+
+#endif // AUDIOSIMULATION_H
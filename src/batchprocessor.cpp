@@ -0,0 +1,442 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "batchprocessor.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSettings>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include "columnwriter.h"
+#include "flarescoring.h"
+#include "mainwindow.h"
+#include "ppcscoring.h"
+#include "speedscoring.h"
+#include "tracksummary.h"
+
+// Processes one track for QtConcurrent::blockingMapped
+class BatchTask
+{
+public:
+    typedef QJsonObject result_type;
+
+    BatchTask(const BatchProcessor *processor,
+              const BatchProcessor::Options &options):
+        mProcessor(processor),
+        mOptions(options)
+    {
+
+    }
+
+    QJsonObject operator()(const QString &fileName) const;
+
+private:
+    const BatchProcessor         *mProcessor;
+    BatchProcessor::Options       mOptions;
+};
+
+QJsonObject BatchTask::operator()(
+        const QString &fileName) const
+{
+    QJsonObject result;
+
+    const QString relativePath = QDir(mProcessor->mInputPath).relativeFilePath(fileName);
+    result["file"] = relativePath;
+
+    QString error;
+    TrackUtil::DataPoints data;
+    if (!BatchProcessor::loadTrack(fileName, mOptions, data, error))
+    {
+        result["error"] = error;
+        return result;
+    }
+
+    result["summary"] = BatchProcessor::summarize(data);
+    result["scores"] = BatchProcessor::score(data, mOptions);
+
+    if (mProcessor->mOutputPath.isEmpty()) return result;
+
+    // Mirror the input tree in the output folder
+    QFileInfo info(QDir(mProcessor->mOutputPath).filePath(relativePath));
+    QDir().mkpath(info.absolutePath());
+
+    const QString baseName = info.absoluteDir().filePath(info.completeBaseName());
+    const double lower = data.first().t;
+    const double upper = data.last().t;
+
+    QJsonObject exports;
+
+    if (mProcessor->mExportCSV)
+    {
+        QFile file(baseName + ".csv");
+        if (file.open(QIODevice::WriteOnly)
+                && TrackUtil::exportToCSV(&file, data, lower, upper))
+        {
+            exports["csv"] = QDir(mProcessor->mOutputPath).relativeFilePath(file.fileName());
+        }
+        else
+        {
+            result["error"] = QString("Couldn't write %1").arg(file.fileName());
+        }
+    }
+
+    if (mProcessor->mExportKML)
+    {
+        QFile file(baseName + ".kml");
+        if (file.open(QIODevice::WriteOnly)
+                && TrackUtil::exportToKML(&file, info.completeBaseName(), data, lower, upper))
+        {
+            exports["kml"] = QDir(mProcessor->mOutputPath).relativeFilePath(file.fileName());
+        }
+        else
+        {
+            result["error"] = QString("Couldn't write %1").arg(file.fileName());
+        }
+    }
+
+    if (mProcessor->mColumnWriter
+            && !mProcessor->mColumnWriter->addTrack(mProcessor->mTrackIds.value(fileName),
+                                                    relativePath, data, lower, upper))
+    {
+        result["error"] = mProcessor->mColumnWriter->errorString();
+    }
+
+    result["exports"] = exports;
+
+    return result;
+}
+
+BatchProcessor::BatchProcessor():
+    mThreadCount(0),
+    mExportCSV(false),
+    mExportKML(false),
+    mExportColumns(false),
+    mWindAdjustment(false),
+    mColumnWriter(0)
+{
+
+}
+
+BatchProcessor::Options BatchProcessor::defaultOptions()
+{
+    Options options;
+
+    options.mass = 70;
+    options.planformArea = 2;
+    options.windE = 0;
+    options.windN = 0;
+    options.fixedGround = false;
+    options.fixedReference = 0;
+    options.windAdjustment = false;
+
+    // Use the same settings as the main window
+    QSettings settings("FlySight", "Viewer");
+
+    settings.beginGroup("mainWindow");
+        options.mass = settings.value("mass", options.mass).toDouble();
+        options.planformArea = settings.value("planformArea", options.planformArea).toDouble();
+        options.windE = settings.value("windE", options.windE).toDouble();
+        options.windN = settings.value("windN", options.windN).toDouble();
+        options.fixedGround = (settings.value("groundReference", MainWindow::Automatic).toInt() == MainWindow::Fixed);
+        options.fixedReference = settings.value("fixedReference", options.fixedReference).toDouble();
+    settings.endGroup();
+
+    return options;
+}
+
+bool BatchProcessor::loadTrack(
+        const QString &fileName,
+        const Options &options,
+        TrackUtil::DataPoints &data,
+        QString &error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        error = QString("Couldn't read file");
+        return false;
+    }
+
+    if (TrackUtil::import(&file, data) < 2)
+    {
+        error = QString("Not enough data");
+        return false;
+    }
+
+    derive(data, options);
+
+    return true;
+}
+
+void BatchProcessor::derive(
+        TrackUtil::DataPoints &data,
+        const Options &options)
+{
+    // Same steps as MainWindow::init, without the database
+    TrackUtil::initTime(data);
+
+    double ground = options.fixedGround ? options.fixedReference : data.last().hMSL;
+    TrackUtil::initAltitude(data, ground);
+
+    TrackUtil::initAcceleration(data);
+    TrackUtil::setExit(data, TrackUtil::findExit(data));
+
+    TrackUtil::updateVelocity(data, options.windE, options.windN, 0, options.windAdjustment);
+    TrackUtil::initAerodynamics(data, options.mass, options.planformArea);
+}
+
+QJsonObject BatchProcessor::summarize(
+        const TrackUtil::DataPoints &data)
+{
+    QJsonObject summary;
+
+    const DataPoint &dpFirst = data.first();
+    const DataPoint &dpLast = data.last();
+    const DataPoint dpExit = TrackUtil::interpolateDataT(data, 0);
+
+    const TrackSummary::Summary stats = TrackSummary::compute(data);
+
+    summary["samples"] = data.size();
+    summary["start_time"] = TrackUtil::dateTimeToUTC(dpFirst.dateTime);
+    summary["exit_time"] = TrackUtil::dateTimeToUTC(dpExit.dateTime);
+    summary["duration"] = dpLast.t - dpFirst.t;
+    summary["exit_altitude"] = stats.exitAltitude;
+    summary["max_altitude"] = stats.maxAltitude;
+    summary["deployment_altitude"] = stats.deploymentAltitude;
+    summary["freefall_time"] = stats.freefallTime;
+    summary["landing_time"] = stats.landingTime;
+    summary["distance_2d"] = stats.distance2D;
+    summary["distance_3d"] = stats.distance3D;
+    summary["max_horizontal_speed"] = stats.maxHorizontalSpeed;
+    summary["max_vertical_speed"] = stats.maxVerticalSpeed;
+    summary["max_total_speed"] = stats.maxTotalSpeed;
+    summary["mean_horizontal_speed"] = stats.meanHorizontalSpeed;
+    summary["mean_vertical_speed"] = stats.meanVerticalSpeed;
+    summary["glide_ratio_p10"] = stats.glideRatio10;
+    summary["glide_ratio_p50"] = stats.glideRatio50;
+    summary["glide_ratio_p90"] = stats.glideRatio90;
+    summary["lat"] = dpExit.lat;
+    summary["lon"] = dpExit.lon;
+
+    return summary;
+}
+
+QJsonObject BatchProcessor::score(
+        const TrackUtil::DataPoints &data,
+        const Options &options)
+{
+    QJsonObject scores;
+
+    // Scoring methods only use the main window for plotting, so none is
+    // needed to evaluate them here
+    PPCScoring ppc(0);
+    ppc.readSettings();
+
+    DataPoint dpBottom, dpTop;
+    if (ppc.getWindowBounds(data, dpBottom, dpTop))
+    {
+        const double time = dpBottom.t - dpTop.t;
+        const double distance = TrackUtil::getDistance(dpTop, dpBottom, options.windAdjustment);
+
+        QJsonObject result;
+        result["window_top"] = ppc.windowTop();
+        result["window_bottom"] = ppc.windowBottom();
+        result["time"] = time;
+        result["distance"] = distance;
+        result["speed"] = distance / time;
+        scores["ppc"] = result;
+    }
+
+    SpeedScoring speed(0);
+
+    const DataPoint dpExit = TrackUtil::performanceStart(data);
+    if (speed.getWindowBounds(data, dpBottom, dpTop, dpExit))
+    {
+        QJsonObject result;
+        result["speed"] = (dpTop.z - dpBottom.z) / (dpBottom.t - dpTop.t);
+
+        double accuracy;
+        if (speed.getAccuracy(data, accuracy, dpExit))
+        {
+            result["accuracy"] = accuracy;
+        }
+
+        scores["speed"] = result;
+    }
+
+    FlareScoring flare(0);
+
+    if (flare.getWindowBounds(data, dpBottom, dpTop))
+    {
+        QJsonObject result;
+        result["height"] = dpTop.hMSL - dpBottom.hMSL;
+        scores["flare"] = result;
+    }
+
+    return scores;
+}
+
+QStringList BatchProcessor::findTracks() const
+{
+    QStringList fileNames;
+
+    QFileInfo info(mInputPath);
+    if (info.isFile())
+    {
+        fileNames.append(info.absoluteFilePath());
+        return fileNames;
+    }
+
+    QDirIterator it(mInputPath, QStringList() << "*.csv" << "*.CSV",
+                    QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext())
+    {
+        fileNames.append(it.next());
+    }
+
+    // Sort files from oldest to newest
+    qSort(fileNames);
+
+    return fileNames;
+}
+
+int BatchProcessor::run()
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (!QFileInfo(mInputPath).exists())
+    {
+        err << QString("Input path %1 does not exist").arg(mInputPath) << endl;
+        return 1;
+    }
+
+    if (mExportColumns && mOutputPath.isEmpty())
+    {
+        err << QString("--columns requires an output folder (-o)") << endl;
+        return 1;
+    }
+
+    if (!mOutputPath.isEmpty() && !QDir().mkpath(mOutputPath))
+    {
+        err << QString("Couldn't create output folder %1").arg(mOutputPath) << endl;
+        return 1;
+    }
+
+    if (mThreadCount > 0)
+    {
+        QThreadPool::globalInstance()->setMaxThreadCount(mThreadCount);
+    }
+
+    Options options = defaultOptions();
+    options.windAdjustment = mWindAdjustment;
+
+    const QStringList fileNames = findTracks();
+
+    // Collect every track in one dataset, identified by its order here
+    ColumnWriter columnWriter;
+    const QString columnFile = QDir(mOutputPath).filePath("tracks.fsc");
+
+    if (mExportColumns)
+    {
+        if (!columnWriter.open(columnFile))
+        {
+            err << columnWriter.errorString() << endl;
+            return 1;
+        }
+
+        for (int i = 0; i < fileNames.size(); ++i)
+        {
+            mTrackIds.insert(fileNames[i], i);
+        }
+
+        mColumnWriter = &columnWriter;
+    }
+
+    // Process tracks in parallel
+    QList< QJsonObject > results =
+            QtConcurrent::blockingMapped< QList< QJsonObject > >(
+                fileNames, BatchTask(this, options));
+
+    if (mColumnWriter)
+    {
+        mColumnWriter = 0;
+
+        if (!columnWriter.close())
+        {
+            err << columnWriter.errorString() << endl;
+            return 1;
+        }
+    }
+
+    QJsonArray tracks;
+    int failed = 0;
+
+    foreach (const QJsonObject &result, results)
+    {
+        if (result.contains("error")) ++failed;
+        tracks.append(result);
+    }
+
+    QJsonObject report;
+    report["input"] = QFileInfo(mInputPath).absoluteFilePath();
+    report["generated"] = TrackUtil::dateTimeToUTC(QDateTime::currentDateTimeUtc());
+    report["processed"] = results.size();
+    report["failed"] = failed;
+    report["tracks"] = tracks;
+
+    if (mExportColumns)
+    {
+        report["columns"] = QDir(mOutputPath).relativeFilePath(columnFile);
+    }
+
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (mOutputPath.isEmpty())
+    {
+        out << json;
+    }
+    else
+    {
+        QFile file(QDir(mOutputPath).filePath("report.json"));
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            err << QString("Couldn't write %1").arg(file.fileName()) << endl;
+            return 1;
+        }
+
+        file.write(json);
+
+        out << QString("Processed %1 tracks (%2 failed)").arg(results.size()).arg(failed) << endl;
+    }
+
+    return (failed > 0) ? 2 : 0;
+}
@@ -0,0 +1,91 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "trackutil.h"
+
+class ColumnWriter;
+
+/* Headless processing of a directory tree of FlySight logs. Each track is
+ * imported, derived and scored in parallel, optionally exported as CSV and
+ * KML or collected in one columnar dataset, and summarized in a JSON
+ * report. */
+class BatchProcessor
+{
+public:
+    BatchProcessor();
+
+    void setInputPath(const QString &inputPath) { mInputPath = inputPath; }
+    void setOutputPath(const QString &outputPath) { mOutputPath = outputPath; }
+    void setThreadCount(int threadCount) { mThreadCount = threadCount; }
+    void setExportCSV(bool exportCSV) { mExportCSV = exportCSV; }
+    void setExportKML(bool exportKML) { mExportKML = exportKML; }
+    void setExportColumns(bool exportColumns) { mExportColumns = exportColumns; }
+    void setWindAdjustment(bool windAdjustment) { mWindAdjustment = windAdjustment; }
+
+    int run();
+
+    // Track processing shared with other headless front ends
+    typedef struct {
+        double mass;
+        double planformArea;
+        double windE, windN;
+        bool   fixedGround;
+        double fixedReference;
+        bool   windAdjustment;
+    } Options;
+
+    static Options defaultOptions();
+    static bool loadTrack(const QString &fileName, const Options &options,
+                          TrackUtil::DataPoints &data, QString &error);
+    static void derive(TrackUtil::DataPoints &data, const Options &options);
+    static QJsonObject summarize(const TrackUtil::DataPoints &data);
+    static QJsonObject score(const TrackUtil::DataPoints &data,
+                             const Options &options);
+
+private:
+    QString mInputPath;
+    QString mOutputPath;
+    int     mThreadCount;
+    bool    mExportCSV;
+    bool    mExportKML;
+    bool    mExportColumns;
+    bool    mWindAdjustment;
+
+    ColumnWriter         *mColumnWriter;
+    QHash< QString, int > mTrackIds;
+
+    QStringList findTracks() const;
+
+    friend class BatchTask;
+};
+
+#endif // BATCHPROCESSOR_H
@@ -0,0 +1,392 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "columnwriter.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QTemporaryFile>
+#include <QtEndian>
+
+#include <string.h>
+
+#define COLUMN_MAGIC        "FSCOLS\0\1"
+#define COLUMN_ALIGNMENT    64          // Alignment of header and columns
+#define COPY_SIZE           (1 << 20)   // Chunk size when assembling
+
+typedef enum {
+    Int32 = 0,
+    Int64,
+    Float64
+} ColumnType;
+
+typedef struct {
+    const char         *name;
+    const char         *unit;
+    ColumnType          type;
+    double DataPoint::*member;
+} ColumnInfo;
+
+// Columns other than DataPoint doubles are filled in by index
+enum {
+    TrackId = 0,
+    Time,
+    NumSV = 13
+};
+
+static const ColumnInfo columnInfo[] = {
+    { "track_id", "",       Int32,   0                   },
+    { "time",     "ms",     Int64,   0                   },
+    { "lat",      "deg",    Float64, &DataPoint::lat     },
+    { "lon",      "deg",    Float64, &DataPoint::lon     },
+    { "hMSL",     "m",      Float64, &DataPoint::hMSL    },
+    { "velN",     "m/s",    Float64, &DataPoint::velN    },
+    { "velE",     "m/s",    Float64, &DataPoint::velE    },
+    { "velD",     "m/s",    Float64, &DataPoint::velD    },
+    { "hAcc",     "m",      Float64, &DataPoint::hAcc    },
+    { "vAcc",     "m",      Float64, &DataPoint::vAcc    },
+    { "sAcc",     "m/s",    Float64, &DataPoint::sAcc    },
+    { "heading",  "deg",    Float64, &DataPoint::heading },
+    { "cAcc",     "deg",    Float64, &DataPoint::cAcc    },
+    { "numSV",    "",       Int32,   0                   },
+    { "t",        "s",      Float64, &DataPoint::t       },
+    { "x",        "m",      Float64, &DataPoint::x       },
+    { "y",        "m",      Float64, &DataPoint::y       },
+    { "z",        "m",      Float64, &DataPoint::z       },
+    { "dist2D",   "m",      Float64, &DataPoint::dist2D  },
+    { "dist3D",   "m",      Float64, &DataPoint::dist3D  },
+    { "curv",     "deg/s",  Float64, &DataPoint::curv    },
+    { "accel",    "m/s^2",  Float64, &DataPoint::accel   },
+    { "ax",       "m/s^2",  Float64, &DataPoint::ax      },
+    { "ay",       "m/s^2",  Float64, &DataPoint::ay      },
+    { "az",       "m/s^2",  Float64, &DataPoint::az      },
+    { "amag",     "m/s^2",  Float64, &DataPoint::amag    },
+    { "lift",     "",       Float64, &DataPoint::lift    },
+    { "drag",     "",       Float64, &DataPoint::drag    },
+    { "vx",       "m/s",    Float64, &DataPoint::vx      },
+    { "vy",       "m/s",    Float64, &DataPoint::vy      },
+    { "theta",    "deg",    Float64, &DataPoint::theta   },
+    { "omega",    "deg/s",  Float64, &DataPoint::omega   }
+};
+
+static const int columnCount = sizeof(columnInfo) / sizeof(columnInfo[0]);
+
+static int typeSize(
+        ColumnType type)
+{
+    return (type == Int32) ? 4 : 8;
+}
+
+static const char *typeName(
+        ColumnType type)
+{
+    switch (type)
+    {
+    case Int32: return "<i4";
+    case Int64: return "<i8";
+    default:    return "<f8";
+    }
+}
+
+static qint64 align(
+        qint64 offset)
+{
+    return (offset + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+}
+
+static QByteArray encodeColumn(
+        int column,
+        int trackId,
+        const TrackUtil::DataPoints &data,
+        int start,
+        int end)
+{
+    const ColumnInfo &info = columnInfo[column];
+
+    QByteArray out((end - start) * typeSize(info.type), 0);
+    uchar *p = (uchar *) out.data();
+
+    for (int i = start; i < end; ++i)
+    {
+        const DataPoint &dp = data[i];
+
+        if (column == TrackId)
+        {
+            qToLittleEndian< qint32 >(trackId, p);
+            p += 4;
+        }
+        else if (column == Time)
+        {
+            qToLittleEndian< qint64 >(dp.dateTime.toMSecsSinceEpoch(), p);
+            p += 8;
+        }
+        else if (column == NumSV)
+        {
+            qToLittleEndian< qint32 >(dp.numSV, p);
+            p += 4;
+        }
+        else
+        {
+            quint64 bits;
+            memcpy(&bits, &(dp.*info.member), sizeof(bits));
+            qToLittleEndian< quint64 >(bits, p);
+            p += 8;
+        }
+    }
+
+    return out;
+}
+
+ColumnWriter::ColumnWriter():
+    mRows(0),
+    mFailed(false)
+{
+
+}
+
+ColumnWriter::~ColumnWriter()
+{
+    clear();
+}
+
+void ColumnWriter::clear()
+{
+    qDeleteAll(mColumns);
+    mColumns.clear();
+    mTracks.clear();
+    mRows = 0;
+    mFailed = false;
+}
+
+bool ColumnWriter::open(
+        const QString &fileName)
+{
+    clear();
+
+    mFileName = fileName;
+    mErrorString.clear();
+
+    // One spool file per column
+    for (int i = 0; i < columnCount; ++i)
+    {
+        QTemporaryFile *file = new QTemporaryFile;
+        mColumns.append(file);
+
+        if (!file->open())
+        {
+            mErrorString = QString("Couldn't create temporary file");
+            clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ColumnWriter::addTrack(
+        int trackId,
+        const QString &name,
+        const TrackUtil::DataPoints &data,
+        double lower,
+        double upper)
+{
+    // Only points within the range
+    const int start = TrackUtil::findIndexBelowT(data, lower) + 1;
+    const int end = TrackUtil::findIndexAboveT(data, upper);
+
+    if (start >= end) return true;
+
+    // Encode outside the lock so tracks can be prepared in parallel
+    QList< QByteArray > columns;
+    for (int i = 0; i < columnCount; ++i)
+    {
+        columns.append(encodeColumn(i, trackId, data, start, end));
+    }
+
+    QMutexLocker locker(&mMutex);
+
+    if (mColumns.isEmpty() || mFailed) return false;
+
+    for (int i = 0; i < columnCount; ++i)
+    {
+        if (mColumns[i]->write(columns[i]) != columns[i].size())
+        {
+            // Earlier columns already hold this track, so the spool files
+            // no longer line up
+            mErrorString = QString("Couldn't write temporary file");
+            mFailed = true;
+            return false;
+        }
+    }
+
+    Track track;
+    track.id = trackId;
+    track.name = name;
+    track.firstRow = mRows;
+    track.rows = end - start;
+
+    mTracks.append(track);
+    mRows += track.rows;
+
+    return true;
+}
+
+bool ColumnWriter::close()
+{
+    QMutexLocker locker(&mMutex);
+
+    if (mColumns.isEmpty()) return false;
+
+    if (mFailed)
+    {
+        locker.unlock();
+        clear();
+        return false;
+    }
+
+    // Every column must hold one value per row
+    for (int i = 0; i < columnCount; ++i)
+    {
+        if (mColumns[i]->size() != mRows * typeSize(columnInfo[i].type))
+        {
+            mErrorString = QString("Column %1 has the wrong length").arg(columnInfo[i].name);
+            locker.unlock();
+            clear();
+            return false;
+        }
+    }
+
+    // Header without offsets, to find where the columns start
+    QJsonArray tracks;
+    foreach (const Track &track, mTracks)
+    {
+        QJsonObject object;
+        object["id"] = track.id;
+        object["name"] = track.name;
+        object["first_row"] = track.firstRow;
+        object["rows"] = track.rows;
+        tracks.append(object);
+    }
+
+    QJsonObject header;
+    header["format"] = QString("flysight-columns");
+    header["version"] = 1;
+    header["byte_order"] = QString("little");
+    header["rows"] = mRows;
+    header["tracks"] = tracks;
+
+    // Reserve room for the largest offsets so the header size is final
+    QJsonArray columns;
+    for (int i = 0; i < columnCount; ++i)
+    {
+        QJsonObject object;
+        object["name"] = QString(columnInfo[i].name);
+        object["unit"] = QString(columnInfo[i].unit);
+        object["dtype"] = QString(typeName(columnInfo[i].type));
+        object["offset"] = 999999999999999.;
+        columns.append(object);
+    }
+    header["columns"] = columns;
+
+    const qint64 dataStart = align(16 + QJsonDocument(header).toJson(QJsonDocument::Compact).size());
+
+    // Actual offsets
+    qint64 offset = dataStart;
+    for (int i = 0; i < columnCount; ++i)
+    {
+        QJsonObject object = columns[i].toObject();
+        object["offset"] = offset;
+        columns[i] = object;
+
+        offset = align(offset + mRows * typeSize(columnInfo[i].type));
+    }
+    header["columns"] = columns;
+
+    QByteArray json = QJsonDocument(header).toJson(QJsonDocument::Compact);
+    if (16 + json.size() > dataStart)
+    {
+        mErrorString = QString("Header too large");
+        return false;
+    }
+
+    json.append(QByteArray(dataStart - 16 - json.size(), ' '));
+
+    QSaveFile file(mFileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        mErrorString = QString("Couldn't write %1").arg(mFileName);
+        return false;
+    }
+
+    uchar length[8];
+    qToLittleEndian< quint64 >(json.size(), length);
+
+    file.write(COLUMN_MAGIC, 8);
+    file.write((const char *) length, 8);
+    file.write(json);
+
+    // Copy each column from its spool file
+    QByteArray buffer;
+    for (int i = 0; i < columnCount; ++i)
+    {
+        QTemporaryFile *column = mColumns[i];
+        column->seek(0);
+
+        while (!column->atEnd())
+        {
+            buffer = column->read(COPY_SIZE);
+            file.write(buffer);
+        }
+
+        const qint64 padding = align(file.pos()) - file.pos();
+        file.write(QByteArray(padding, 0));
+    }
+
+    locker.unlock();
+    clear();
+
+    if (!file.commit())
+    {
+        mErrorString = QString("Couldn't write %1").arg(mFileName);
+        return false;
+    }
+
+    return true;
+}
+
+bool ColumnWriter::exportTrack(
+        const QString &fileName,
+        const QString &name,
+        const TrackUtil::DataPoints &data,
+        double lower,
+        double upper)
+{
+    ColumnWriter writer;
+    return writer.open(fileName)
+            && writer.addTrack(0, name, data, lower, upper)
+            && writer.close();
+}
@@ -0,0 +1,86 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef COLUMNWRITER_H
+#define COLUMNWRITER_H
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+#include "trackutil.h"
+
+class QTemporaryFile;
+
+/* Writes tracks to a columnar binary dataset for analysis outside the
+ * viewer. The file starts with an 8 byte magic ("FSCOLS" 0 1), the length
+ * of a JSON header as a little-endian uint64, and the header itself. The
+ * header lists the rows, the tracks and, for each column, its name, unit,
+ * numpy dtype and file offset. Columns are stored one after another as
+ * little-endian arrays aligned to 64 bytes, so in Python
+ *
+ *     np.memmap(path, dtype=col["dtype"], mode="r",
+ *               offset=col["offset"], shape=(header["rows"],))
+ *
+ * maps a column without parsing. Every DataPoint field is written along
+ * with a track_id column; each track's rows are contiguous. Tracks may be
+ * added from several threads. Columns are spooled to temporary files until
+ * close(), so large batches aren't held in memory. After the first error
+ * the writer refuses further tracks and close() fails. */
+class ColumnWriter
+{
+public:
+    ColumnWriter();
+    ~ColumnWriter();
+
+    bool open(const QString &fileName);
+    bool addTrack(int trackId, const QString &name, const TrackUtil::DataPoints &data,
+                  double lower, double upper);
+    bool close();
+
+    QString errorString() const { return mErrorString; }
+
+    static bool exportTrack(const QString &fileName, const QString &name,
+                            const TrackUtil::DataPoints &data, double lower, double upper);
+
+private:
+    typedef struct {
+        int     id;
+        QString name;
+        qint64  firstRow;
+        qint64  rows;
+    } Track;
+
+    QString                     mFileName;
+    QList< QTemporaryFile * >   mColumns;
+    QList< Track >              mTracks;
+    qint64                      mRows;
+    bool                        mFailed;
+
+    QMutex                      mMutex;
+    QString                     mErrorString;
+
+    void clear();
+};
+
+#endif // COLUMNWRITER_H
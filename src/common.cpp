@@ -25,6 +25,11 @@
 
 #include <QVector2D>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
 double distSqrToLine(
         const QPointF &start,
         const QPointF &end,
@@ -61,3 +66,49 @@ double distSqrToLine(
         return (a - p).lengthSquared();
     }
 }
+
+void projectPoints(
+        const double *x,
+        const double *y,
+        const double *z,
+        int count,
+        const QVector3D &axisX,
+        const QVector3D &axisY,
+        double *px,
+        double *py)
+{
+    const double ax = axisX.x(), ay = axisX.y(), az = axisX.z();
+    const double bx = axisY.x(), by = axisY.y(), bz = axisY.z();
+
+    int i = 0;
+
+#ifdef USE_SSE2
+    // Two points per iteration
+    const __m128d vax = _mm_set1_pd(ax), vay = _mm_set1_pd(ay), vaz = _mm_set1_pd(az);
+    const __m128d vbx = _mm_set1_pd(bx), vby = _mm_set1_pd(by), vbz = _mm_set1_pd(bz);
+
+    for (; i + 2 <= count; i += 2)
+    {
+        const __m128d vx = _mm_loadu_pd(x + i);
+        const __m128d vy = _mm_loadu_pd(y + i);
+        const __m128d vz = _mm_loadu_pd(z + i);
+
+        __m128d u = _mm_mul_pd(vx, vax);
+        u = _mm_add_pd(u, _mm_mul_pd(vy, vay));
+        u = _mm_add_pd(u, _mm_mul_pd(vz, vaz));
+
+        __m128d v = _mm_mul_pd(vx, vbx);
+        v = _mm_add_pd(v, _mm_mul_pd(vy, vby));
+        v = _mm_add_pd(v, _mm_mul_pd(vz, vbz));
+
+        _mm_storeu_pd(px + i, u);
+        _mm_storeu_pd(py + i, v);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        px[i] = x[i] * ax + y[i] * ay + z[i] * az;
+        py[i] = x[i] * bx + y[i] * by + z[i] * bz;
+    }
+}
@@ -25,6 +25,7 @@
 #define COMMON_H
 
 #include <QPointF>
+#include <QVector3D>
 
 #define PI          3.14159265359
 #define SQRT_2      1.41421356237
@@ -46,4 +47,14 @@ double distSqrToLine(
         const QPointF &point,
         double &mu);
 
+void projectPoints(
+        const double *x,
+        const double *y,
+        const double *z,
+        int count,
+        const QVector3D &axisX,
+        const QVector3D &axisY,
+        double *px,
+        double *py);
+
 #endif // COMMON_H
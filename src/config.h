@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #include <QList>
+#include <QSharedPointer>
 
 #define TONE_RATE_ONE_HZ 65
 
@@ -18,6 +19,8 @@
 #define UBX_UNITS_METERS 0
 #define UBX_UNITS_FEET   1
 
+class AudioPool;
+
 class Config
 {
 public:
@@ -98,6 +101,8 @@ public:
     QString   mAudioFolder;
     QString   mRootConfig;
     QString   mConfigFolder;
+
+    QSharedPointer< const AudioPool > mAudioPool;
 };
 
 #endif // CONFIGURATION_H
@@ -0,0 +1,104 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "cursormarkers.h"
+
+#include "QCustomPlot/qcustomplot.h"
+
+#include "datapoint.h"
+#include "mainwindow.h"
+
+// Track point at time t, optionally snapped to the nearest sample
+static DataPoint pointAt(
+        MainWindow *mainWindow,
+        double t,
+        bool nearestSample)
+{
+    if (!nearestSample) return mainWindow->interpolateDataT(t);
+
+    const int i1 = mainWindow->findIndexBelowT(t) + 1;
+    const int i2 = mainWindow->findIndexAboveT(t) - 1;
+
+    const DataPoint &dp1 = mainWindow->dataPoint(i1);
+    const DataPoint &dp2 = mainWindow->dataPoint(i2);
+
+    return (t - dp1.t < dp2.t - t) ? dp1 : dp2;
+}
+
+CursorMarkers::CursorMarkers()
+{
+
+}
+
+void CursorMarkers::forget()
+{
+    // Called once the plot has removed the graphs itself
+    mGraphs.clear();
+}
+
+void CursorMarkers::update(
+        QCustomPlot *plot,
+        MainWindow *mainWindow,
+        const Projection &projection,
+        bool nearestSample)
+{
+    foreach (QCPGraph *graph, mGraphs)
+    {
+        plot->removeGraph(graph);
+    }
+    mGraphs.clear();
+
+    if (mainWindow->dataSize() == 0) return;
+
+    if (mainWindow->mediaCursorRef() > 0)
+    {
+        const DataPoint dp = pointAt(mainWindow, mainWindow->mediaCursor(), nearestSample);
+        add(plot, projection.project(dp), Qt::darkGray, mainWindow->lineThickness());
+    }
+
+    if (mainWindow->markActive())
+    {
+        const DataPoint dp = pointAt(mainWindow, mainWindow->markEnd(), nearestSample);
+        add(plot, projection.project(dp), Qt::black, mainWindow->lineThickness());
+    }
+}
+
+void CursorMarkers::add(
+        QCustomPlot *plot,
+        const QPointF &point,
+        const QColor &color,
+        double lineThickness)
+{
+    QVector< double > xMark, yMark;
+
+    xMark.append(point.x());
+    yMark.append(point.y());
+
+    QCPGraph *graph = plot->addGraph();
+    graph->setData(xMark, yMark);
+    graph->setPen(QPen(color, lineThickness));
+    graph->setLineStyle(QCPGraph::lsNone);
+    graph->setScatterStyle(QCPScatterStyle::ssDisc);
+
+    mGraphs.append(graph);
+}
@@ -0,0 +1,62 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef CURSORMARKERS_H
+#define CURSORMARKERS_H
+
+#include <QList>
+#include <QPointF>
+
+class DataPoint;
+class MainWindow;
+class QCPGraph;
+class QColor;
+class QCustomPlot;
+
+/* Media cursor and mark drawn as single points on a plot. The graphs are
+ * kept so that a cursor move only replaces them, leaving the track and its
+ * segment index alone. Each view maps track points to its own axes. */
+class CursorMarkers
+{
+public:
+    class Projection
+    {
+    public:
+        virtual ~Projection() {}
+        virtual QPointF project(const DataPoint &dp) const = 0;
+    };
+
+    CursorMarkers();
+
+    void forget();
+    void update(QCustomPlot *plot, MainWindow *mainWindow,
+                const Projection &projection, bool nearestSample = false);
+
+private:
+    QList< QCPGraph * > mGraphs;
+
+    void add(QCustomPlot *plot, const QPointF &point, const QColor &color,
+             double lineThickness);
+};
+
+#endif // CURSORMARKERS_H
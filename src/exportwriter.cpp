@@ -0,0 +1,289 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "exportwriter.h"
+
+#include <QIODevice>
+
+#include <float.h>
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FIXED_DECIMALS  9       // Larger precisions go through printf
+#define MAX_NUMBER_LENGTH   64      // Longest formatted number
+#define MSECS_PER_DAY       86400000
+
+static const double powersOfTen[MAX_FIXED_DECIMALS + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+};
+
+// Use '.' whatever the C locale
+static void fixDecimalPoint(
+        char *text,
+        int length)
+{
+    const char point = *localeconv()->decimal_point;
+    if (point == '.') return;
+
+    for (int i = 0; i < length; ++i)
+    {
+        if (text[i] == point) text[i] = '.';
+    }
+}
+
+static char *writeDigits(
+        char *p,
+        int value,
+        int width)
+{
+    for (int i = width - 1; i >= 0; --i)
+    {
+        p[i] = '0' + value % 10;
+        value /= 10;
+    }
+    return p + width;
+}
+
+ExportWriter::ExportWriter(
+        QIODevice *device,
+        int bufferSize):
+    mDevice(device),
+    mBuffer(bufferSize, 0),
+    mSize(0),
+    mOk(true)
+{
+
+}
+
+ExportWriter::~ExportWriter()
+{
+    flush();
+}
+
+char *ExportWriter::reserve(
+        int size)
+{
+    if (mSize + size > mBuffer.size())
+    {
+        flush();
+    }
+
+    if (size > mBuffer.size())
+    {
+        mBuffer.resize(size);
+    }
+
+    return mBuffer.data() + mSize;
+}
+
+bool ExportWriter::flush()
+{
+    if (mSize > 0)
+    {
+        if (mDevice->write(mBuffer.constData(), mSize) != mSize)
+        {
+            mOk = false;
+        }
+        mSize = 0;
+    }
+
+    return mOk;
+}
+
+void ExportWriter::write(
+        char c)
+{
+    *reserve(1) = c;
+    ++mSize;
+}
+
+void ExportWriter::write(
+        const char *text)
+{
+    const int length = strlen(text);
+    memcpy(reserve(length), text, length);
+    mSize += length;
+}
+
+void ExportWriter::write(
+        const QString &text)
+{
+    const QByteArray utf8 = text.toUtf8();
+    memcpy(reserve(utf8.size()), utf8.constData(), utf8.size());
+    mSize += utf8.size();
+}
+
+bool ExportWriter::writeSpecial(
+        double value)
+{
+    if (qIsNaN(value))      write("nan");
+    else if (qIsInf(value)) write(value < 0 ? "-inf" : "inf");
+    else                    return false;
+
+    return true;
+}
+
+void ExportWriter::writeInt(
+        qint64 value)
+{
+    char *start = reserve(MAX_NUMBER_LENGTH);
+    char *p = start;
+
+    quint64 n = value;
+    if (value < 0)
+    {
+        *p++ = '-';
+        n = -(quint64) value;
+    }
+
+    char digits[24];
+    int count = 0;
+    do
+    {
+        digits[count++] = '0' + n % 10;
+        n /= 10;
+    }
+    while (n);
+
+    while (count > 0) *p++ = digits[--count];
+
+    mSize += p - start;
+}
+
+void ExportWriter::writeFixed(
+        double value,
+        int decimals)
+{
+    if (writeSpecial(value)) return;
+
+    const double scaled = fabs(value) * (decimals <= MAX_FIXED_DECIMALS ? powersOfTen[decimals] : 0);
+    char *start = reserve(MAX_NUMBER_LENGTH);
+
+    // Scaling rounds, so a product close to a half may round the other
+    // way from the exact value, e.g. 1.115 * 100 = 111.5 but 1.115 is
+    // stored as 1.11499999...
+    const double fraction = scaled - floor(scaled);
+    const bool nearHalf = fabs(fraction - 0.5) <= 4 * DBL_EPSILON * scaled;
+
+    if (decimals > MAX_FIXED_DECIMALS || scaled >= 9e18 || nearHalf)
+    {
+        // Too large for integer formatting, or needs exact rounding
+        const int length = snprintf(start, MAX_NUMBER_LENGTH, "%.*f", decimals, value);
+        if (length > 0 && length < MAX_NUMBER_LENGTH)
+        {
+            fixDecimalPoint(start, length);
+            mSize += length;
+        }
+        return;
+    }
+
+    char *p = start;
+    if (value < 0) *p++ = '-';
+
+    // Digits in reverse order, with at least one before the point
+    quint64 n = qRound64(scaled);
+
+    char digits[24];
+    int count = 0;
+    do
+    {
+        digits[count++] = '0' + n % 10;
+        n /= 10;
+    }
+    while (n || count <= decimals);
+
+    while (count > decimals) *p++ = digits[--count];
+
+    if (decimals > 0)
+    {
+        *p++ = '.';
+        while (count > 0) *p++ = digits[--count];
+    }
+
+    mSize += p - start;
+}
+
+void ExportWriter::writeNumber(
+        double value)
+{
+    if (writeSpecial(value)) return;
+
+    // Shortest of 15, 16 or 17 significant digits that reads back exactly
+    char *start = reserve(MAX_NUMBER_LENGTH);
+
+    int length = 0;
+    for (int precision = 15; precision <= 17; ++precision)
+    {
+        length = snprintf(start, MAX_NUMBER_LENGTH, "%.*g", precision, value);
+        if (strtod(start, 0) == value) break;
+    }
+
+    if (length > 0 && length < MAX_NUMBER_LENGTH)
+    {
+        fixDecimalPoint(start, length);
+        mSize += length;
+    }
+}
+
+void ExportWriter::writeDateTime(
+        const QDateTime &dt)
+{
+    qint64 ms = dt.toMSecsSinceEpoch();
+    qint64 days = ms / MSECS_PER_DAY;
+
+    ms %= MSECS_PER_DAY;
+    if (ms < 0)
+    {
+        ms += MSECS_PER_DAY;
+        --days;
+    }
+
+    // Civil date from days since 1970-01-01 (H. Hinnant)
+    days += 719468;
+    const qint64 era = (days >= 0 ? days : days - 146096) / 146097;
+    const qint64 doe = days - era * 146097;
+    const qint64 yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const qint64 doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const qint64 mp = (5 * doy + 2) / 153;
+
+    const int day = doy - (153 * mp + 2) / 5 + 1;
+    const int month = mp < 10 ? mp + 3 : mp - 9;
+    const int year = yoe + era * 400 + (month <= 2);
+
+    // Same format as TrackUtil::dateTimeToUTC
+    char *start = reserve(24);
+    char *p = start;
+
+    p = writeDigits(p, year, 4);            *p++ = '-';
+    p = writeDigits(p, month, 2);           *p++ = '-';
+    p = writeDigits(p, day, 2);             *p++ = 'T';
+    p = writeDigits(p, ms / 3600000, 2);    *p++ = ':';
+    p = writeDigits(p, ms / 60000 % 60, 2); *p++ = ':';
+    p = writeDigits(p, ms / 1000 % 60, 2);  *p++ = '.';
+    p = writeDigits(p, ms % 1000, 3);       *p++ = 'Z';
+
+    mSize += p - start;
+}
@@ -0,0 +1,65 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef EXPORTWRITER_H
+#define EXPORTWRITER_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QString>
+
+class QIODevice;
+
+/* Buffered text output for track and plot exports. Numbers and times are
+ * formatted straight into a large buffer without temporary strings, and
+ * the device is only written when the buffer fills, so exporting many
+ * tracks is limited by the disk rather than by formatting. */
+class ExportWriter
+{
+public:
+    explicit ExportWriter(QIODevice *device, int bufferSize = 1 << 20);
+    ~ExportWriter();
+
+    void write(char c);
+    void write(const char *text);
+    void write(const QString &text);
+
+    void writeInt(qint64 value);
+    void writeFixed(double value, int decimals);
+    void writeNumber(double value);
+    void writeDateTime(const QDateTime &dt);
+
+    bool flush();
+    bool ok() const { return mOk; }
+
+private:
+    QIODevice  *mDevice;
+    QByteArray  mBuffer;
+    int         mSize;
+    bool        mOk;
+
+    char *reserve(int size);
+    bool writeSpecial(double value);
+};
+
+#endif // EXPORTWRITER_H
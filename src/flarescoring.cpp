@@ -150,11 +150,18 @@ bool FlareScoring::getWindowBounds(
     double hBottom, hTop;
     DataPoint dpPrev;
 
-    for (int i = result.size() - 1; i >= 0; --i)
+    // Samples below the window only restart the search, so begin just
+    // after the last one above it
+    const TrackUtil::PhaseIndex *index = phaseIndex(mMainWindow, result);
+    const int end = index
+            ? qMin(TrackUtil::findIndexAboveZ(*index, mWindowBottom) + 1, result.size() - 1)
+            : result.size() - 1;
+
+    for (int i = end; i >= 0; --i)
     {
         const DataPoint &dp = result[i];
 
-        if ((i == result.size() - 1) || (dp.z < mWindowBottom))
+        if ((i == end) || (dp.z < mWindowBottom))
         {
             dpTop = dpBottom = dpPrev = dp;
         }
@@ -25,8 +25,13 @@
 
 #include "GeographicLib/Constants.hpp"
 #include "GeographicLib/Geodesic.hpp"
+#include "GeographicLib/GeodesicLine.hpp"
 #include "GeographicLib/Gnomonic.hpp"
 
+#include "mappath.h"
+
+#define MAX_SPLIT_DEPTH 8
+
 using namespace GeographicLib;
 
 // Compute the geodesic intercept from a point at (latb1, lonb1) to a geodesic
@@ -102,3 +107,87 @@ void GeographicUtil::intercept(
         lon0 = lon1;
     }
 }
+
+// Append points along the geodesic from (startLat, startLon) to (endLat,
+// endLon), excluding the end points, until the straight line between
+// consecutive points on the map is within threshold metres of the geodesic.
+
+void GeographicUtil::splitLine(
+        MapPath &data,
+        double startLat,
+        double startLon,
+        double endLat,
+        double endLon,
+        double threshold,
+        int depth)
+{
+    GeodesicLine l = Geodesic::WGS84().InverseLine(startLat, startLon, endLat, endLon);
+    double midLat, midLon;
+    l.Position(l.Distance() / 2, midLat, midLon);
+
+    double dist;
+    Geodesic::WGS84().Inverse((startLat + endLat) / 2, (startLon + endLon) / 2, midLat, midLon, dist);
+
+    if (dist > threshold && depth < MAX_SPLIT_DEPTH)
+    {
+        splitLine(data, startLat, startLon, midLat, midLon, threshold, depth + 1);
+
+        data.append(midLat, midLon);
+
+        splitLine(data, midLat, midLon, endLat, endLon, threshold, depth + 1);
+    }
+}
+
+// Return a closed outline of the given width around a lane centre line.
+
+MapPath GeographicUtil::laneOutline(
+        const MapPath &center,
+        double width)
+{
+    MapPath lt, rt;
+    for (int i = 0; i < center.size(); ++i)
+    {
+        double lat1 = center.lat(i);
+        double lon1 = center.lng(i);
+
+        double ltBearing, rtBearing;
+
+        if (i + 1 < center.size())
+        {
+            double lat2 = center.lat(i + 1);
+            double lon2 = center.lng(i + 1);
+
+            double azi1, azi2;
+            Geodesic::WGS84().Inverse(lat1, lon1, lat2, lon2, azi1, azi2);
+
+            ltBearing = azi1 + 90;
+            rtBearing = azi1 - 90;
+        }
+        else if (i - 1 >= 0)
+        {
+            double lat2 = center.lat(i - 1);
+            double lon2 = center.lng(i - 1);
+
+            double azi1, azi2;
+            Geodesic::WGS84().Inverse(lat2, lon2, lat1, lon1, azi1, azi2);
+
+            ltBearing = azi2 + 90;
+            rtBearing = azi2 - 90;
+        }
+        else
+        {
+            break;
+        }
+
+        double tempLat, tempLon;
+        Geodesic::WGS84().Direct(lat1, lon1, ltBearing, width / 2, tempLat, tempLon);
+        lt.append(tempLat, tempLon);
+
+        Geodesic::WGS84().Direct(lat1, lon1, rtBearing, width / 2, tempLat, tempLon);
+        rt.append(tempLat, tempLon);
+    }
+
+    // Now take lt + rt to form loop
+    lt.append(rt.reversed());
+    return lt;
+}
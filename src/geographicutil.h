@@ -24,10 +24,19 @@
 #ifndef GEOGRAPHICUTIL_H
 #define GEOGRAPHICUTIL_H
 
+class MapPath;
+
 namespace GeographicUtil
 {
     void intercept(double lata1, double lona1, double lata2, double lona2,
                    double latb1, double lonb1, double &lat0, double &lon0);
+
+    void splitLine(MapPath &data,
+                   double startLat, double startLon,
+                   double endLat, double endLon,
+                   double threshold, int depth = 0);
+
+    MapPath laneOutline(const MapPath &center, double width);
 }
 
 #endif // GEOGRAPHICUTIL_H
@@ -0,0 +1,122 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include <QDataStream>
+#include <QFileInfo>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTimer>
+
+#include "importserver.h"
+
+#define SERVER_NAME     "FlySight_Viewer_Import"
+#define FLUSH_INTERVAL  250     // Time to wait for more files (ms)
+#define TIMEOUT         5000    // Time to wait for a running instance (ms)
+
+ImportServer::ImportServer(QObject *parent) :
+    QObject(parent),
+    mServer(new QLocalServer(this)),
+    mTimer(new QTimer(this))
+{
+    mTimer->setSingleShot(true);
+    mTimer->setInterval(FLUSH_INTERVAL);
+
+    connect(mServer, SIGNAL(newConnection()), this, SLOT(acceptConnection()));
+    connect(mTimer, SIGNAL(timeout()), this, SLOT(flush()));
+
+    if (mServer->listen(SERVER_NAME)) return;
+
+    // Remove a socket left behind by an instance that crashed
+    QLocalSocket socket;
+    socket.connectToServer(SERVER_NAME);
+    if (!socket.waitForConnected(TIMEOUT))
+    {
+        QLocalServer::removeServer(SERVER_NAME);
+        mServer->listen(SERVER_NAME);
+    }
+}
+
+bool ImportServer::sendFiles(
+        const QStringList &fileNames)
+{
+    QLocalSocket socket;
+    socket.connectToServer(SERVER_NAME);
+    if (!socket.waitForConnected(TIMEOUT)) return false;
+
+    // Other instance may be running from a different folder
+    QStringList absoluteNames;
+    foreach (const QString &fileName, fileNames)
+    {
+        absoluteNames.append(QFileInfo(fileName).absoluteFilePath());
+    }
+
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out << absoluteNames;
+
+    socket.write(bytes);
+    if (!socket.waitForBytesWritten(TIMEOUT)) return false;
+
+    // Server closes the connection once the list has been read
+    socket.waitForDisconnected(TIMEOUT);
+    return true;
+}
+
+void ImportServer::acceptConnection()
+{
+    while (QLocalSocket *socket = mServer->nextPendingConnection())
+    {
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readFiles()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+}
+
+void ImportServer::readFiles()
+{
+    QLocalSocket *socket = qobject_cast< QLocalSocket* >(sender());
+    if (!socket) return;
+
+    // Wait until the whole list has arrived
+    QDataStream in(socket);
+    in.startTransaction();
+
+    QStringList fileNames;
+    in >> fileNames;
+
+    if (!in.commitTransaction()) return;
+
+    mFileNames.append(fileNames);
+    socket->disconnectFromServer();
+
+    mTimer->start();
+}
+
+void ImportServer::flush()
+{
+    if (mFileNames.isEmpty()) return;
+
+    QStringList fileNames = mFileNames;
+    mFileNames.clear();
+
+    emit importFiles(fileNames);
+}
@@ -1,7 +1,7 @@
 /***************************************************************************
 **                                                                        **
 **  FlySight Viewer                                                       **
-**  Copyright 2018 Michael Cooper                                         **
+**  Copyright 2020 Michael Cooper                                         **
 **                                                                        **
 **  This program is free software: you can redistribute it and/or modify  **
 **  it under the terms of the GNU General Public License as published by  **
@@ -21,35 +21,39 @@
 **  Website: http://flysight.ca/                                          **
 ****************************************************************************/
 
-#include <QProcess>
-#include <QSharedMemory>
-#include <QSystemSemaphore>
+#ifndef IMPORTSERVER_H
+#define IMPORTSERVER_H
 
-#include "importworker.h"
+#include <QObject>
+#include <QStringList>
 
-ImportWorker::ImportWorker()
-{
-    // Initialize here
-}
+class QLocalServer;
+class QTimer;
 
-void ImportWorker::process()
+/* Receives tracks from other instances of the viewer. Paths arriving close
+ * together, e.g. from one process per file when many are opened from a
+ * file manager, are collected into a single import. */
+class ImportServer : public QObject
 {
-    QSharedMemory shared("FlySight_Viewer_Import_Shared");
-    QSystemSemaphore free("FlySight_Viewer_Import_Free", 1, QSystemSemaphore::Open);
-    QSystemSemaphore used("FlySight_Viewer_Import_Used", 0, QSystemSemaphore::Open);
+    Q_OBJECT
+public:
+    explicit ImportServer(QObject *parent = 0);
+
+    // Hand files to a running instance, returning false if there is none
+    static bool sendFiles(const QStringList &fileNames);
 
-    shared.create(1000);
-    shared.attach();
+private:
+    QLocalServer *mServer;
+    QTimer       *mTimer;
+    QStringList   mFileNames;
 
-    while (1)
-    {
-        used.acquire();
+signals:
+    void importFiles(const QStringList &fileNames);
 
-        shared.lock();
-        QByteArray bytes((const char *) shared.constData(), shared.size());
-        emit importFile(QString::fromUtf8(bytes));
-        shared.unlock();
+private slots:
+    void acceptConnection();
+    void readFiles();
+    void flush();
+};
 
-        free.release();
-    }
-}
+#endif // IMPORTSERVER_H
@@ -0,0 +1,302 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "kmlwriter.h"
+
+#include <QBuffer>
+#include <QIODevice>
+#include <QtConcurrent>
+
+#include "exportwriter.h"
+#include "pathsimplifier.h"
+
+#define SPEED_STEP          10          // Speed range of each colour (m/s)
+#define SPEED_COLORS        8
+#define REGION_PADDING      0.0005      // Margin around track bounds (deg)
+
+// Geometry for each level of detail, coarsest first
+typedef struct {
+    double tolerance;       // Simplification tolerance (m)
+    int    minLodPixels;
+    int    maxLodPixels;
+} Tier;
+
+static const Tier tiers[] = {
+    { 20, 0,    256 },
+    { 4,  256,  1024 },
+    { 0,  1024, -1 }
+};
+
+static const int tierCount = sizeof(tiers) / sizeof(tiers[0]);
+
+// KML colours (aabbggrr) from slow to fast
+static const char *speedColors[SPEED_COLORS] = {
+    "ffff0000", "ffff8000", "ffffff00", "ff80ff00",
+    "ff00ff00", "ff00ffff", "ff0080ff", "ff0000ff"
+};
+
+// Processes one track for QtConcurrent::blockingMapped
+class KmlTrackTask
+{
+public:
+    typedef QByteArray result_type;
+
+    KmlTrackTask(bool speedColors):
+        mSpeedColors(speedColors)
+    {
+
+    }
+
+    QByteArray operator()(const KmlWriter::Track &track) const;
+
+private:
+    bool mSpeedColors;
+};
+
+static int speedBucket(
+        const DataPoint &dp1,
+        const DataPoint &dp2)
+{
+    const double speed = (DataPoint::totalSpeed(dp1) + DataPoint::totalSpeed(dp2)) / 2;
+    return qBound(0, (int) (speed / SPEED_STEP), SPEED_COLORS - 1);
+}
+
+static void writeLine(
+        ExportWriter &out,
+        const TrackUtil::DataPoints &data,
+        const QVector< int > &indices,
+        int first,
+        int last,
+        int bucket)
+{
+    out.write("        <Placemark>\n");
+
+    if (bucket >= 0)
+    {
+        out.write("          <styleUrl>#speed");
+        out.writeInt(bucket);
+        out.write("</styleUrl>\n");
+    }
+
+    out.write("          <LineString>\n");
+    out.write("            <altitudeMode>absolute</altitudeMode>\n");
+    out.write("            <coordinates>");
+
+    for (int k = first; k <= last; ++k)
+    {
+        const DataPoint &dp = data[indices[k]];
+
+        if (k > first) out.write(' ');
+
+        out.writeFixed(dp.lon, 7);      out.write(',');
+        out.writeFixed(dp.lat, 7);      out.write(',');
+        out.writeFixed(dp.hMSL, 3);
+    }
+
+    out.write("</coordinates>\n");
+    out.write("          </LineString>\n");
+    out.write("        </Placemark>\n");
+}
+
+QByteArray KmlTrackTask::operator()(
+        const KmlWriter::Track &track) const
+{
+    const TrackUtil::DataPoints &data = track.data;
+
+    // Only points within the range
+    const int start = TrackUtil::findIndexBelowT(data, track.lower) + 1;
+    const int end = TrackUtil::findIndexAboveT(data, track.upper);
+
+    if (end - start < 2) return QByteArray();
+
+    // Bounds for the regions
+    double north = data[start].lat, south = north;
+    double east = data[start].lon, west = east;
+
+    for (int i = start + 1; i < end; ++i)
+    {
+        const DataPoint &dp = data[i];
+
+        north = qMax(north, dp.lat);
+        south = qMin(south, dp.lat);
+        east = qMax(east, dp.lon);
+        west = qMin(west, dp.lon);
+    }
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    ExportWriter out(&buffer, 1 << 16);
+
+    out.write("    <Folder>\n");
+    out.write("      <name>");
+    out.write(track.name.toHtmlEscaped());
+    out.write("</name>\n");
+
+    // Build the simplification hierarchy once for all tiers
+    MapPath path;
+    QVector< double > heights;
+
+    path.reserve(end - start);
+    heights.reserve(end - start);
+
+    for (int i = start; i < end; ++i)
+    {
+        const DataPoint &dp = data[i];
+
+        path.append(dp.lat, dp.lon);
+        heights.append(dp.hMSL);
+    }
+
+    PathSimplifier simplifier;
+    simplifier.setPath(path, heights);
+
+    for (int tier = 0; tier < tierCount; ++tier)
+    {
+        QVector< int > indices;
+
+        if (tiers[tier].tolerance > 0)
+        {
+            indices = simplifier.indices(0, path.size() - 1, tiers[tier].tolerance);
+            for (int k = 0; k < indices.size(); ++k) indices[k] += start;
+        }
+        else
+        {
+            for (int i = start; i < end; ++i) indices.append(i);
+        }
+
+        out.write("      <Folder>\n");
+        out.write("        <Region>\n");
+        out.write("          <LatLonAltBox>\n");
+        out.write("            <north>");   out.writeFixed(north + REGION_PADDING, 7);  out.write("</north>\n");
+        out.write("            <south>");   out.writeFixed(south - REGION_PADDING, 7);  out.write("</south>\n");
+        out.write("            <east>");    out.writeFixed(east + REGION_PADDING, 7);   out.write("</east>\n");
+        out.write("            <west>");    out.writeFixed(west - REGION_PADDING, 7);   out.write("</west>\n");
+        out.write("          </LatLonAltBox>\n");
+        out.write("          <Lod>\n");
+        out.write("            <minLodPixels>");    out.writeInt(tiers[tier].minLodPixels);    out.write("</minLodPixels>\n");
+        out.write("            <maxLodPixels>");    out.writeInt(tiers[tier].maxLodPixels);    out.write("</maxLodPixels>\n");
+        out.write("          </Lod>\n");
+        out.write("        </Region>\n");
+
+        if (mSpeedColors)
+        {
+            // Join consecutive segments with the same colour
+            int first = 0;
+            int bucket = speedBucket(data[indices[0]], data[indices[1]]);
+
+            for (int k = 1; k < indices.size() - 1; ++k)
+            {
+                const int next = speedBucket(data[indices[k]], data[indices[k + 1]]);
+                if (next != bucket)
+                {
+                    writeLine(out, data, indices, first, k, bucket);
+                    first = k;
+                    bucket = next;
+                }
+            }
+
+            writeLine(out, data, indices, first, indices.size() - 1, bucket);
+        }
+        else
+        {
+            writeLine(out, data, indices, 0, indices.size() - 1, -1);
+        }
+
+        out.write("      </Folder>\n");
+    }
+
+    out.write("    </Folder>\n");
+    out.flush();
+
+    return buffer.data();
+}
+
+KmlWriter::KmlWriter():
+    mSpeedColors(false)
+{
+
+}
+
+void KmlWriter::addTrack(
+        const QString &name,
+        const TrackUtil::DataPoints &data,
+        double lower,
+        double upper)
+{
+    Track track;
+    track.name = name;
+    track.data = data;
+    track.lower = lower;
+    track.upper = upper;
+
+    mTracks.append(track);
+}
+
+bool KmlWriter::write(
+        QIODevice *device) const
+{
+    // Generate tracks in parallel
+    const QList< QByteArray > tracks =
+            QtConcurrent::blockingMapped< QList< QByteArray > >(
+                mTracks, KmlTrackTask(mSpeedColors));
+
+    ExportWriter out(device);
+
+    // Write headers
+    out.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    out.write("<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n");
+    out.write("  <Document>\n");
+    out.write("    <name>");
+    out.write(mName.toHtmlEscaped());
+    out.write("</name>\n");
+
+    if (mSpeedColors)
+    {
+        for (int i = 0; i < SPEED_COLORS; ++i)
+        {
+            out.write("    <Style id=\"speed");
+            out.writeInt(i);
+            out.write("\">\n");
+            out.write("      <LineStyle>\n");
+            out.write("        <color>");
+            out.write(speedColors[i]);
+            out.write("</color>\n");
+            out.write("        <width>2</width>\n");
+            out.write("      </LineStyle>\n");
+            out.write("    </Style>\n");
+        }
+    }
+
+    foreach (const QByteArray &track, tracks)
+    {
+        out.flush();
+        if (device->write(track) != track.size()) return false;
+    }
+
+    // Write footers
+    out.write("  </Document>\n");
+    out.write("</kml>\n");
+
+    return out.flush();
+}
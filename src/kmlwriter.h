@@ -0,0 +1,69 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef KMLWRITER_H
+#define KMLWRITER_H
+
+#include <QList>
+#include <QString>
+
+#include "trackutil.h"
+
+class QIODevice;
+
+/* Writes one or more tracks to KML for Google Earth. Each track gets a
+ * folder of progressively finer geometry, simplified with Douglas-Peucker
+ * and shown by Region level-of-detail as the track grows on screen, so
+ * only the coarse lines are drawn when many tracks are in view. Lines can
+ * optionally be split into segments coloured by total speed. Tracks are
+ * generated in parallel. */
+class KmlWriter
+{
+public:
+    KmlWriter();
+
+    void setName(const QString &name) { mName = name; }
+    void setSpeedColors(bool speedColors) { mSpeedColors = speedColors; }
+
+    void addTrack(const QString &name, const TrackUtil::DataPoints &data,
+                  double lower, double upper);
+    int trackCount() const { return mTracks.size(); }
+
+    bool write(QIODevice *device) const;
+
+private:
+    typedef struct {
+        QString               name;
+        TrackUtil::DataPoints data;
+        double                lower;
+        double                upper;
+    } Track;
+
+    QString         mName;
+    bool            mSpeedColors;
+    QList< Track >  mTracks;
+
+    friend class KmlTrackTask;
+};
+
+#endif // KMLWRITER_H
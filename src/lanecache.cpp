@@ -0,0 +1,71 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "lanecache.h"
+
+#include "geographicutil.h"
+#include "mappath.h"
+
+LaneCache::LaneCache():
+    mValid(false)
+{
+
+}
+
+void LaneCache::update(
+        double startLat,
+        double startLon,
+        double endLat,
+        double endLon,
+        double width,
+        double threshold)
+{
+    if (mValid
+            && startLat == mStartLat && startLon == mStartLon
+            && endLat == mEndLat && endLon == mEndLon
+            && width == mWidth && threshold == mThreshold)
+    {
+        return;
+    }
+
+    mStartLat = startLat;
+    mStartLon = startLon;
+    mEndLat = endLat;
+    mEndLon = endLon;
+    mWidth = width;
+    mThreshold = threshold;
+
+    // Lane centre
+    MapPath center;
+
+    center.append(startLat, startLon);
+    GeographicUtil::splitLine(center, startLat, startLon, endLat, endLon, threshold);
+    center.append(endLat, endLon);
+
+    mCenterLine = center.encode();
+
+    // Shading around lane
+    mOutline = GeographicUtil::laneOutline(center, width).encode();
+
+    mValid = true;
+}
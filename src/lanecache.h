@@ -1,7 +1,7 @@
 /***************************************************************************
 **                                                                        **
 **  FlySight Viewer                                                       **
-**  Copyright 2018 Michael Cooper                                         **
+**  Copyright 2020 Michael Cooper                                         **
 **                                                                        **
 **  This program is free software: you can redistribute it and/or modify  **
 **  it under the terms of the GNU General Public License as published by  **
@@ -21,22 +21,36 @@
 **  Website: http://flysight.ca/                                          **
 ****************************************************************************/
 
-#ifndef IMPORTWORKER_H
-#define IMPORTWORKER_H
+#ifndef LANECACHE_H
+#define LANECACHE_H
 
-#include <QObject>
+#include <QString>
 
-class ImportWorker : public QObject
+/* Encoded centre line and outline of a scoring lane. The geometry is only
+ * recomputed when the lane end points, width or map tolerance change. */
+class LaneCache
 {
-    Q_OBJECT
 public:
-    explicit ImportWorker();
+    LaneCache();
 
-signals:
-    void importFile(QString fileName);
+    void update(double startLat, double startLon,
+                double endLat, double endLon,
+                double width, double threshold);
+    void invalidate() { mValid = false; }
 
-public slots:
-    void process();
+    const QString &centerLine() const { return mCenterLine; }
+    const QString &outline() const { return mOutline; }
+
+private:
+    bool    mValid;
+
+    double  mStartLat, mStartLon;
+    double  mEndLat, mEndLon;
+    double  mWidth;
+    double  mThreshold;
+
+    QString mCenterLine;
+    QString mOutline;
 };
 
-#endif // IMPORTWORKER_H
+#endif // LANECACHE_H
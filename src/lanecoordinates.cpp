@@ -0,0 +1,184 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "lanecoordinates.h"
+
+#include <math.h>
+
+#include "GeographicLib/Geodesic.hpp"
+
+#include "geographicutil.h"
+
+#define MAX_ERROR 1.0   // Bound on along-lane error in plane (m)
+
+using namespace GeographicLib;
+
+LaneCoordinates::LaneCoordinates(
+        double startLat,
+        double startLon,
+        double endLat,
+        double endLon):
+    mStartLat(startLat),
+    mStartLon(startLon),
+    mEndLat(endLat),
+    mEndLon(endLon),
+    mLength(0),
+    mX0(0),
+    mY0(0),
+    mUx(0),
+    mUy(1),
+    mScale(1)
+{
+    const Geodesic &geod = Geodesic::WGS84();
+
+    // Centre plane on the lane midpoint
+    double azi1, azi2;
+    geod.Inverse(startLat, startLon, endLat, endLon, mLength, azi1, azi2);
+
+    double midLat, midLon;
+    geod.Direct(startLat, startLon, azi1, mLength / 2, midLat, midLon);
+
+    mPlane.Reset(midLat, midLon, 0);
+
+    // Project lane ends once
+    double x1, y1, z;
+    mPlane.Forward(startLat, startLon, 0, mX0, mY0, z);
+    mPlane.Forward(endLat, endLon, 0, x1, y1, z);
+
+    const double dx = x1 - mX0;
+    const double dy = y1 - mY0;
+    const double len = sqrt(dx * dx + dy * dy);
+
+    if (len > 0)
+    {
+        mUx = dx / len;
+        mUy = dy / len;
+        mScale = mLength / len;
+    }
+}
+
+void LaneCoordinates::project(
+        double lat,
+        double lon,
+        double &along,
+        double &across) const
+{
+    double x, y, z;
+    mPlane.Forward(lat, lon, 0, x, y, z);
+
+    x -= mX0;
+    y -= mY0;
+
+    along = (x * mUx + y * mUy) * mScale;
+    across = x * mUy - y * mUx;
+}
+
+void LaneCoordinates::project(
+        const TrackUtil::DataPoints &data,
+        int first,
+        int last,
+        QVector< double > &along) const
+{
+    along.resize(last - first);
+
+    for (int i = first; i < last; ++i)
+    {
+        const DataPoint &dp = data[i];
+
+        double x, y, z;
+        mPlane.Forward(dp.lat, dp.lon, 0, x, y, z);
+
+        along[i - first] = ((x - mX0) * mUx + (y - mY0) * mUy) * mScale;
+    }
+}
+
+// Exact signed distance along the lane from the start point to the
+// projection of (lat, lon) onto the lane geodesic
+
+double LaneCoordinates::distance(
+        double lat,
+        double lon) const
+{
+    // Get projected point
+    double lat0, lon0;
+    GeographicUtil::intercept(mStartLat, mStartLon, mEndLat, mEndLon, lat, lon, lat0, lon0);
+
+    // Distance from start
+    double startDist;
+    Geodesic::WGS84().Inverse(mStartLat, mStartLon, lat0, lon0, startDist);
+
+    // Distance from end
+    double endDist;
+    Geodesic::WGS84().Inverse(mEndLat, mEndLon, lat0, lon0, endDist);
+
+    if (startDist > endDist) return startDist;
+    else                     return mLength - endDist;
+}
+
+// Find the first sample after first where the track crosses the given
+// distance along the lane. Plane coordinates rule out pairs that are
+// clearly on one side, and only the remaining pairs are checked with exact
+// geodesics, so the result matches an exact scan.
+
+int LaneCoordinates::findCrossing(
+        const TrackUtil::DataPoints &data,
+        int first,
+        double along,
+        double &t) const
+{
+    first = qMax(0, first);
+    if (first + 1 >= data.size()) return -1;
+
+    QVector< double > approx;
+    project(data, first, data.size(), approx);
+
+    int iExact = -1;
+    double dExact = 0;
+
+    for (int i = first + 1; i < data.size(); ++i)
+    {
+        const double a1 = approx[i - 1 - first];
+        const double a2 = approx[i - first];
+
+        if (a1 >= along + MAX_ERROR) continue;
+        if (a2 < along - MAX_ERROR) continue;
+
+        const DataPoint &dp1 = data[i - 1];
+        const DataPoint &dp2 = data[i];
+
+        // Reuse the previous exact value where possible
+        const double d1 = (iExact == i - 1) ? dExact : distance(dp1.lat, dp1.lon);
+        const double d2 = distance(dp2.lat, dp2.lon);
+
+        iExact = i;
+        dExact = d2;
+
+        if (d1 < along && d2 >= along)
+        {
+            t = dp1.t + (dp2.t - dp1.t) / (d2 - d1) * (along - d1);
+            return i;
+        }
+    }
+
+    return -1;
+}
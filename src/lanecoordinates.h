@@ -0,0 +1,68 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef LANECOORDINATES_H
+#define LANECOORDINATES_H
+
+#include <QVector>
+
+#include "GeographicLib/LocalCartesian.hpp"
+
+#include "trackutil.h"
+
+/* Along-lane and cross-lane coordinates relative to a lane running from a
+ * start point to an end point. Track points are converted in a local plane
+ * tangent at the lane centre, which only needs a few trigonometric calls
+ * per point. The along-lane coordinate is scaled so the lane end is exactly
+ * at its geodesic length; away from the lane ends it may differ from the
+ * exact value by a few centimetres, which distance() resolves. */
+class LaneCoordinates
+{
+public:
+    LaneCoordinates(double startLat, double startLon,
+                    double endLat, double endLon);
+
+    double length() const { return mLength; }
+
+    void project(double lat, double lon, double &along, double &across) const;
+    void project(const TrackUtil::DataPoints &data, int first, int last,
+                 QVector< double > &along) const;
+
+    double distance(double lat, double lon) const;
+
+    int findCrossing(const TrackUtil::DataPoints &data, int first,
+                     double along, double &t) const;
+
+private:
+    double mStartLat, mStartLon;
+    double mEndLat, mEndLon;
+    double mLength;
+
+    GeographicLib::LocalCartesian mPlane;
+
+    double mX0, mY0;    // Start point in plane
+    double mUx, mUy;    // Unit vector along lane
+    double mScale;      // Metres per plane unit along lane
+};
+
+#endif // LANECOORDINATES_H
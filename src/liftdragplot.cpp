@@ -97,28 +97,34 @@ void LiftDragPlot::mouseMoveEvent(
     }
     else if (QCPCurve *graph = qobject_cast<QCPCurve *>(plottable(0)))
     {
-        QSharedPointer<QCPCurveDataContainer> data = graph->data();
-
-        double resultTime;
-        double resultDistance = std::numeric_limits<double>::max();
-
-        for (QCPCurveDataContainer::const_iterator it = data->constBegin();
-             it != data->constEnd();
-             ++it)
+        // Index the points the first time they are hovered
+        if (!mIndex.isBuilt())
         {
-            QVector2D pt = QVector2D(xAxis->coordToPixel(it->key),
-                                     yAxis->coordToPixel(it->value));
+            QSharedPointer<QCPCurveDataContainer> data = graph->data();
 
-            double dist = pt.distanceToPoint(QVector2D(event->pos()));
-
-            if (dist < resultDistance)
+            mIndex.clear();
+            for (QCPCurveDataContainer::const_iterator it = data->constBegin();
+                 it != data->constEnd();
+                 ++it)
             {
-                resultTime = it->t;
-                resultDistance = dist;
+                mIndex.addPoint(it->key, it->value, it->t);
+                mIndex.endPath();
             }
+            mIndex.build();
         }
 
-        if (resultDistance < selectionTolerance())
+        // Map from plot coordinates to pixels
+        const double x0 = xAxis->coordToPixel(0);
+        const double y0 = yAxis->coordToPixel(0);
+        const QTransform transform(xAxis->coordToPixel(1) - x0, 0,
+                                   0, yAxis->coordToPixel(1) - y0,
+                                   x0, y0);
+
+        double resultTime;
+        double resultDistance;
+
+        if (mIndex.findNearest(transform, event->pos(), selectionTolerance(),
+                               resultTime, resultDistance))
         {
             setMark(resultTime);
         }
@@ -159,6 +165,8 @@ void LiftDragPlot::setMark(
 void LiftDragPlot::updatePlot()
 {
     clearPlottables();
+    mCursors.forget();
+    mIndex.clear();
     clearItems();
 
     xAxis->setLabel(tr("Drag Coefficient"));
@@ -228,62 +236,6 @@ void LiftDragPlot::updatePlot()
     yMin = yAxis->range().lower;
     yMax = yAxis->range().upper;
 
-    if (mMainWindow->mediaCursorRef() > 0)
-    {
-        int i1 = mMainWindow->findIndexBelowT(mMainWindow->mediaCursor()) + 1;
-        int i2 = mMainWindow->findIndexAboveT(mMainWindow->mediaCursor()) - 1;
-
-        const DataPoint &dp1 = mMainWindow->dataPoint(i1);
-        const DataPoint &dp2 = mMainWindow->dataPoint(i2);
-
-        QVector< double > xMark, yMark;
-
-        if (mMainWindow->markEnd() - dp1.t < dp2.t - mMainWindow->markEnd())
-        {
-            xMark.append(dp1.drag);
-            yMark.append(dp1.lift);
-        }
-        else
-        {
-            xMark.append(dp2.drag);
-            yMark.append(dp2.lift);
-        }
-
-        QCPGraph *graph = addGraph();
-        graph->setData(xMark, yMark);
-        graph->setPen(QPen(Qt::darkGray, mMainWindow->lineThickness()));
-        graph->setLineStyle(QCPGraph::lsNone);
-        graph->setScatterStyle(QCPScatterStyle::ssDisc);
-    }
-
-    if (mMainWindow->markActive())
-    {
-        int i1 = mMainWindow->findIndexBelowT(mMainWindow->markEnd()) + 1;
-        int i2 = mMainWindow->findIndexAboveT(mMainWindow->markEnd()) - 1;
-
-        const DataPoint &dp1 = mMainWindow->dataPoint(i1);
-        const DataPoint &dp2 = mMainWindow->dataPoint(i2);
-
-        QVector< double > xMark, yMark;
-
-        if (mMainWindow->markEnd() - dp1.t < dp2.t - mMainWindow->markEnd())
-        {
-            xMark.append(dp1.drag);
-            yMark.append(dp1.lift);
-        }
-        else
-        {
-            xMark.append(dp2.drag);
-            yMark.append(dp2.lift);
-        }
-
-        QCPGraph *graph = addGraph();
-        graph->setData(xMark, yMark);
-        graph->setPen(QPen(Qt::black, mMainWindow->lineThickness()));
-        graph->setLineStyle(QCPGraph::lsNone);
-        graph->setScatterStyle(QCPScatterStyle::ssDisc);
-    }
-
     // x = ay^2 + c
     const double m = 1 / mMainWindow->maxLD();
     const double c = mMainWindow->minDrag();
@@ -381,6 +333,22 @@ void LiftDragPlot::updatePlot()
                     .arg(mMainWindow->maxLift())
                     .arg(1/ m));
 
+    mCursors.update(this, mMainWindow, *this, true);
+
+    replot();
+}
+
+QPointF LiftDragPlot::project(
+        const DataPoint &dp) const
+{
+    return QPointF(dp.drag, dp.lift);
+}
+
+void LiftDragPlot::updateCursor()
+{
+    // The track and its index are unchanged, so only move the markers
+    mCursors.update(this, mMainWindow, *this, true);
+
     replot();
 }
 
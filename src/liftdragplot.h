@@ -26,9 +26,12 @@
 
 #include "QCustomPlot/qcustomplot.h"
 
+#include "cursormarkers.h"
+#include "segmentindex.h"
+
 class MainWindow;
 
-class LiftDragPlot : public QCustomPlot
+class LiftDragPlot : public QCustomPlot, public CursorMarkers::Projection
 {
     Q_OBJECT
 
@@ -50,11 +53,16 @@ private:
     QPoint      mBeginPos;
     bool        mDragging;
 
+    SegmentIndex mIndex;
+    CursorMarkers mCursors;
+
     void setMark(double mark);
     void setViewRange(double xMax, double yMax);
+    QPointF project(const DataPoint &dp) const;
 
 public slots:
     void updatePlot();
+    void updateCursor();
 };
 
 #endif // LIFTDRAGPLOT_H
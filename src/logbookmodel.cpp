@@ -0,0 +1,444 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "logbookmodel.h"
+
+#include <QApplication>
+#include <QDateTime>
+#include <QMessageBox>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QStyle>
+
+#include <math.h>
+
+#include "common.h"
+#include "mainwindow.h"
+
+#define FETCH_SIZE 256      // Rows read at a time
+
+LogbookModel::LogbookModel(
+        QObject *parent):
+    QAbstractTableModel(parent),
+    mMainWindow(0),
+    mSortColumn(Id),
+    mSortOrder(Qt::AscendingOrder)
+{
+
+}
+
+QString LogbookModel::selectColumns()
+{
+    // Same order as Column, from Id onwards
+    return "files.id, files.file_name, files.description, files.start_time, "
+           "files.duration, files.sample_period, files.min_lat, files.max_lat, "
+           "files.min_lon, files.max_lon, files.import_time, files.exit, "
+           "files.ground, files.course, files.wind_e, files.wind_n, "
+           "files.t_min, files.t_max";
+}
+
+QString LogbookModel::sortExpression(
+        int column)
+{
+    switch (column)
+    {
+    case Id:            return "files.id";
+    case FileName:      return "files.file_name";
+    case Description:   return "lower(files.description)";
+    case StartTime:     return "files.start_time";
+    case Duration:      return "files.duration";
+    case SamplePeriod:  return "files.sample_period";
+    case MinLat:        return "files.min_lat";
+    case MaxLat:        return "files.max_lat";
+    case MinLon:        return "files.min_lon";
+    case MaxLon:        return "files.max_lon";
+    case ImportTime:    return "files.import_time";
+    case ExitTime:      return "files.exit";
+    case Ground:        return "files.ground";
+    case Course:        return "files.course";
+    case WindSpeed:     return "files.wind_e * files.wind_e + files.wind_n * files.wind_n";
+    case RangeLower:    return "files.t_min";
+    case RangeUpper:    return "files.t_max";
+    default:            return QString();
+    }
+}
+
+LogbookModel::Row LogbookModel::readRow(
+        const QSqlQuery &query)
+{
+    Row row(ColumnCount);
+
+    row[Id] = query.value(0).toInt();
+    row[FileName] = query.value(1).toString();
+    row[Description] = query.value(2).toString();
+    row[StartTime] = QDateTime::fromString(query.value(3).toString(), Qt::ISODate);
+    row[Duration] = query.value(4).toString().toLongLong();
+    row[SamplePeriod] = query.value(5).toString();
+    row[MinLat] = query.value(6).toString();
+    row[MaxLat] = query.value(7).toString();
+    row[MinLon] = query.value(8).toString();
+    row[MaxLon] = query.value(9).toString();
+    row[ImportTime] = QDateTime::fromString(query.value(10).toString(), Qt::ISODate);
+    row[ExitTime] = QDateTime::fromString(query.value(11).toString(), Qt::ISODate);
+    row[Ground] = query.value(12).toString().toDouble();
+    row[Course] = query.value(13).toString().toDouble();
+
+    const double windE = query.value(14).toString().toDouble();
+    const double windN = query.value(15).toString().toDouble();
+
+    double windDir = atan2(-windE, -windN) / PI * 180;
+    if (windDir < 0) windDir += 360;
+
+    row[WindSpeed] = sqrt(windE * windE + windN * windN);
+    row[WindDirection] = windDir;
+
+    row[RangeLower] = QDateTime::fromString(query.value(16).toString(), Qt::ISODate);
+    row[RangeUpper] = QDateTime::fromString(query.value(17).toString(), Qt::ISODate);
+
+    return row;
+}
+
+void LogbookModel::setFilter(
+        const QString &whereClause,
+        const QVariantList &values)
+{
+    mFilter = whereClause;
+    mFilterValues = values;
+    reload();
+}
+
+void LogbookModel::sort(
+        int column,
+        Qt::SortOrder order)
+{
+    // Columns computed in C++ can't be sorted by the database
+    if (sortExpression(column).isEmpty()) return;
+
+    mSortColumn = column;
+    mSortOrder = order;
+
+    reload();
+}
+
+void LogbookModel::reload()
+{
+    beginResetModel();
+
+    mIds.clear();
+    mRows.clear();
+    mRowIndex.clear();
+
+    QSqlQuery query(QSqlDatabase::database("flysight"));
+    query.setForwardOnly(true);
+
+    // Only ids and names are read here; rows are read by fetchMore
+    query.prepare(QString("select files.id, files.file_name from files "
+                          "left join track_state on track_state.file_name = files.file_name "
+                          "%1 order by %2 %3, files.id")
+                  .arg(mFilter)
+                  .arg(sortExpression(mSortColumn))
+                  .arg(mSortOrder == Qt::AscendingOrder ? "asc" : "desc"));
+
+    foreach (const QVariant &value, mFilterValues)
+    {
+        query.addBindValue(value);
+    }
+
+    if (query.exec())
+    {
+        while (query.next())
+        {
+            mRowIndex.insert(query.value(1).toString(), mIds.size());
+            mIds.append(query.value(0).toInt());
+        }
+    }
+    else
+    {
+        QSqlError err = query.lastError();
+        QMessageBox::critical(0, tr("Query failed"), err.text());
+    }
+
+    endResetModel();
+}
+
+bool LogbookModel::canFetchMore(
+        const QModelIndex &parent) const
+{
+    if (parent.isValid()) return false;
+    return mRows.size() < mIds.size();
+}
+
+void LogbookModel::fetchMore(
+        const QModelIndex &parent)
+{
+    if (parent.isValid()) return;
+
+    const int first = mRows.size();
+    const int last = qMin(first + FETCH_SIZE, mIds.size()) - 1;
+    if (last < first) return;
+
+    QStringList ids;
+    QHash< int, int > position;
+    for (int i = first; i <= last; ++i)
+    {
+        ids.append(QString::number(mIds[i]));
+        position.insert(mIds[i], i - first);
+    }
+
+    // Read the next block, keeping the sort order from reload
+    QVector< Row > rows(last - first + 1);
+
+    QSqlQuery query(QSqlDatabase::database("flysight"));
+    query.setForwardOnly(true);
+
+    if (query.exec(QString("select %1 from files where files.id in (%2)")
+                   .arg(selectColumns())
+                   .arg(ids.join(","))))
+    {
+        while (query.next())
+        {
+            rows[position.value(query.value(0).toInt())] = readRow(query);
+        }
+    }
+
+    beginInsertRows(QModelIndex(), first, last);
+
+    for (int i = 0; i < rows.size(); ++i)
+    {
+        // Rows deleted since reload are left blank
+        if (rows[i].isEmpty()) rows[i] = Row(ColumnCount);
+        mRows.append(rows[i]);
+    }
+
+    endInsertRows();
+}
+
+void LogbookModel::refreshTrack(
+        const QString &trackName)
+{
+    // Rows not read yet will be read when needed
+    const int row = mRowIndex.value(trackName, -1);
+    if (row < 0 || row >= mRows.size()) return;
+
+    QSqlQuery query(QSqlDatabase::database("flysight"));
+    query.prepare(QString("select %1 from files where files.file_name = ?").arg(selectColumns()));
+    query.addBindValue(trackName);
+
+    if (!query.exec() || !query.next())
+    {
+        return;
+    }
+
+    mRows[row] = readRow(query);
+
+    emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+}
+
+QString LogbookModel::fileName(
+        int row) const
+{
+    if (row < 0 || row >= mRows.size()) return QString();
+    return mRows[row][FileName].toString();
+}
+
+int LogbookModel::findRow(
+        const QString &trackName)
+{
+    const int row = mRowIndex.value(trackName, -1);
+    if (row < 0) return -1;
+
+    // Read rows up to the track
+    while (mRows.size() <= row && canFetchMore(QModelIndex()))
+    {
+        fetchMore(QModelIndex());
+    }
+
+    return (row < mRows.size()) ? row : -1;
+}
+
+int LogbookModel::rowCount(
+        const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : mRows.size();
+}
+
+int LogbookModel::columnCount(
+        const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant LogbookModel::data(
+        const QModelIndex &index,
+        int role) const
+{
+    if (!index.isValid() || index.row() >= mRows.size()) return QVariant();
+
+    const Row &row = mRows[index.row()];
+    const QVariant &value = row[index.column()];
+    const QString trackName = row[FileName].toString();
+
+    switch (index.column())
+    {
+    case Current:
+        if (role == Qt::DecorationRole && mMainWindow
+                && mMainWindow->trackName() == trackName)
+        {
+            return QApplication::style()->standardIcon(QStyle::SP_MediaPlay);
+        }
+        return QVariant();
+    case Checked:
+        if (role == Qt::CheckStateRole && mMainWindow)
+        {
+            return mMainWindow->trackChecked(trackName) ? Qt::Checked : Qt::Unchecked;
+        }
+        return QVariant();
+    default:
+        break;
+    }
+
+    // Edit the same text that is displayed
+    if (role != Qt::DisplayRole && role != Qt::EditRole) return QVariant();
+
+    switch (index.column())
+    {
+    case StartTime:
+    case ImportTime:
+    case ExitTime:
+    case RangeLower:
+    case RangeUpper:
+        return value.toDateTime().toLocalTime().toString("yyyy/MM/dd h:mm A");
+    case Duration:
+    {
+        const qint64 duration = value.toLongLong();
+        if (duration < 3600000)
+        {
+            return QString("%1:%2").arg(duration / 60000)
+                                   .arg((duration / 1000) % 60, 2, 10, QChar('0'));
+        }
+        return QString("%1:%2:%3").arg(duration / 3600000)
+                                  .arg((duration / 60000) % 60, 2, 10, QChar('0'))
+                                  .arg((duration / 1000) % 60, 2, 10, QChar('0'));
+    }
+    case Ground:
+        return QString::number(value.toDouble(), 'f', 3);
+    case Course:
+        return QString::number(value.toDouble(), 'f', 5);
+    case WindSpeed:
+        return QString::number(value.toDouble(), 'f', 2);
+    case WindDirection:
+        return QString::number(value.toDouble(), 'f', 5);
+    default:
+        return value;
+    }
+}
+
+QVariant LogbookModel::headerData(
+        int section,
+        Qt::Orientation orientation,
+        int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+
+    switch (section)
+    {
+    case Id:            return tr("ID");
+    case FileName:      return tr("File Name");
+    case Description:   return tr("Description");
+    case StartTime:     return tr("Start Time");
+    case Duration:      return tr("Duration");
+    case SamplePeriod:  return tr("Sample Period");
+    case MinLat:        return tr("Minimum Latitude");
+    case MaxLat:        return tr("Maximum Latitude");
+    case MinLon:        return tr("Minimum Longitude");
+    case MaxLon:        return tr("Maximum Longitude");
+    case ImportTime:    return tr("Import Time");
+    case ExitTime:      return tr("Exit Time");
+    case Ground:        return tr("Ground Elevation");
+    case Course:        return tr("Course Angle");
+    case WindSpeed:     return tr("Wind Speed");
+    case WindDirection: return tr("Wind Direction");
+    case RangeLower:    return tr("Range Lower");
+    case RangeUpper:    return tr("Range Upper");
+    default:            return QString();
+    }
+}
+
+Qt::ItemFlags LogbookModel::flags(
+        const QModelIndex &index) const
+{
+    Qt::ItemFlags flags = QAbstractTableModel::flags(index);
+
+    switch (index.column())
+    {
+    case Checked:
+        return flags | Qt::ItemIsUserCheckable;
+    case Description:
+    case Ground:
+    case WindSpeed:
+    case WindDirection:
+        return flags | Qt::ItemIsEditable;
+    default:
+        return flags;
+    }
+}
+
+bool LogbookModel::setData(
+        const QModelIndex &index,
+        const QVariant &value,
+        int role)
+{
+    if (!index.isValid() || !mMainWindow) return false;
+
+    const QString trackName = fileName(index.row());
+    if (trackName.isEmpty()) return false;
+
+    // The main window updates the database and calls refreshTrack
+    if (index.column() == Checked && role == Qt::CheckStateRole)
+    {
+        mMainWindow->setTrackChecked(trackName, value.toInt() == Qt::Checked);
+        return true;
+    }
+
+    if (role != Qt::EditRole) return false;
+
+    switch (index.column())
+    {
+    case Description:
+        mMainWindow->setTrackDescription(trackName, value.toString());
+        return true;
+    case Ground:
+        mMainWindow->setTrackGround(trackName, value.toDouble());
+        return true;
+    case WindSpeed:
+        mMainWindow->setTrackWindSpeed(trackName, value.toDouble());
+        return true;
+    case WindDirection:
+        mMainWindow->setTrackWindDir(trackName, value.toDouble());
+        return true;
+    default:
+        return false;
+    }
+}
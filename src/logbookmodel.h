@@ -0,0 +1,97 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef LOGBOOKMODEL_H
+#define LOGBOOKMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QVariant>
+#include <QVariantList>
+#include <QVector>
+
+class MainWindow;
+class QSqlQuery;
+
+/* Table model over the files table. A reload only reads the ids and
+ * names of the matching tracks, in SQL sort order; the rows themselves
+ * are read in blocks as the view scrolls to them. Single rows can be
+ * refreshed without resetting the model. */
+class LogbookModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    typedef enum {
+        Current, Checked, Id, FileName, Description, StartTime, Duration,
+        SamplePeriod, MinLat, MaxLat, MinLon, MaxLon, ImportTime, ExitTime,
+        Ground, Course, WindSpeed, WindDirection, RangeLower, RangeUpper,
+        ColumnCount
+    } Column;
+
+    explicit LogbookModel(QObject *parent = 0);
+
+    void setMainWindow(MainWindow *mainWindow) { mMainWindow = mainWindow; }
+    void setFilter(const QString &whereClause, const QVariantList &values);
+
+    QString fileName(int row) const;
+    int findRow(const QString &trackName);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const;
+    Qt::ItemFlags flags(const QModelIndex &index) const;
+    bool setData(const QModelIndex &index, const QVariant &value,
+                 int role = Qt::EditRole);
+
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
+
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+
+public slots:
+    void reload();
+    void refreshTrack(const QString &trackName);
+
+private:
+    typedef QVector< QVariant > Row;
+
+    MainWindow          *mMainWindow;
+
+    QString              mFilter;
+    QVariantList         mFilterValues;
+    int                  mSortColumn;
+    Qt::SortOrder        mSortOrder;
+
+    QVector< int >       mIds;
+    QVector< Row >       mRows;
+    QHash< QString, int > mRowIndex;
+
+    static QString selectColumns();
+    static QString sortExpression(int column);
+    static Row readRow(const QSqlQuery &query);
+};
+
+#endif // LOGBOOKMODEL_H
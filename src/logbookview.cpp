@@ -24,81 +24,77 @@
 #include "logbookview.h"
 #include "ui_logbookview.h"
 
-#include <QDateTime>
-#include <QMessageBox>
+#include <QHeaderView>
+#include <QItemSelectionModel>
 #include <QSqlDatabase>
-#include <QSqlError>
-#include <QSqlField>
-#include <QSqlQuery>
-#include <QSqlRecord>
+#include <QStringList>
 
-#include "mainwindow.h"
-
-class RealItem : public QTableWidgetItem
-{
-public:
-    RealItem(const QString &text, int type = Type):
-        QTableWidgetItem(text, type) {}
-
-    bool operator<(const QTableWidgetItem &rhs) const
-    {
-        return (this->text().toDouble() < rhs.text().toDouble());
-    }
-};
-
-class TimeItem : public QTableWidgetItem
-{
-public:
-    TimeItem(const QDateTime &dateTime, int type = Type):
-        QTableWidgetItem(dateTime.toLocalTime().toString("yyyy/MM/dd h:mm A"), type)
-    {
-        setData(Qt::UserRole, dateTime);
-    }
+#include <math.h>
 
-    bool operator<(const QTableWidgetItem &rhs) const
-    {
-        return (this->data(Qt::UserRole) < rhs.data(Qt::UserRole));
-    }
-};
-
-class DurationItem : public QTableWidgetItem
-{
-public:
-    DurationItem(qint64 duration, int type = Type):
-        QTableWidgetItem(duration < 3600000 ? QString("%1:%2").arg(duration / 60000)
-                                                              .arg((duration / 1000) % 60, 2, 10, QChar('0')) :
-                                              QString("%1:%2:%3").arg(duration / 3600000)
-                                                                 .arg((duration / 60000) % 60, 2, 10, QChar('0'))
-                                                                 .arg((duration / 1000) % 60, 2, 10, QChar('0')),
-                         type)
-    {
-        setData(Qt::UserRole, duration);
-    }
+#include "common.h"
+#include "logbookmodel.h"
+#include "mainwindow.h"
+#include "tracksummary.h"
 
-    bool operator<(const QTableWidgetItem &rhs) const
-    {
-        return (this->data(Qt::UserRole) < rhs.data(Qt::UserRole));
-    }
-};
+#define NEAR_RADIUS    10       // Default search radius (km)
+#define KM_PER_DEGREE  111.32   // Length of a degree of latitude (km)
 
 LogbookView::LogbookView(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::LogbookView),
     mMainWindow(0),
-    suspendItemChanged(false)
+    mModel(new LogbookModel(this))
 {
     ui->setupUi(this);
 
-    connect(ui->tableWidget, SIGNAL(cellDoubleClicked(int,int)),
-            this, SLOT(onDoubleClick(int,int)));
-    connect(ui->tableWidget, SIGNAL(itemSelectionChanged()),
+    ui->tableView->setModel(mModel);
+
+    connect(ui->tableView, SIGNAL(doubleClicked(QModelIndex)),
+            this, SLOT(onDoubleClick(QModelIndex)));
+    connect(ui->tableView->selectionModel(), SIGNAL(selectionChanged(QItemSelection,QItemSelection)),
             this, SLOT(onSelectionChanged()));
-    connect(ui->tableWidget, SIGNAL(itemChanged(QTableWidgetItem*)),
-            this, SLOT(onItemChanged(QTableWidgetItem*)));
+    connect(mModel, SIGNAL(modelAboutToBeReset()),
+            this, SLOT(onModelAboutToBeReset()));
+    connect(mModel, SIGNAL(modelReset()),
+            this, SLOT(onModelReset()));
     connect(ui->searchEdit, SIGNAL(textChanged(QString)),
             this, SLOT(onSearchTextChanged(QString)));
     connect(ui->searchEdit, SIGNAL(returnPressed()),
             this, SLOT(onSearchTextReturn()));
+
+    QHeaderView *header = ui->tableView->horizontalHeader();
+    header->setDefaultAlignment(Qt::AlignLeft);
+
+    header->resizeSection(LogbookModel::Current, header->minimumSectionSize());
+    header->setSectionResizeMode(LogbookModel::Current, QHeaderView::Fixed);
+
+    header->resizeSection(LogbookModel::Checked, 2 * header->minimumSectionSize());
+    header->setSectionResizeMode(LogbookModel::Checked, QHeaderView::Fixed);
+
+    ui->tableView->setColumnHidden(LogbookModel::Checked, true);
+    ui->tableView->setColumnHidden(LogbookModel::Id, true);
+    ui->tableView->setColumnHidden(LogbookModel::FileName, true);
+    ui->tableView->setColumnHidden(LogbookModel::MinLat, true);
+    ui->tableView->setColumnHidden(LogbookModel::MaxLat, true);
+    ui->tableView->setColumnHidden(LogbookModel::MinLon, true);
+    ui->tableView->setColumnHidden(LogbookModel::MaxLon, true);
+    ui->tableView->setColumnHidden(LogbookModel::Course, true);
+    ui->tableView->setColumnHidden(LogbookModel::RangeLower, true);
+    ui->tableView->setColumnHidden(LogbookModel::RangeUpper, true);
+
+    // List fields available for filtering
+    QStringList fields;
+    foreach (const QString &column, TrackSummary::columns())
+    {
+        fields.append(QString("%1 - %2").arg(column).arg(TrackSummary::label(column)));
+    }
+
+    ui->searchEdit->setToolTip(tr("Search descriptions and file names by word prefix, "
+                                  "or filter with terms like exit_altitude>4000 "
+                                  "max_vertical_speed>80.\n\n"
+                                  "near:lat,lon[,km] finds tracks near a point and "
+                                  "within:lat,lon,lat,lon finds tracks crossing a box.\n\n%1")
+                               .arg(fields.join("\n")));
 }
 
 LogbookView::~LogbookView()
@@ -111,244 +107,208 @@ void LogbookView::setMainWindow(
 {
     mMainWindow = mainWindow;
     mMainWindow->setSelectedTracks(QVector< QString >());
+
+    mModel->setMainWindow(mainWindow);
+    ui->tableView->sortByColumn(LogbookModel::Id, Qt::AscendingOrder);
 }
 
 void LogbookView::updateView()
 {
-    suspendItemChanged = true;
-
-    ui->tableWidget->setSortingEnabled(false);
+    QVariantList values;
+    const QString where = whereClause(ui->searchEdit->text(), values);
+    mModel->setFilter(where, values);
+}
 
-    QSqlDatabase db = QSqlDatabase::database("flysight");
-    QSqlQuery query(db);
+void LogbookView::updateTrack(
+        const QString &trackName)
+{
+    mModel->refreshTrack(trackName);
+}
 
-    QString whereText;
-    if (!this->ui->searchEdit->text().isEmpty())
+void LogbookView::updateSummaries()
+{
+    // Summaries aren't shown, so they only matter to the search
+    QVariantList values;
+    if (whereClause(ui->searchEdit->text(), values).contains("track_state."))
     {
-        QStringList searchItems = this->ui->searchEdit->text().split(QRegExp("\\s"));
-        for (int i = 0; i < searchItems.length(); ++i)
-        {
-            if (i == 0) whereText += "where ";
-            else        whereText += "and ";
-
-            whereText += "lower(description) like lower('%" + searchItems[i] + "%')";
-        }
+        updateView();
     }
+}
 
-    if (!query.exec(QString("select * from files %1").arg(whereText)))
+// Tracks whose bounds intersect a box, in degrees
+static QString boundsTerm(
+        double minLat,
+        double maxLat,
+        double minLon,
+        double maxLon,
+        bool useIndex,
+        QVariantList &values)
+{
+    const double factor = useIndex ? 1 : 1e7;
+
+    values << minLat * factor << maxLat * factor << minLon * factor << maxLon * factor;
+
+    if (useIndex)
     {
-        QSqlError err = query.lastError();
-        QMessageBox::critical(0, tr("Query failed"), err.text());
+        return "files.id in (select id from files_rtree "
+               "where max_lat >= ? and min_lat <= ? and max_lon >= ? and min_lon <= ?)";
     }
-
-    ui->tableWidget->horizontalHeader()->setDefaultAlignment(Qt::AlignLeft);
-
-    ui->tableWidget->setColumnCount(query.record().count() + 2);
-    ui->tableWidget->setRowCount(0);
-
-    ui->tableWidget->setColumnWidth(0, ui->tableWidget->horizontalHeader()->minimumSectionSize());
-    ui->tableWidget->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Fixed);
-
-    ui->tableWidget->setColumnWidth(1, 2 * ui->tableWidget->horizontalHeader()->minimumSectionSize());
-    ui->tableWidget->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Fixed);
-
-    ui->tableWidget->setColumnHidden(1, true);  // Hide checked column
-    ui->tableWidget->setColumnHidden(2, true);  // Hide id column
-    ui->tableWidget->setColumnHidden(3, true);  // Hide file_name column
-    ui->tableWidget->setColumnHidden(8, true);  // Hide min_lat column
-    ui->tableWidget->setColumnHidden(9, true);  // Hide max_lat column
-    ui->tableWidget->setColumnHidden(10, true);  // Hide min_lon column
-    ui->tableWidget->setColumnHidden(11, true);  // Hide max_lon column
-    ui->tableWidget->setColumnHidden(15, true);  // Hide course column
-
-    ui->tableWidget->setColumnHidden(18, true);  // Hide min_t column
-    ui->tableWidget->setColumnHidden(19, true);  // Hide max_t column
-
-    ui->tableWidget->setHorizontalHeaderLabels(QStringList()
-                                               << tr("")
-                                               << tr("")
-                                               << tr("ID")
-                                               << tr("File Name")
-                                               << tr("Description")
-                                               << tr("Start Time")
-                                               << tr("Duration")
-                                               << tr("Sample Period")
-                                               << tr("Minimum Latitude")
-                                               << tr("Maximum Latitude")
-                                               << tr("Minimum Longitude")
-                                               << tr("Maximum Longitude")
-                                               << tr("Import Time")
-                                               << tr("Exit Time")
-                                               << tr("Ground Elevation")
-                                               << tr("Course Angle")
-                                               << tr("Wind Speed")
-                                               << tr("Wind Direction")
-                                               << tr("Range Lower")
-                                               << tr("Range Upper"));
-
-    int index = 0;
-    while (query.next())
+    else
     {
-        ui->tableWidget->insertRow(ui->tableWidget->rowCount());
+        return "(files.max_lat >= ? and files.min_lat <= ? "
+               "and files.max_lon >= ? and files.min_lon <= ?)";
+    }
+}
 
-        QDateTime startTime = QDateTime::fromString(query.value(3).toString(), Qt::ISODate);
-        QDateTime importTime = QDateTime::fromString(query.value(10).toString(), Qt::ISODate);
-        QDateTime exitTime = QDateTime::fromString(query.value(11).toString(), Qt::ISODate);
-        qint64 duration = query.value(4).toString().toLongLong();
-        double ground = query.value(12).toString().toDouble();
-        double course = query.value(13).toString().toDouble();
+QString LogbookView::whereClause(
+        const QString &text,
+        QVariantList &values) const
+{
+    // Terms like max_vertical_speed>80 compare summary statistics
+    QRegExp condition("(\\w+)(<=|>=|!=|<|>|=)(-?\\d+\\.?\\d*)");
 
-        double windE = query.value(14).toString().toDouble();
-        double windN = query.value(15).toString().toDouble();
+    // Terms like near:lat,lon,km and within:lat,lon,lat,lon match locations
+    QRegExp near("near:(-?[\\d.]+),(-?[\\d.]+)(,([\\d.]+))?");
+    QRegExp within("within:(-?[\\d.]+),(-?[\\d.]+),(-?[\\d.]+),(-?[\\d.]+)");
 
-        double windSpeed = sqrt(windE * windE + windN * windN);
-        double windDir = atan2(-windE, -windN) / PI * 180;
-        if (windDir < 0) windDir += 360;
+    const QStringList columns = TrackSummary::columns();
+    const QStringList tables = QSqlDatabase::database("flysight").tables();
+
+    QStringList terms, words;
+    foreach (const QString &item, text.split(QRegExp("\\s"), QString::SkipEmptyParts))
+    {
+        if (condition.exactMatch(item) && columns.contains(condition.cap(1)))
+        {
+            // Column and operator are checked above; only the value is bound
+            terms.append(QString("track_state.%1 %2 ?")
+                         .arg(condition.cap(1))
+                         .arg(condition.cap(2)));
+            values.append(condition.cap(3).toDouble());
+        }
+        else if (near.exactMatch(item))
+        {
+            const double lat = near.cap(1).toDouble();
+            const double lon = near.cap(2).toDouble();
+            const double radius = near.cap(4).isEmpty() ? NEAR_RADIUS : near.cap(4).toDouble();
 
-        QDateTime rangeLower = QDateTime::fromString(query.value(16).toString(), Qt::ISODate);
-        QDateTime rangeUpper = QDateTime::fromString(query.value(17).toString(), Qt::ISODate);
+            const double dLat = radius / KM_PER_DEGREE;
+            const double dLon = dLat / qMax(cos(lat / 180 * PI), 0.01);
 
-        if (mMainWindow->trackName() == query.value(1).toString())
+            terms.append(boundsTerm(lat - dLat, lat + dLat, lon - dLon, lon + dLon,
+                                    tables.contains("files_rtree"), values));
+        }
+        else if (within.exactMatch(item))
         {
-            QTableWidgetItem *item = new QTableWidgetItem;
-            item->setIcon(style()->standardIcon(QStyle::SP_MediaPlay));
-            ui->tableWidget->setItem(index, 0, item);
+            const double lat1 = within.cap(1).toDouble(), lon1 = within.cap(2).toDouble();
+            const double lat2 = within.cap(3).toDouble(), lon2 = within.cap(4).toDouble();
+
+            terms.append(boundsTerm(qMin(lat1, lat2), qMax(lat1, lat2),
+                                    qMin(lon1, lon2), qMax(lon1, lon2),
+                                    tables.contains("files_rtree"), values));
         }
         else
         {
-            ui->tableWidget->setItem(index, 0, new QTableWidgetItem);
+            words.append(item);
         }
+    }
 
-        QTableWidgetItem *item = new QTableWidgetItem;
-        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
-        item->setCheckState(mMainWindow->trackChecked(
-                                query.value(1).toString()) ? Qt::Checked : Qt::Unchecked);
-        ui->tableWidget->setItem(index, 1, item);
-
-        ui->tableWidget->setItem(index, 2, new RealItem(query.value(0).toString()));             // id
-        ui->tableWidget->setItem(index, 3, new QTableWidgetItem(query.value(1).toString()));    // file_name
-        ui->tableWidget->setItem(index, 4, new QTableWidgetItem(query.value(2).toString()));    // description
-        ui->tableWidget->setItem(index, 5, new TimeItem(startTime));                            // start_time
-        ui->tableWidget->setItem(index, 6, new DurationItem(duration));                         // duration
-        ui->tableWidget->setItem(index, 7, new RealItem(query.value(5).toString()));             // sample_period
-        ui->tableWidget->setItem(index, 8, new RealItem(query.value(6).toString()));             // min_lat
-        ui->tableWidget->setItem(index, 9, new RealItem(query.value(7).toString()));             // max_lat
-        ui->tableWidget->setItem(index, 10, new RealItem(query.value(8).toString()));            // min_lon
-        ui->tableWidget->setItem(index, 11, new RealItem(query.value(9).toString()));            // max_lon
-        ui->tableWidget->setItem(index, 12, new TimeItem(importTime));                          // import_time
-        ui->tableWidget->setItem(index, 13, new TimeItem(exitTime));                            // exit_time
-        ui->tableWidget->setItem(index, 14, new RealItem(QString::number(ground, 'f', 3)));     // ground
-        ui->tableWidget->setItem(index, 15, new RealItem(QString::number(course, 'f', 5)));     // course
-        ui->tableWidget->setItem(index, 16, new RealItem(QString::number(windSpeed, 'f', 2)));  // wind_speed
-        ui->tableWidget->setItem(index, 17, new RealItem(QString::number(windDir, 'f', 5)));    // wind_dir
-        ui->tableWidget->setItem(index, 18, new TimeItem(rangeLower));                          // t_min
-        ui->tableWidget->setItem(index, 19, new TimeItem(rangeUpper));                          // t_max
-
-        for (int j = 0; j < ui->tableWidget->columnCount(); ++j)
+    // Anything else searches descriptions and file names
+    if (!words.isEmpty() && tables.contains("files_fts"))
+    {
+        // Match each word as a prefix
+        QStringList tokens;
+        foreach (QString word, words)
         {
-            // Enable/disable editing
-            QTableWidgetItem *item = ui->tableWidget->item(index, j);
-
-            switch (j)
-            {
-            case 4:  // description
-            case 14: // ground
-            case 16: // wind_speed
-            case 17: // wind_dir
-                item->setFlags(item->flags() |  Qt::ItemIsEditable);
-                break;
-            default:
-                item->setFlags(item->flags() & ~Qt::ItemIsEditable);
-                break;
-            }
+            tokens.append("\"" + word.replace("\"", "\"\"") + "\"*");
         }
 
-        ++index;
+        terms.append("files.id in (select rowid from files_fts where files_fts match ?)");
+        values.append(tokens.join(" "));
+    }
+    else
+    {
+        foreach (const QString &word, words)
+        {
+            terms.append("lower(files.description) like lower(?)");
+            values.append("%" + word + "%");
+        }
     }
 
-    ui->tableWidget->setSortingEnabled(true);
+    // Logs split into jumps are listed by jump
+    if (tables.contains("jumps"))
+    {
+        terms.append("files.file_name not in (select parent from jumps)");
+    }
 
-    suspendItemChanged = false;
+    if (terms.isEmpty()) return QString();
+    return "where " + terms.join(" and ");
 }
 
 void LogbookView::onDoubleClick(
-        int row,
-        int column)
+        const QModelIndex &index)
 {
-    Q_UNUSED(column);
-
     // Get file name
-    QTableWidgetItem *nameItem = ui->tableWidget->item(row, 3);
-    if (!nameItem) return;
+    const QString trackName = mModel->fileName(index.row());
+    if (trackName.isEmpty()) return;
 
-    if (mMainWindow->trackChecked(nameItem->text()))
+    if (mMainWindow->trackChecked(trackName))
     {
-        mMainWindow->importFromCheckedTrack(nameItem->text());
+        mMainWindow->importFromCheckedTrack(trackName);
     }
     else
     {
-        mMainWindow->importFromDatabase(nameItem->text());
+        mMainWindow->importFromDatabase(trackName);
     }
 }
 
 void LogbookView::onSelectionChanged()
 {
-    QList< QTableWidgetItem* > selectedItems = ui->tableWidget->selectedItems();
-
-    // Get a list of selected rows
-    QSet< int > selectedRows;
-    foreach (QTableWidgetItem *item, selectedItems)
-    {
-        selectedRows.insert(item->row());
-    }
-
     // Get a list of selected files
     QVector< QString > selectedFiles;
-    foreach (int row, selectedRows)
+    foreach (const QModelIndex &index, ui->tableView->selectionModel()->selectedRows())
     {
-        QTableWidgetItem *item = ui->tableWidget->item(row, 3);
-        selectedFiles.append(item->text());
+        selectedFiles.append(mModel->fileName(index.row()));
     }
 
     // Update main window
     mMainWindow->setSelectedTracks(selectedFiles);
 }
 
-void LogbookView::onItemChanged(
-        QTableWidgetItem *item)
+void LogbookView::onModelAboutToBeReset()
 {
-    if (suspendItemChanged) return;
-
-    // Get file name
-    QTableWidgetItem *nameItem = ui->tableWidget->item(item->row(), 3);
-    if (!nameItem) return;
-
-    if (item->column() == 1)
+    // Remember the selection and scroll position by track
+    mSelectedTracks.clear();
+    foreach (const QModelIndex &index, ui->tableView->selectionModel()->selectedRows())
     {
-        // Update check state
-        mMainWindow->setTrackChecked(nameItem->text(),
-                                     item->checkState() == Qt::Checked);
+        mSelectedTracks.append(mModel->fileName(index.row()));
     }
-    else if (item->column() == 4)
-    {
-        // Update description
-        mMainWindow->setTrackDescription(nameItem->text(), item->text());
-    }
-    else if (item->column() == 14)
-    {
-        // Update ground elevation
-        mMainWindow->setTrackGround(nameItem->text(), item->text().toDouble());
-    }
-    else if (item->column() == 16)
+
+    mTopTrack = mModel->fileName(ui->tableView->rowAt(0));
+}
+
+void LogbookView::onModelReset()
+{
+    // Select the same tracks, where they still match
+    QItemSelection selection;
+    foreach (const QString &trackName, mSelectedTracks)
     {
-        // Update wind speed
-        mMainWindow->setTrackWindSpeed(nameItem->text(), item->text().toDouble());
+        const int row = mModel->findRow(trackName);
+        if (row < 0) continue;
+
+        selection.select(mModel->index(row, 0),
+                         mModel->index(row, LogbookModel::ColumnCount - 1));
     }
-    else if (item->column() == 17)
+
+    ui->tableView->selectionModel()->select(selection, QItemSelectionModel::Select);
+
+    const int top = mModel->findRow(mTopTrack);
+    if (top >= 0)
     {
-        // Update wind direction
-        mMainWindow->setTrackWindDir(nameItem->text(), item->text().toDouble());
+        ui->tableView->scrollTo(mModel->index(top, 0), QAbstractItemView::PositionAtTop);
     }
+
+    // A reset clears the selection without signalling it
+    onSelectionChanged();
 }
 
 void LogbookView::onSearchTextChanged(
@@ -24,14 +24,17 @@
 #ifndef LOGBOOKVIEW_H
 #define LOGBOOKVIEW_H
 
+#include <QStringList>
+#include <QVariantList>
 #include <QWidget>
 
 namespace Ui {
     class LogbookView;
 }
 
+class LogbookModel;
 class MainWindow;
-class QTableWidgetItem;
+class QModelIndex;
 
 class LogbookView : public QWidget
 {
@@ -49,16 +52,23 @@ protected:
 private:
     Ui::LogbookView *ui;
     MainWindow      *mMainWindow;
+    LogbookModel    *mModel;
 
-    bool             suspendItemChanged;
+    QStringList      mSelectedTracks;
+    QString          mTopTrack;
+
+    QString whereClause(const QString &text, QVariantList &values) const;
 
 public slots:
     void updateView();
+    void updateTrack(const QString &trackName);
+    void updateSummaries();
 
 private slots:
-    void onDoubleClick(int row, int column);
+    void onDoubleClick(const QModelIndex &index);
     void onSelectionChanged();
-    void onItemChanged(QTableWidgetItem *item);
+    void onModelAboutToBeReset();
+    void onModelReset();
     void onSearchTextChanged(const QString &text);
     void onSearchTextReturn();
 };
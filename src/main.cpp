@@ -21,20 +21,158 @@
 **  Website: http://flysight.ca/                                          **
 ****************************************************************************/
 
+#include "audiocomparison.h"
+#include "batchprocessor.h"
+#include "importserver.h"
 #include "mainwindow.h"
+#include "scoringbenchmark.h"
+#include "scoringserver.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QThread>
+
+static int runHeadless(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("FlySight Viewer");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Imports, scores and exports FlySight tracks without a user interface.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("input", "Track or folder of tracks to process.");
+
+    QCommandLineOption batchOption("batch", "Process a track or folder of tracks.");
+    QCommandLineOption serveOption("serve", "Run a local scoring service.");
+    QCommandLineOption benchmarkOption("benchmark", "Load test the scoring service with a track.");
+    QCommandLineOption compareOption("compare-audio", "Render a track's audio with each configuration file that follows it.");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "Folder for exports and report.json.", "folder");
+    QCommandLineOption threadsOption(QStringList() << "j" << "threads", "Number of worker threads.", "count",
+                                     QString::number(QThread::idealThreadCount()));
+    QCommandLineOption noCSVOption("no-csv", "Don't export CSV files.");
+    QCommandLineOption noKMLOption("no-kml", "Don't export KML files.");
+    QCommandLineOption columnsOption("columns", "Also write every track to tracks.fsc, a columnar binary dataset.");
+    QCommandLineOption windOption("wind-adjustment", "Apply wind adjustment to scores.");
+    QCommandLineOption portOption(QStringList() << "p" << "port", "Port for the scoring service.", "port", "8723");
+    QCommandLineOption cacheOption("cache", "Number of tracks kept by the scoring service.", "count", "64");
+    QCommandLineOption clientsOption("clients", "Number of benchmark clients.", "count",
+                                     QString::number(QThread::idealThreadCount()));
+    QCommandLineOption requestsOption("requests", "Requests per benchmark client.", "count", "1000");
+    QCommandLineOption methodOption("method", "Scoring method for the benchmark (ppc, speed or flare).", "method", "ppc");
+    QCommandLineOption audioOption("audio-folder", "Folder of speech prompts for audio comparison.", "folder");
+
+    parser.addOption(batchOption);
+    parser.addOption(serveOption);
+    parser.addOption(benchmarkOption);
+    parser.addOption(compareOption);
+    parser.addOption(outputOption);
+    parser.addOption(threadsOption);
+    parser.addOption(noCSVOption);
+    parser.addOption(noKMLOption);
+    parser.addOption(columnsOption);
+    parser.addOption(windOption);
+    parser.addOption(portOption);
+    parser.addOption(cacheOption);
+    parser.addOption(clientsOption);
+    parser.addOption(requestsOption);
+    parser.addOption(methodOption);
+    parser.addOption(audioOption);
+
+    parser.process(a);
+
+    const QStringList args = parser.positionalArguments();
+
+    if (parser.isSet(serveOption))
+    {
+        ScoringServer server;
+        server.setThreadCount(parser.value(threadsOption).toInt());
+        server.setCacheSize(parser.value(cacheOption).toInt());
+
+        if (!server.start(parser.value(portOption).toUShort()))
+        {
+            QTextStream(stderr) << QString("Couldn't start server: %1").arg(server.errorString()) << endl;
+            return 1;
+        }
+
+        QTextStream(stdout) << QString("Listening on http://127.0.0.1:%1/").arg(server.serverPort()) << endl;
+
+        return a.exec();
+    }
+
+    if (parser.isSet(compareOption))
+    {
+        if (args.size() < 2)
+        {
+            parser.showHelp(1);
+        }
+
+        AudioComparison comparison;
+        comparison.setTrackPath(args.first());
+        comparison.setConfigPaths(args.mid(1));
+        comparison.setOutputPath(parser.isSet(outputOption) ? parser.value(outputOption) : QString("."));
+        comparison.setAudioFolder(parser.value(audioOption));
+        comparison.setThreadCount(parser.value(threadsOption).toInt());
+
+        return comparison.run();
+    }
+
+    if (args.size() != 1)
+    {
+        parser.showHelp(1);
+    }
+
+    if (parser.isSet(benchmarkOption))
+    {
+        ScoringBenchmark benchmark;
+        benchmark.setTrackPath(args.first());
+        benchmark.setMethod(parser.value(methodOption));
+        benchmark.setThreadCount(parser.value(threadsOption).toInt());
+        benchmark.setClientCount(parser.value(clientsOption).toInt());
+        benchmark.setRequestCount(parser.value(requestsOption).toInt());
+
+        return benchmark.run();
+    }
+
+    BatchProcessor processor;
+    processor.setInputPath(args.first());
+    processor.setOutputPath(parser.value(outputOption));
+    processor.setThreadCount(parser.value(threadsOption).toInt());
+    processor.setExportCSV(!parser.isSet(noCSVOption));
+    processor.setExportKML(!parser.isSet(noKMLOption));
+    processor.setExportColumns(parser.isSet(columnsOption));
+    processor.setWindAdjustment(parser.isSet(windOption));
+
+    return processor.run();
+}
 
 int main(int argc, char *argv[])
 {
+    // Run without creating any widgets in headless modes
+    for (int i = 1; i < argc; ++i)
+    {
+        if (qstrcmp(argv[i], "--batch") == 0
+                || qstrcmp(argv[i], "--serve") == 0
+                || qstrcmp(argv[i], "--benchmark") == 0
+                || qstrcmp(argv[i], "--compare-audio") == 0)
+        {
+            return runHeadless(argc, argv);
+        }
+    }
+
     QApplication a(argc, argv);
-    MainWindow w;
-    w.show();
 
-    // Import a file if specified on the command line
-    if (QCoreApplication::arguments().size() >= 2)
+    // Hand files to a running instance if there is one
+    const QStringList fileNames = QCoreApplication::arguments().mid(1);
+    if (!fileNames.isEmpty() && ImportServer::sendFiles(fileNames))
     {
-        w.importFile(QCoreApplication::arguments().at(1));
+        return 0;
     }
+
+    MainWindow w;
+    w.show();
+
+    // Import files specified on the command line
+    w.importFiles(fileNames);
     
     return a.exec();
 }
@@ -42,18 +42,20 @@
 #include <QStandardPaths>
 #include <QTemporaryFile>
 #include <QTextStream>
-#include <QThread>
 
 #include <math.h>
 
 #include "GeographicLib/Geodesic.hpp"
 
 #include "acroscoring.h"
+#include "columnwriter.h"
 #include "common.h"
 #include "configdialog.h"
 #include "dataview.h"
+#include "exportwriter.h"
 #include "flarescoring.h"
-#include "importworker.h"
+#include "importserver.h"
+#include "kmlwriter.h"
 #include "liftdragplot.h"
 #include "logbookview.h"
 #include "mapview.h"
@@ -61,10 +63,17 @@
 #include "performancescoring.h"
 #include "playbackview.h"
 #include "ppcscoring.h"
+#include "reprocessqueue.h"
 #include "scoringview.h"
 #include "simulationview.h"
 #include "speedscoring.h"
+#include "trackarchive.h"
+#include "trackdatabase.h"
+#include "tracksegments.h"
+#include "tracksummary.h"
+#include "trackutil.h"
 #include "videoview.h"
+#include "viewscheduler.h"
 #include "wideopendistancescoring.h"
 #include "wideopenspeedscoring.h"
 #include "windplot.h"
@@ -76,6 +85,9 @@ MainWindow::MainWindow(
 
     QMainWindow(parent),
     m_ui(new Ui::MainWindow),
+    mDataGeneration(0),
+    mImporting(false),
+    mPhaseIndexValid(false),
     mMarkActive(false),
     m_viewDataRotation(0),
     m_units(PlotValue::Imperial),
@@ -129,9 +141,42 @@ MainWindow::MainWindow(
     // Read settings
     readSettings();
 
+    // Write track values in the background
+    mTrackDatabase = new TrackDatabase(this);
+    connect(mTrackDatabase, SIGNAL(written(QString,QStringList)),
+            this, SLOT(onTrackWritten(QString,QStringList)));
+    connect(mTrackDatabase, SIGNAL(failed(QString)),
+            this, SLOT(onTrackWriteFailed(QString)));
+
     // Initialize database
     initDatabase();
 
+    // Keep logbook summaries up to date in the background
+    mReprocessQueue = new ReprocessQueue(this);
+    connect(mReprocessQueue, SIGNAL(idle()),
+            this, SIGNAL(summariesChanged()));
+    connect(mReprocessQueue, SIGNAL(failed(QString,QString)),
+            this, SLOT(onReprocessFailed(QString,QString)));
+
+    updateReprocessQueue();
+    mReprocessQueue->start(mDatabasePath);
+
+    // Count data changes so views can tell when their caches are stale
+    connect(this, SIGNAL(dataChanged()),
+            this, SLOT(onDataChanged()));
+
+    // Coalesce view updates
+    mViewScheduler = new ViewScheduler(this);
+
+    connect(this, SIGNAL(dataChanged()),
+            mViewScheduler, SLOT(markData()));
+    connect(this, SIGNAL(rangeChanged()),
+            mViewScheduler, SLOT(markRange()));
+    connect(this, SIGNAL(cursorChanged()),
+            mViewScheduler, SLOT(markCursor()));
+    connect(this, SIGNAL(mediaCursorChanged()),
+            mViewScheduler, SLOT(markMediaCursor()));
+
     // Initialize plot area
     initPlot();
 
@@ -173,17 +218,10 @@ MainWindow::MainWindow(
     // Redraw plots
     emit dataChanged();
 
-    // Create interprocess import worker
-    QThread *thread = new QThread;
-    ImportWorker *worker = new ImportWorker;
-    worker->moveToThread(thread);
-
-    // Attach interprocess import worker
-    connect(thread, SIGNAL(started()), worker, SLOT(process()));
-    connect(worker, SIGNAL(importFile(QString)), this, SLOT(importFile(QString)));
-
-    // Start worker thread
-    thread->start();
+    // Accept tracks from other instances
+    ImportServer *importServer = new ImportServer(this);
+    connect(importServer, SIGNAL(importFiles(QStringList)),
+            this, SLOT(importFiles(QStringList)));
 
     // Set up zoom timer
     zoomTimer = new QTimer(this);
@@ -259,8 +297,12 @@ void MainWindow::initDatabase()
     QDir(mDatabasePath).mkpath("FlySight");
     QString path = QDir(mDatabasePath).filePath("FlySight/FlySight.db");
 
+    // Finish writing to the previous database
+    mTrackDatabase->close();
+
     mDatabase = QSqlDatabase::addDatabase("QSQLITE", "flysight");
     mDatabase.setDatabaseName(path);
+    mDatabase.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
 
     if (!mDatabase.open())
     {
@@ -291,8 +333,12 @@ void MainWindow::initDatabase()
         }
     }
 
-    // Add exit, ground and course
+    // Let the GUI read while other threads write
     QSqlQuery query(mDatabase);
+    query.exec("pragma journal_mode=wal");
+    query.exec("pragma synchronous=normal");
+
+    // Add exit, ground and course
     query.exec("alter table files add column exit text");
     query.exec("alter table files add column ground real");
     query.exec("alter table files add column course real");
@@ -304,6 +350,109 @@ void MainWindow::initDatabase()
     // Add zoom range
     query.exec("alter table files add column t_min real");
     query.exec("alter table files add column t_max real");
+
+    // Add summary statistics
+    if (!TrackSummary::createTable(mDatabase))
+    {
+        QSqlError err = mDatabase.lastError();
+        QMessageBox::critical(0, tr("Query failed"), err.text());
+    }
+
+    // Add jumps split from longer logs
+    if (!TrackSegments::createTable(mDatabase))
+    {
+        QSqlError err = mDatabase.lastError();
+        QMessageBox::critical(0, tr("Query failed"), err.text());
+    }
+
+    // Add search indexes
+    initSearchIndexes();
+
+    mTrackDatabase->open(mDatabasePath);
+}
+
+void MainWindow::initSearchIndexes()
+{
+    const QStringList tables = mDatabase.tables();
+    QSqlQuery query(mDatabase);
+
+    // Full-text index over descriptions and file names. Searches fall
+    // back to scanning descriptions if SQLite was built without FTS5.
+    if (!tables.contains("files_fts")
+            && query.exec("create virtual table files_fts using fts5("
+                          "description, file_name, content='files', content_rowid='id')"))
+    {
+        query.exec("insert into files_fts (files_fts) values ('rebuild')");
+    }
+
+    if (mDatabase.tables().contains("files_fts"))
+    {
+        query.exec("create trigger if not exists files_fts_insert after insert on files begin "
+                   "insert into files_fts (rowid, description, file_name) "
+                   "values (new.id, new.description, new.file_name); "
+                   "end");
+        query.exec("create trigger if not exists files_fts_delete after delete on files begin "
+                   "insert into files_fts (files_fts, rowid, description, file_name) "
+                   "values ('delete', old.id, old.description, old.file_name); "
+                   "end");
+        query.exec("create trigger if not exists files_fts_update "
+                   "after update of description, file_name on files begin "
+                   "insert into files_fts (files_fts, rowid, description, file_name) "
+                   "values ('delete', old.id, old.description, old.file_name); "
+                   "insert into files_fts (rowid, description, file_name) "
+                   "values (new.id, new.description, new.file_name); "
+                   "end");
+    }
+
+    // Spatial index over track bounds, in degrees
+    if (!tables.contains("files_rtree")
+            && query.exec("create virtual table files_rtree using rtree("
+                          "id, min_lat, max_lat, min_lon, max_lon)"))
+    {
+        query.exec("insert into files_rtree "
+                   "select id, min_lat / 1e7, max_lat / 1e7, min_lon / 1e7, max_lon / 1e7 "
+                   "from files where min_lat is not null");
+    }
+
+    if (mDatabase.tables().contains("files_rtree"))
+    {
+        // Bounds are filled in by an update after the row is inserted
+        query.exec("create trigger if not exists files_rtree_update "
+                   "after update of min_lat, max_lat, min_lon, max_lon on files "
+                   "when new.min_lat is not null begin "
+                   "insert or replace into files_rtree "
+                   "values (new.id, new.min_lat / 1e7, new.max_lat / 1e7, "
+                   "new.min_lon / 1e7, new.max_lon / 1e7); "
+                   "end");
+        query.exec("create trigger if not exists files_rtree_delete after delete on files begin "
+                   "delete from files_rtree where id = old.id; "
+                   "end");
+    }
+}
+
+void MainWindow::updateReprocessQueue()
+{
+    // Derive tracks with the current settings
+    BatchProcessor::Options options = BatchProcessor::defaultOptions();
+    options.mass = m_mass;
+    options.planformArea = m_planformArea;
+    options.windE = mWindE;
+    options.windN = mWindN;
+    options.fixedGround = (mGroundReference == Fixed);
+    options.fixedReference = mFixedReference;
+    options.windAdjustment = mWindAdjustment;
+
+    mReprocessQueue->setOptions(options);
+
+    // Process the current and checked tracks first
+    QStringList trackNames;
+    if (!mTrackName.isEmpty())
+    {
+        trackNames.append(mTrackName);
+    }
+    trackNames.append(mCheckedTracks.keys());
+
+    mReprocessQueue->setPriorityTracks(trackNames);
 }
 
 void MainWindow::initPlot()
@@ -313,14 +462,10 @@ void MainWindow::initPlot()
 
     m_ui->plotArea->setMainWindow(this);
 
-    connect(this, SIGNAL(dataChanged()),
-            m_ui->plotArea, SLOT(updatePlot()));
-    connect(this, SIGNAL(rangeChanged()),
-            m_ui->plotArea, SLOT(updateRange()));
-    connect(this, SIGNAL(cursorChanged()),
-            m_ui->plotArea, SLOT(updateCursor()));
-    connect(this, SIGNAL(mediaCursorChanged()),
-            m_ui->plotArea, SLOT(updateCursor()));
+    mViewScheduler->addView(m_ui->plotArea, 0, ViewScheduler::Data, "updatePlot");
+    mViewScheduler->addView(m_ui->plotArea, 0, ViewScheduler::Range, "updateRange");
+    mViewScheduler->addView(m_ui->plotArea, 0, ViewScheduler::Cursor, "updateCursor");
+    mViewScheduler->addView(m_ui->plotArea, 0, ViewScheduler::MediaCursor, "updateCursor");
 }
 
 void MainWindow::initViews()
@@ -350,14 +495,10 @@ void MainWindow::initSingleView(
     connect(dockWidget, SIGNAL(visibilityChanged(bool)),
             actionShow, SLOT(setChecked(bool)));
 
-    connect(this, SIGNAL(dataChanged()),
-            dataView, SLOT(updateView()));
-    connect(this, SIGNAL(rangeChanged()),
-            dataView, SLOT(updateView()));
-    connect(this, SIGNAL(cursorChanged()),
-            dataView, SLOT(updateCursor()));
-    connect(this, SIGNAL(mediaCursorChanged()),
-            dataView, SLOT(updateCursor()));
+    mViewScheduler->addView(dataView, dockWidget, ViewScheduler::Data, "updateView");
+    mViewScheduler->addView(dataView, dockWidget, ViewScheduler::Range, "updateView");
+    mViewScheduler->addView(dataView, dockWidget, ViewScheduler::Cursor, "updateCursor");
+    mViewScheduler->addView(dataView, dockWidget, ViewScheduler::MediaCursor, "updateCursor");
     connect(this, SIGNAL(rotationChanged(double)),
             dataView, SLOT(updateView()));
 
@@ -382,14 +523,10 @@ void MainWindow::initMapView()
 
     connect(this, SIGNAL(dataLoaded()),
             mapView, SLOT(initView()));
-    connect(this, SIGNAL(dataChanged()),
-            mapView, SLOT(updateView()));
-    connect(this, SIGNAL(rangeChanged()),
-            mapView, SLOT(updateView()));
-    connect(this, SIGNAL(cursorChanged()),
-            mapView, SLOT(updateCursor()));
-    connect(this, SIGNAL(mediaCursorChanged()),
-            mapView, SLOT(updateCursor()));
+    mViewScheduler->addView(mapView, dockWidget, ViewScheduler::Data, "updateView");
+    mViewScheduler->addView(mapView, dockWidget, ViewScheduler::Range, "updateView");
+    mViewScheduler->addView(mapView, dockWidget, ViewScheduler::Cursor, "updateCursor");
+    mViewScheduler->addView(mapView, dockWidget, ViewScheduler::MediaCursor, "updateCursor");
     connect(this, SIGNAL(mapModeChanged()),
             mapView, SLOT(updateMapMode()));
 
@@ -413,14 +550,10 @@ void MainWindow::initWindView()
     connect(dockWidget, SIGNAL(visibilityChanged(bool)),
             m_ui->actionShowWindView, SLOT(setChecked(bool)));
 
-    connect(this, SIGNAL(dataChanged()),
-            windPlot, SLOT(updatePlot()));
-    connect(this, SIGNAL(rangeChanged()),
-            windPlot, SLOT(updatePlot()));
-    connect(this, SIGNAL(cursorChanged()),
-            windPlot, SLOT(updatePlot()));
-    connect(this, SIGNAL(mediaCursorChanged()),
-            windPlot, SLOT(updatePlot()));
+    mViewScheduler->addView(windPlot, dockWidget, ViewScheduler::Data, "updatePlot");
+    mViewScheduler->addView(windPlot, dockWidget, ViewScheduler::Range, "updatePlot");
+    mViewScheduler->addView(windPlot, dockWidget, ViewScheduler::Cursor, "updateCursor");
+    mViewScheduler->addView(windPlot, dockWidget, ViewScheduler::MediaCursor, "updateCursor");
 
     connect(dockWidget, SIGNAL(topLevelChanged(bool)),
             this, SLOT(onDockWidgetTopLevelChanged(bool)));
@@ -444,10 +577,8 @@ void MainWindow::initScoringView()
     connect(dockWidget, SIGNAL(visibilityChanged(bool)),
             m_ui->actionShowScoringView, SLOT(setChecked(bool)));
 
-    connect(this, SIGNAL(dataChanged()),
-            mScoringView, SLOT(updateView()));
-    connect(this, SIGNAL(rangeChanged()),
-            mScoringView, SLOT(updateView()));
+    mViewScheduler->addView(mScoringView, dockWidget, ViewScheduler::Data, "updateView");
+    mViewScheduler->addView(mScoringView, dockWidget, ViewScheduler::Range, "updateView");
 
     connect(dockWidget, SIGNAL(topLevelChanged(bool)),
             this, SLOT(onDockWidgetTopLevelChanged(bool)));
@@ -469,14 +600,10 @@ void MainWindow::initLiftDragView()
     connect(dockWidget, SIGNAL(visibilityChanged(bool)),
             m_ui->actionShowLiftDragView, SLOT(setChecked(bool)));
 
-    connect(this, SIGNAL(dataChanged()),
-            liftDragPlot, SLOT(updatePlot()));
-    connect(this, SIGNAL(rangeChanged()),
-            liftDragPlot, SLOT(updatePlot()));
-    connect(this, SIGNAL(cursorChanged()),
-            liftDragPlot, SLOT(updatePlot()));
-    connect(this, SIGNAL(mediaCursorChanged()),
-            liftDragPlot, SLOT(updatePlot()));
+    mViewScheduler->addView(liftDragPlot, dockWidget, ViewScheduler::Data, "updatePlot");
+    mViewScheduler->addView(liftDragPlot, dockWidget, ViewScheduler::Range, "updatePlot");
+    mViewScheduler->addView(liftDragPlot, dockWidget, ViewScheduler::Cursor, "updateCursor");
+    mViewScheduler->addView(liftDragPlot, dockWidget, ViewScheduler::MediaCursor, "updateCursor");
     connect(this, SIGNAL(aeroChanged()),
             liftDragPlot, SLOT(updatePlot()));
 
@@ -500,14 +627,10 @@ void MainWindow::initOrthoView()
     connect(dockWidget, SIGNAL(visibilityChanged(bool)),
             m_ui->actionShowOrthoView, SLOT(setChecked(bool)));
 
-    connect(this, SIGNAL(dataChanged()),
-            orthoView, SLOT(updateView()));
-    connect(this, SIGNAL(rangeChanged()),
-            orthoView, SLOT(updateView()));
-    connect(this, SIGNAL(cursorChanged()),
-            orthoView, SLOT(updateView()));
-    connect(this, SIGNAL(mediaCursorChanged()),
-            orthoView, SLOT(updateView()));
+    mViewScheduler->addView(orthoView, dockWidget, ViewScheduler::Data, "updateView");
+    mViewScheduler->addView(orthoView, dockWidget, ViewScheduler::Range, "updateView");
+    mViewScheduler->addView(orthoView, dockWidget, ViewScheduler::Cursor, "updateCursor");
+    mViewScheduler->addView(orthoView, dockWidget, ViewScheduler::MediaCursor, "updateCursor");
 
     connect(dockWidget, SIGNAL(topLevelChanged(bool)),
             this, SLOT(onDockWidgetTopLevelChanged(bool)));
@@ -529,10 +652,8 @@ void MainWindow::initPlaybackView()
     connect(dockWidget, SIGNAL(visibilityChanged(bool)),
             m_ui->actionShowPlaybackView, SLOT(setChecked(bool)));
 
-    connect(this, SIGNAL(dataChanged()),
-            playbackView, SLOT(updateView()));
-    connect(this, SIGNAL(rangeChanged()),
-            playbackView, SLOT(updateView()));
+    mViewScheduler->addView(playbackView, dockWidget, ViewScheduler::Data, "updateView");
+    mViewScheduler->addView(playbackView, dockWidget, ViewScheduler::Range, "updateView");
 
     connect(dockWidget, SIGNAL(topLevelChanged(bool)),
             this, SLOT(onDockWidgetTopLevelChanged(bool)));
@@ -557,6 +678,10 @@ void MainWindow::initLogbookView()
 
     connect(this, SIGNAL(databaseChanged()),
             logbookView, SLOT(updateView()));
+    connect(this, SIGNAL(summariesChanged()),
+            logbookView, SLOT(updateSummaries()));
+    connect(this, SIGNAL(trackChanged(QString)),
+            logbookView, SLOT(updateTrack(QString)));
 
     connect(dockWidget, SIGNAL(topLevelChanged(bool)),
             this, SLOT(onDockWidgetTopLevelChanged(bool)));
@@ -576,10 +701,8 @@ void MainWindow::initSimulationView()
     simulationView->setMainWindow(this);
 
     // Set up notifications for simulation view
-    connect(this, SIGNAL(dataChanged()),
-            simulationView, SLOT(updateView()));
-    connect(this, SIGNAL(mediaCursorChanged()),
-            simulationView, SLOT(updateView()));
+    mViewScheduler->addView(simulationView, dockWidget, ViewScheduler::Data, "updateView");
+    mViewScheduler->addView(simulationView, dockWidget, ViewScheduler::MediaCursor, "updateView");
     connect(this, SIGNAL(mediaPaused()),
             simulationView, SLOT(pauseMedia()));
 
@@ -596,6 +719,11 @@ void MainWindow::initSimulationView()
             this, SLOT(onDockWidgetTopLevelChanged(bool)));
 }
 
+void MainWindow::onDataChanged()
+{
+    ++mDataGeneration;
+}
+
 void MainWindow::onDockWidgetTopLevelChanged(bool floating)
 {
     if (floating)
@@ -652,102 +780,41 @@ void MainWindow::closeEvent(
 DataPoint MainWindow::interpolateDataT(
         double t) const
 {
-    const int i1 = findIndexBelowT(t);
-    const int i2 = findIndexAboveT(t);
-
-    if (i1 < 0)
-    {
-        return m_data.first();
-    }
-    else if (i2 >= m_data.size())
-    {
-        return m_data.last();
-    }
-    else
-    {
-        const DataPoint &dp1 = m_data[i1];
-        const DataPoint &dp2 = m_data[i2];
-        return DataPoint::interpolate(dp1, dp2, (t - dp1.t) / (dp2.t - dp1.t));
-    }
+    return TrackUtil::interpolateDataT(m_data, t);
 }
 
 DataPoint MainWindow::performanceStart(double threshold) const
 {
-    // ------------------------------------------------------------------
-    //  Find the first data-point *after exit* ( t > 0 ).
-    // ------------------------------------------------------------------
-    const int firstAfterExit = findIndexAboveT(0.0);     // -1 if none
-
-    if (firstAfterExit < 0 || firstAfterExit + 1 >= m_data.size())
-        return interpolateDataT(0);                      // fall back to exit
-
-    // ------------------------------------------------------------------
-    //  Scan forward through *pairs of points* that are both after exit
-    //  until vertical speed (velD) first reaches or crosses `threshold`.
-    // ------------------------------------------------------------------
-    for (int i = firstAfterExit + 1; i < m_data.size(); ++i)
-    {
-        const DataPoint &p1 = m_data[i - 1];   // p1.t  > 0  by construction
-        const DataPoint &p2 = m_data[i];
-
-        if (p1.velD < threshold && p2.velD >= threshold)
-        {
-            double a = (threshold - p1.velD) / (p2.velD - p1.velD);
-            return DataPoint::interpolate(p1, p2, a);
-        }
-    }
-
-    // Never reached the threshold – return the first post-exit sample.
-    return m_data[firstAfterExit];
+    return TrackUtil::performanceStart(m_data, threshold, &phaseIndex());
 }
 
 int MainWindow::findIndexBelowT(
         double t) const
 {
-    int below = -1;
-    int above = m_data.size();
-
-    while (below + 1 != above)
-    {
-        int mid = (below + above) / 2;
-        const DataPoint &dp = m_data[mid];
-
-        if (dp.t < t) below = mid;
-        else          above = mid;
-    }
-
-    return below;
+    return TrackUtil::findIndexBelowT(m_data, t);
 }
 
 int MainWindow::findIndexAboveT(
         double t) const
 {
-    int below = -1;
-    int above = m_data.size();
-
-    while (below + 1 != above)
-    {
-        int mid = (below + above) / 2;
-        const DataPoint &dp = m_data[mid];
-
-        if (dp.t > t) above = mid;
-        else          below = mid;
-    }
-
-    return above;
+    return TrackUtil::findIndexAboveT(m_data, t);
 }
 
 int MainWindow::findIndexForLanding()
 {
-    int i = findIndexBelowT(0.0);
+    return phaseIndex().landing;
+}
 
-    while (++i < m_data.size()-1) {
-        const DataPoint &p = m_data[i];
-        if (p.velE*p.velE + p.velN*p.velN + p.velD < 1.0)
-            break;
+const TrackUtil::PhaseIndex &MainWindow::phaseIndex() const
+{
+    // Keep the index of the current track until its data changes
+    if (!mPhaseIndexValid)
+    {
+        mPhaseIndex = TrackUtil::indexPhases(m_data);
+        mPhaseIndexValid = true;
     }
 
-    return i;
+    return mPhaseIndex;
 }
 
 void MainWindow::on_actionImport_triggered()
@@ -764,11 +831,8 @@ void MainWindow::on_actionImport_triggered()
     // Sort files from oldest to newest
     qSort(fileNames);
 
-    // Import each file
-    foreach (QString fileName, fileNames)
-    {
-        importFile(fileName);
-    }
+    // Import all files at once
+    importFiles(fileNames);
 }
 
 void MainWindow::on_actionImportFolder_triggered()
@@ -788,22 +852,33 @@ void MainWindow::on_actionImportFolder_triggered()
 
 void MainWindow::importFolder(
         QString folderName)
+{
+    QStringList fileNames;
+    findFiles(folderName, fileNames);
+
+    // Import all files at once
+    importFiles(fileNames);
+}
+
+void MainWindow::findFiles(
+        const QString &folderName,
+        QStringList &fileNames)
 {
     QDir dir(folderName);
 
-    // Import each file in this folder
+    // Add each file in this folder
     foreach (QString fileName, dir.entryList(QStringList() << "*.csv",
                                              QDir::Files,
                                              QDir::Name))
     {
-        importFile(dir.absoluteFilePath(fileName));
+        fileNames.append(dir.absoluteFilePath(fileName));
     }
 
     // Follow subfolders
     foreach (QString child, dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot,
                                           QDir::Name))
     {
-        importFolder(dir.absoluteFilePath(child));
+        findFiles(dir.absoluteFilePath(child), fileNames);
     }
 }
 
@@ -838,6 +913,110 @@ QString MainWindow::getDescription(
 
 void MainWindow::importFile(
         QString fileName)
+{
+    importFiles(QStringList() << fileName);
+}
+
+void MainWindow::importFiles(
+        const QStringList &fileNames)
+{
+    if (fileNames.isEmpty()) return;
+
+    // The progress dialog and message boxes run event loops, so tracks
+    // sent by the import server may arrive before this batch is done
+    if (mImporting)
+    {
+        mPendingImports.append(fileNames);
+        return;
+    }
+
+    mImporting = true;
+
+    QProgressDialog progress(tr("Importing tracks..."),
+                             tr("Abort"),
+                             0,
+                             fileNames.size(),
+                             this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+
+    DataPoints data, lastData;
+    QString uniqueName, lastName;
+
+    for (int i = 0; i < fileNames.size(); ++i)
+    {
+        progress.setValue(i);
+        if (progress.wasCanceled()) break;
+
+        // Add each track in its own transaction, so a failed import
+        // leaves nothing behind and the database isn't locked for long
+        if (!mDatabase.transaction())
+        {
+            QSqlError err = mDatabase.lastError();
+            QMessageBox::critical(0, tr("Query failed"), err.text());
+            break;
+        }
+
+        if (!importTrack(fileNames[i], data, uniqueName))
+        {
+            mDatabase.rollback();
+        }
+        else if (!mDatabase.commit())
+        {
+            QSqlError err = mDatabase.lastError();
+            QMessageBox::critical(0, tr("Query failed"), err.text());
+            mDatabase.rollback();
+        }
+        else
+        {
+            lastData = data;
+            lastName = uniqueName;
+        }
+    }
+
+    progress.setValue(fileNames.size());
+
+    mImporting = false;
+
+    // Import tracks that arrived in the meantime
+    if (!mPendingImports.isEmpty())
+    {
+        QTimer::singleShot(0, this, SLOT(importPendingFiles()));
+    }
+
+    // Show new tracks in the logbook
+    emit databaseChanged();
+
+    if (lastName.isEmpty()) return;
+
+    // Show the last track only
+    m_data = lastData;
+
+    // Clear optimum and phase index
+    m_optimal.clear();
+    mPhaseIndexValid = false;
+
+    // Initialize plot ranges
+    initRange(lastName);
+
+    emit dataLoaded();
+
+    // Remember current track
+    setTrackName(lastName);
+}
+
+void MainWindow::importPendingFiles()
+{
+    const QStringList fileNames = mPendingImports;
+    mPendingImports.clear();
+
+    importFiles(fileNames);
+}
+
+bool MainWindow::importTrack(
+        const QString &fileName,
+        DataPoints &data,
+        QString &uniqueName)
 {
     // Initialize settings object
     QSettings settings("FlySight", "Viewer");
@@ -850,14 +1029,14 @@ void MainWindow::importFile(
     if (!temporaryFile.open())
     {
         QMessageBox::critical(0, tr("Import failed"), tr("Couldn't create temporary file"));
-        return;
+        return false;
     }
 
     QFile file(fileName);
     if (!file.open(QIODevice::ReadOnly))
     {
         QMessageBox::critical(0, tr("Import failed"), tr("Couldn't read file"));
-        return;
+        return false;
     }
 
     // Copy to temporary file
@@ -866,9 +1045,9 @@ void MainWindow::importFile(
 
     // Read file data
     temporaryFile.seek(0);
-    if (import(&temporaryFile, m_data) < 2)
+    if (import(&temporaryFile, data) < 2)
     {
-        return;
+        return false;
     }
 
     // Get hash
@@ -878,26 +1057,28 @@ void MainWindow::importFile(
     if (!hash.addData(&temporaryFile))
     {
         QMessageBox::critical(0, tr("Import failed"), tr("Couldn't generate hash"));
-        return;
+        return false;
     }
 
     // Get name of file in database
-    QString uniqueName = QString(hash.result().toHex());
-    QString newName = QString("FlySight/Tracks/%1.csv").arg(uniqueName);
-    QString newPath = QDir(mDatabasePath).filePath(newName);
+    uniqueName = QString(hash.result().toHex());
+    QString newPath = TrackArchive::trackPath(mDatabasePath, uniqueName);
 
     QSqlQuery query(mDatabase);
 
     // Check if the file is in the database
-    if (!query.exec(QString("select * from files where file_name='%1'")
-                    .arg(uniqueName)))
+    query.prepare("select * from files where file_name = ?");
+    query.addBindValue(uniqueName);
+
+    if (!query.exec())
     {
         QSqlError err = query.lastError();
         QMessageBox::critical(0, tr("Query failed"), err.text());
-        return;
+        return false;
     }
 
     bool isPresent = query.next();
+    query.finish();
 
     if (isPresent && !mUseDatabase)
     {
@@ -907,135 +1088,212 @@ void MainWindow::importFile(
             QMessageBox::critical(0, tr("Operation failed"), tr("Couldn't delete track"));
         }
 
-        // Remove track from database
+        // Remove track and its jumps from database
         QSqlQuery query(mDatabase);
-        if (!query.exec(QString("delete from files where file_name='%1'").arg(uniqueName)))
+        query.prepare("delete from files where file_name = ?");
+        query.addBindValue(uniqueName);
+
+        if (!query.exec())
         {
             QSqlError err = query.lastError();
             QMessageBox::critical(0, tr("Query failed"), err.text());
         }
 
-        isPresent = false;
-    }
-
-    // Add an empty record if the file is not in the database
-    if (!isPresent)
-    {
-        if (!query.exec(QString("insert into files (file_name) values ('%1')")
-                      .arg(uniqueName)))
+        if (!TrackSegments::remove(mDatabase, uniqueName))
         {
-            QSqlError err = query.lastError();
+            QSqlError err = mDatabase.lastError();
             QMessageBox::critical(0, tr("Query failed"), err.text());
         }
-    }
-
-    // Initialize file data
-    init(m_data, uniqueName, true);
 
-    // Clear optimum
-    m_optimal.clear();
+        isPresent = false;
+    }
 
-    // Initialize plot ranges
-    initRange(uniqueName);
-
-    emit dataLoaded();
+    // Find jumps in the raw samples. Logs already in the database are
+    // only listed by jump if they were split when first imported.
+    const TrackSegments::Jumps jumps = TrackSegments::findJumps(
+                data, TrackSegments::classify(data));
+    const bool split = isPresent
+            ? TrackSegments::count(mDatabase, uniqueName) > 0
+            : TrackSegments::shouldSplit(data, jumps);
 
     // If the file is not already in the database
     if (!isPresent)
     {
+        // Add an empty record
+        if (!insertTrack(uniqueName)) return false;
+
         QDir(mDatabasePath).mkpath("FlySight/Tracks");
 
-        if (temporaryFile.copy(newPath))
+        // Keep a copy of the original file if the track can't be
+        // archived without loss
+        if (TrackArchive::save(TrackArchive::archivePath(mDatabasePath, uniqueName), data)
+                || temporaryFile.copy(TrackArchive::csvPath(mDatabasePath, uniqueName)))
+        {
+            updateTrackInfo(uniqueName, getDescription(fileName), data);
+        }
+        else
         {
-            QDateTime startTime = m_data.front().dateTime;
-            qint64 duration = startTime.msecsTo(m_data.back().dateTime);
+            QMessageBox::critical(0, tr("Import failed"), tr("Couldn't copy temporary file"));
+            return false;
+        }
+    }
 
-            int minLat = 900000000,  maxLat = -900000000;
-            int minLon = 1800000000, maxLon = -1800000000;
+    if (split)
+    {
+        // Each jump is listed as its own track, read from the log
+        const QString parentName = uniqueName;
+        const DataPoints log = data;
+
+        for (int i = 0; i < jumps.size(); ++i)
+        {
+            const QString jumpName = TrackSegments::jumpName(parentName, i + 1);
+            DataPoints jumpData = log.mid(jumps[i].start, jumps[i].end - jumps[i].start);
 
-            QVector< double > dt;
-            for (int i = 0; i < m_data.size(); ++i)
+            if (!isPresent)
             {
-                if (i > 0)
+                if (!insertTrack(jumpName)) return false;
+                updateTrackInfo(jumpName,
+                                tr("%1 (jump %2)").arg(getDescription(fileName)).arg(i + 1),
+                                jumpData);
+
+                if (!TrackSegments::write(mDatabase, jumpName, parentName, i + 1, log, jumps[i]))
                 {
-                    dt.push_back(m_data[i - 1].dateTime.msecsTo(m_data[i].dateTime));
+                    QSqlError err = mDatabase.lastError();
+                    QMessageBox::critical(0, tr("Query failed"), err.text());
+                    return false;
                 }
+            }
 
-                int lat = m_data[i].lat * 10000000;
-                int lon = m_data[i].lon * 10000000;
+            // Initialize jump data
+            init(jumpData, jumpName, true);
 
-                if (lat < minLat) minLat = lat;
-                if (lat > maxLat) maxLat = lat;
-                if (lon < minLon) minLon = lon;
-                if (lon > maxLon) maxLon = lon;
-            }
-            qSort(dt);
-            qint64 samplePeriod = dt[dt.size() / 2];
-
-            QDateTime importTime = QDateTime::currentDateTime();
-
-            if (!query.exec(QString("update files set "
-                                    "description='%1', "
-                                    "start_time='%2', "
-                                    "duration=%3, "
-                                    "sample_period=%4, "
-                                    "min_lat=%5, "
-                                    "max_lat=%6, "
-                                    "min_lon=%7, "
-                                    "max_lon=%8, "
-                                    "import_time='%9' "
-                                    "where file_name='%10'")
-                            .arg(getDescription(fileName))
-                            .arg(dateTimeToUTC(startTime))
-                            .arg(duration)
-                            .arg(samplePeriod)
-                            .arg(minLat)
-                            .arg(maxLat)
-                            .arg(minLon)
-                            .arg(maxLon)
-                            .arg(dateTimeToUTC(importTime))
-                            .arg(uniqueName)))
+            const TrackSummary::Summary summary = TrackSummary::compute(jumpData);
+            TrackSummary::write(mDatabase, jumpName, mReprocessQueue->signature(), &summary);
+
+            // Open the first jump
+            if (i == 0)
             {
-                QSqlError err = query.lastError();
-                QMessageBox::critical(0, tr("Query failed"), err.text());
+                uniqueName = jumpName;
+                data = jumpData;
             }
         }
-        else
-        {
-            QMessageBox::critical(0, tr("Import failed"), tr("Couldn't copy temporary file"));
-        }
+    }
+    else
+    {
+        // Initialize file data
+        init(data, uniqueName, true);
+
+        // Summarize while the track is in memory
+        const TrackSummary::Summary summary = TrackSummary::compute(data);
+        TrackSummary::write(mDatabase, uniqueName, mReprocessQueue->signature(), &summary);
     }
 
     // Delete temporary file
     temporaryFile.close();
     temporaryFile.remove();
 
-    // Remember current track
-    setTrackName(uniqueName);
+    return true;
+}
+
+bool MainWindow::insertTrack(
+        const QString &trackName)
+{
+    QSqlQuery query(mDatabase);
+    query.prepare("insert into files (file_name) values (?)");
+    query.addBindValue(trackName);
+
+    if (!query.exec())
+    {
+        QSqlError err = query.lastError();
+        QMessageBox::critical(0, tr("Query failed"), err.text());
+        return false;
+    }
+
+    return true;
+}
+
+void MainWindow::updateTrackInfo(
+        const QString &trackName,
+        const QString &description,
+        const DataPoints &data)
+{
+    QDateTime startTime = data.front().dateTime;
+    qint64 duration = startTime.msecsTo(data.back().dateTime);
+
+    int minLat = 900000000,  maxLat = -900000000;
+    int minLon = 1800000000, maxLon = -1800000000;
+
+    QVector< double > dt;
+    for (int i = 0; i < data.size(); ++i)
+    {
+        if (i > 0)
+        {
+            dt.push_back(data[i - 1].dateTime.msecsTo(data[i].dateTime));
+        }
+
+        int lat = data[i].lat * 10000000;
+        int lon = data[i].lon * 10000000;
+
+        if (lat < minLat) minLat = lat;
+        if (lat > maxLat) maxLat = lat;
+        if (lon < minLon) minLon = lon;
+        if (lon > maxLon) maxLon = lon;
+    }
+    qSort(dt);
+    qint64 samplePeriod = dt.isEmpty() ? 0 : dt[dt.size() / 2];
+
+    QDateTime importTime = QDateTime::currentDateTime();
+
+    QSqlQuery query(mDatabase);
+    query.prepare("update files set "
+                  "description = ?, "
+                  "start_time = ?, "
+                  "duration = ?, "
+                  "sample_period = ?, "
+                  "min_lat = ?, "
+                  "max_lat = ?, "
+                  "min_lon = ?, "
+                  "max_lon = ?, "
+                  "import_time = ? "
+                  "where file_name = ?");
+    query.addBindValue(description);
+    query.addBindValue(dateTimeToUTC(startTime));
+    query.addBindValue(duration);
+    query.addBindValue(samplePeriod);
+    query.addBindValue(minLat);
+    query.addBindValue(maxLat);
+    query.addBindValue(minLon);
+    query.addBindValue(maxLon);
+    query.addBindValue(dateTimeToUTC(importTime));
+    query.addBindValue(trackName);
+
+    if (!query.exec())
+    {
+        QSqlError err = query.lastError();
+        QMessageBox::critical(0, tr("Query failed"), err.text());
+    }
 }
 
 void MainWindow::importFromDatabase(
         const QString &uniqueName)
 {
-    // Get name of file in database
-    QString newName = QString("FlySight/Tracks/%1.csv").arg(uniqueName);
-    QString newPath = QDir(mDatabasePath).filePath(newName);
-
-    QFile file(newPath);
-    if (!file.open(QIODevice::ReadOnly))
+    // Read file data, or the slice of its log for a jump
+    DataPoints data;
+    if (TrackSegments::load(mDatabase, mDatabasePath, uniqueName, data) >= 2)
+    {
+        init(data, uniqueName, false);
+    }
+    else if (data.isEmpty())
     {
         QMessageBox::critical(0, tr("Import failed"), tr("Couldn't read file"));
         return;
     }
 
-    // Read file data
-    if (import(&file, m_data) >= 2)
-    {
-        init(m_data, uniqueName, false);
-    }
+    m_data = data;
 
-    // Clear optimum
+    // Clear optimum and phase index
     m_optimal.clear();
+    mPhaseIndexValid = false;
 
     // Initialize plot ranges
     initRange(uniqueName);
@@ -1049,8 +1307,27 @@ void MainWindow::importFromDatabase(
 void MainWindow::setTrackName(
         const QString &trackName)
 {
+    const QString oldTrackName = mTrackName;
+
     mTrackName = trackName;
-    emit databaseChanged();
+    updateReprocessQueue();
+
+    emit trackChanged(oldTrackName);
+    emit trackChanged(trackName);
+}
+
+void MainWindow::onTrackWriteFailed(
+        const QString &error)
+{
+    QMessageBox::critical(0, tr("Query failed"), error);
+}
+
+void MainWindow::onReprocessFailed(
+        const QString &trackName,
+        const QString &error)
+{
+    QMessageBox::critical(0, tr("Query failed"),
+                          tr("Couldn't save summary for %1: %2").arg(trackName).arg(error));
 }
 
 void MainWindow::setSelectedTracks(
@@ -1067,8 +1344,11 @@ void MainWindow::setTrackDescription(
     QSqlQuery query(mDatabase);
 
     // Check the old description
-    if (!query.exec(QString("select * from files where (file_name='%1' and description='%2')")
-                    .arg(trackName).arg(description)))
+    query.prepare("select * from files where file_name = ? and description = ?");
+    query.addBindValue(trackName);
+    query.addBindValue(description);
+
+    if (!query.exec())
     {
         QSqlError err = query.lastError();
         QMessageBox::critical(0, tr("Query failed"), err.text());
@@ -1079,15 +1359,18 @@ void MainWindow::setTrackDescription(
     if (query.next()) return;
 
     // Change the description
-    if (!query.exec(QString("update files set description='%1' where file_name='%2'")
-                    .arg(description).arg(trackName)))
+    query.prepare("update files set description = ? where file_name = ?");
+    query.addBindValue(description);
+    query.addBindValue(trackName);
+
+    if (!query.exec())
     {
         QSqlError err = query.lastError();
         QMessageBox::critical(0, tr("Query failed"), err.text());
         return;
     }
 
-    emit databaseChanged();
+    emit trackChanged(trackName);
 }
 
 QString MainWindow::trackDescription(
@@ -1096,7 +1379,10 @@ QString MainWindow::trackDescription(
     QSqlQuery query(mDatabase);
 
     // Get the description
-    if (!query.exec(QString("select description from files where file_name='%1'").arg(trackName)))
+    query.prepare("select description from files where file_name = ?");
+    query.addBindValue(trackName);
+
+    if (!query.exec())
     {
         QSqlError err = query.lastError();
         QMessageBox::critical(0, tr("Query failed"), err.text());
@@ -1113,7 +1399,10 @@ QDateTime MainWindow::trackStartTime(
     QSqlQuery query(mDatabase);
 
     // Get the start time
-    if (!query.exec(QString("select start_time from files where file_name='%1'").arg(trackName)))
+    query.prepare("select start_time from files where file_name = ?");
+    query.addBindValue(trackName);
+
+    if (!query.exec())
     {
         QSqlError err = query.lastError();
         QMessageBox::critical(0, tr("Query failed"), err.text());
@@ -1138,21 +1427,15 @@ void MainWindow::setTrackChecked(
         }
         else
         {
-            // Get name of file in database
-            QString newName = QString("FlySight/Tracks/%1.csv").arg(trackName);
-            QString newPath = QDir(mDatabasePath).filePath(newName);
-
-            QFile file(newPath);
-            if (!file.open(QIODevice::ReadOnly))
+            // Read file data, or the slice of its log for a jump
+            if (TrackSegments::load(mDatabase, mDatabasePath, trackName, data) >= 2)
             {
-                QMessageBox::critical(0, tr("Import failed"), tr("Couldn't read file"));
-                return;
+                init(data, trackName, false);
             }
-
-            // Read file data
-            if (import(&file, data) >= 2)
+            else if (data.isEmpty())
             {
-                init(m_data, trackName, false);
+                QMessageBox::critical(0, tr("Import failed"), tr("Couldn't read file"));
+                return;
             }
         }
 
@@ -1163,181 +1446,42 @@ void MainWindow::setTrackChecked(
         mCheckedTracks.remove(trackName);
     }
 
+    updateReprocessQueue();
+
+    emit trackChanged(trackName);
     emit dataChanged();
 }
 
 bool MainWindow::trackChecked(
         const QString &trackName) const
-{
-    return mCheckedTracks.contains(trackName);
-}
-
-void MainWindow::importFromCheckedTrack(
-        const QString &uniqueName)
-{
-    // Copy track data
-    m_data = mCheckedTracks[uniqueName];
-
-    // Clear optimum
-    m_optimal.clear();
-
-    // Initialize plot ranges
-    initRange(uniqueName);
-
-    emit dataLoaded();
-
-    // Remember current track
-    setTrackName(uniqueName);
-}
-
-void MainWindow::importSingleRow(
-        QString line,
-        DataPoints &data)
-{
-    QStringList cols = line.split(",");
-
-    if (cols[0] == "$GNSS")
-    {
-        DataPoint pt;
-
-        pt.dateTime = QDateTime::fromString(cols[1], Qt::ISODate);
-
-        pt.hasGeodetic = true;
-
-        pt.lat   = cols[2].toDouble();
-        pt.lon   = cols[3].toDouble();
-        pt.hMSL  = cols[4].toDouble();
-
-        pt.velN  = cols[5].toDouble();
-        pt.velE  = cols[6].toDouble();
-        pt.velD  = cols[7].toDouble();
-
-        pt.hAcc  = cols[8].toDouble();
-        pt.vAcc  = cols[9].toDouble();
-        pt.sAcc  = cols[10].toDouble();
-
-        pt.numSV = cols[11].toInt();
-
-        data.append(pt);
-    }
-}
-
-void MainWindow::importNew(
-        QTextStream &in,
-        DataPoints &data,
-        QString firstLine)
-{
-    data.clear();
-
-    importSingleRow(firstLine, data);
-
-    while (!in.atEnd())
-    {
-        importSingleRow(in.readLine(), data);
-    }
-}
-
-void MainWindow::importOld(
-        QTextStream &in,
-        DataPoints &data,
-        QString firstLine)
-{
-    // Column enumeration
-    typedef enum {
-        Time = 0,
-        Lat,
-        Lon,
-        HMSL,
-        VelN,
-        VelE,
-        VelD,
-        HAcc,
-        VAcc,
-        SAcc,
-        Heading,
-        CAcc,
-        NumSV
-    } Columns;
-
-    // Read column labels
-    QMap< int, int > colMap;
-
-    QStringList cols = firstLine.split(",");
-
-    for (int i = 0; i < cols.size(); ++i)
-    {
-        const QString &s = cols[i];
-
-        if (s == "time")    colMap[Time]    = i;
-        if (s == "lat")     colMap[Lat]     = i;
-        if (s == "lon")     colMap[Lon]     = i;
-        if (s == "hMSL")    colMap[HMSL]    = i;
-        if (s == "velN")    colMap[VelN]    = i;
-        if (s == "velE")    colMap[VelE]    = i;
-        if (s == "velD")    colMap[VelD]    = i;
-        if (s == "hAcc")    colMap[HAcc]    = i;
-        if (s == "vAcc")    colMap[VAcc]    = i;
-        if (s == "sAcc")    colMap[SAcc]    = i;
-        if (s == "numSV")   colMap[NumSV]   = i;
-    }
-
-    // Skip next row
-    if (!in.atEnd()) in.readLine();
-
-    data.clear();
-
-    while (!in.atEnd())
-    {
-        QString line = in.readLine();
-        QStringList cols = line.split(",");
-
-        DataPoint pt;
-
-        pt.dateTime = QDateTime::fromString(cols[colMap[Time]], Qt::ISODate);
-
-        pt.hasGeodetic = true;
+{
+    return mCheckedTracks.contains(trackName);
+}
 
-        pt.lat   = cols[colMap[Lat]].toDouble();
-        pt.lon   = cols[colMap[Lon]].toDouble();
-        pt.hMSL  = cols[colMap[HMSL]].toDouble();
+void MainWindow::importFromCheckedTrack(
+        const QString &uniqueName)
+{
+    // Copy track data
+    m_data = mCheckedTracks[uniqueName];
 
-        pt.velN  = cols[colMap[VelN]].toDouble();
-        pt.velE  = cols[colMap[VelE]].toDouble();
-        pt.velD  = cols[colMap[VelD]].toDouble();
+    // Clear optimum and phase index
+    m_optimal.clear();
+    mPhaseIndexValid = false;
 
-        pt.hAcc  = cols[colMap[HAcc]].toDouble();
-        pt.vAcc  = cols[colMap[VAcc]].toDouble();
-        pt.sAcc  = cols[colMap[SAcc]].toDouble();
+    // Initialize plot ranges
+    initRange(uniqueName);
 
-        pt.numSV = cols[colMap[NumSV]].toInt();
+    emit dataLoaded();
 
-        data.append(pt);
-    }
+    // Remember current track
+    setTrackName(uniqueName);
 }
 
 int MainWindow::import(
         QIODevice *device,
         DataPoints &data)
 {
-    QTextStream in(device);
-
-    if (!in.atEnd())
-    {
-        QString firstLine = in.readLine();
-
-        if (firstLine[0] == '$')
-        {
-            // Import from new format
-            importNew(in, data, firstLine);
-        }
-        else
-        {
-            // Import from old format
-            importOld(in, data, firstLine);
-        }
-    }
-
-    return data.length();
+    return TrackUtil::import(device, data);
 }
 
 void MainWindow::init(
@@ -1364,15 +1508,7 @@ void MainWindow::init(
 void MainWindow::initTime(
         DataPoints &data)
 {
-    const DataPoint &dp0 = data[0];
-    qint64 start = dp0.dateTime.toMSecsSinceEpoch();
-
-    for (int i = 0; i < data.size(); ++i)
-    {
-        DataPoint &dp = data[i];
-        qint64 end = dp.dateTime.toMSecsSinceEpoch();
-        dp.t = (double) (end - start) / 1000;
-    }
+    TrackUtil::initTime(data);
 }
 
 void MainWindow::initExit(
@@ -1389,40 +1525,7 @@ void MainWindow::initExit(
     }
     else
     {
-        bool foundExit = false;
-
-        for (int i = 1; i < data.size() && !foundExit; ++i)
-        {
-            const DataPoint &dp1 = data[i - 1];
-            const DataPoint &dp2 = data[i];
-
-            // Get interpolation coefficient
-            const double velD = A_GRAVITY;
-            const double a = (velD - dp1.velD) / (dp2.velD - dp1.velD);
-
-            // Check vertical speed
-            if (a < 0 || 1 < a) continue;
-
-            // Check accuracy
-            const double vAcc = dp1.vAcc + a * (dp2.vAcc - dp1.vAcc);
-            if (vAcc > 10) continue;
-
-            // Check acceleration
-            const double az = dp1.az + a * (dp2.az - dp1.az);
-            if (az < A_GRAVITY / 5.) continue;
-
-            // Determine exit
-            const qint64 t1 = dp1.dateTime.toMSecsSinceEpoch();
-            const qint64 t2 = dp2.dateTime.toMSecsSinceEpoch();
-            start = t1 + a * (t2 - t1) - velD / az * 1000.;
-            foundExit = true;
-        }
-
-        if (!foundExit)
-        {
-            const DataPoint &dp0 = data[0];
-            start = dp0.dateTime.toMSecsSinceEpoch();
-        }
+        start = TrackUtil::findExit(data);
     }
 
     if (initDatabase)
@@ -1431,12 +1534,7 @@ void MainWindow::initExit(
         setDatabaseValue(trackName, "exit", dateTimeToUTC(dt));
     }
 
-    for (int i = 0; i < data.size(); ++i)
-    {
-        DataPoint &dp = data[i];
-        qint64 end = dp.dateTime.toMSecsSinceEpoch();
-        dp.t = (double) (end - start) / 1000;
-    }
+    TrackUtil::setExit(data, start);
 }
 
 void MainWindow::initAltitude(
@@ -1465,38 +1563,13 @@ void MainWindow::initAltitude(
         setDatabaseValue(trackName, "ground", QString::number(ground, 'f', 3));
     }
 
-    for (int i = 0; i < data.size(); ++i)
-    {
-        DataPoint &dp = data[i];
-        dp.z = dp.hMSL - ground;
-    }
+    TrackUtil::initAltitude(data, ground);
 }
 
 void MainWindow::initAcceleration(
         DataPoints &data)
 {
-    for (int i = 0; i < data.size(); ++i)
-    {
-        DataPoint &dp = data[i];
-
-        // Acceleration
-        double accelN = getSlope(i, DataPoint::northSpeedRaw);
-        double accelE = getSlope(i, DataPoint::eastSpeedRaw);
-        double accelD = getSlope(i, DataPoint::verticalSpeed);
-
-        // Calculate acceleration in direction of flight
-        const double vh = sqrt(dp.velN * dp.velN + dp.velE * dp.velE);
-        dp.ax = (accelN * dp.velN + accelE * dp.velE) / vh;
-
-        // Calculate acceleration perpendicular to flight
-        dp.ay = (accelE * dp.velN - accelN * dp.velE) / vh;
-
-        // Calculate vertical acceleration
-        dp.az = accelD;
-
-        // Calculate total acceleration
-        dp.amag = sqrt(accelN * accelN + accelE * accelE + accelD * accelD);
-    }
+    TrackUtil::initAcceleration(data);
 }
 
 void MainWindow::updateVelocity(
@@ -1504,7 +1577,7 @@ void MainWindow::updateVelocity(
         QString trackName,
         bool initDatabase)
 {
-    if (dataSize() == 0) return;
+    if (data.isEmpty()) return;
 
     double windE, windN;
     getWind(trackName, &windE, &windN);
@@ -1515,93 +1588,6 @@ void MainWindow::updateVelocity(
         setDatabaseValue(trackName, "wind_n", QString::number(windN, 'f', 2));
     }
 
-    if (mWindAdjustment)
-    {
-        // Wind-adjusted position
-        for (int i = 0; i < data.size(); ++i)
-        {
-            const DataPoint &dp0 = interpolateDataT(0);
-            DataPoint &dp = data[i];
-
-            double distance = getDistance(dp0, dp);
-            double bearing = getBearing(dp0, dp);
-
-            dp.x = distance * sin(bearing) - windE * dp.t;
-            dp.y = distance * cos(bearing) - windN * dp.t;
-        }
-
-        // Wind-adjusted velocity
-        for (int i = 0; i < data.size(); ++i)
-        {
-            DataPoint &dp = data[i];
-
-            dp.vx = dp.velE - windE;
-            dp.vy = dp.velN - windN;
-        }
-    }
-    else
-    {
-        // Unadjusted position
-        for (int i = 0; i < data.size(); ++i)
-        {
-            const DataPoint &dp0 = interpolateDataT(0);
-            DataPoint &dp = data[i];
-
-            double distance = getDistance(dp0, dp);
-            double bearing = getBearing(dp0, dp);
-
-            dp.x = distance * sin(bearing);
-            dp.y = distance * cos(bearing);
-        }
-
-        // Unadjusted velocity
-        for (int i = 0; i < data.size(); ++i)
-        {
-            DataPoint &dp = data[i];
-
-            dp.vx = dp.velE;
-            dp.vy = dp.velN;
-        }
-    }
-
-    // Distance measurements
-    double dist2D = 0, dist3D = 0;
-
-    for (int i = 0; i < data.size(); ++i)
-    {
-        DataPoint &dp = data[i];
-
-        if (i > 0)
-        {
-            const DataPoint &dpPrev = data[i - 1];
-
-            double dx = dp.x - dpPrev.x;
-            double dy = dp.y - dpPrev.y;
-            double dh = sqrt(dx * dx + dy * dy);
-            double dz = dp.hMSL - dpPrev.hMSL;
-
-            dist2D += dh;
-            dist3D += sqrt(dh * dh + dz * dz);
-        }
-
-        dp.dist2D = dist2D;
-        dp.dist3D = dist3D;
-    }
-
-    // Adjust for exit
-    DataPoint dp0 = interpolateDataT(0);
-
-    for (int i = 0; i < data.size(); ++i)
-    {
-        DataPoint &dp = data[i];
-
-        dp.x -= dp0.x;
-        dp.y -= dp0.y;
-
-        dp.dist2D -= dp0.dist2D;
-        dp.dist3D -= dp0.dist3D;
-    }
-
     QString value;
     double theta0;
     if (getDatabaseValue(trackName, "course", value))
@@ -1618,45 +1604,8 @@ void MainWindow::updateVelocity(
         setDatabaseValue(trackName, "course", QString::number(theta0, 'f', 5));
     }
 
-    // Cumulative heading
-    double prevHeading;
-    bool firstHeading = true;
-
-    for (int i = 0; i < data.size(); ++i)
-    {
-        DataPoint &dp = data[i];
-
-        // Calculate heading
-        dp.heading = atan2(dp.vx, dp.vy) / PI * 180;
-
-        // Calculate heading accuracy
-        const double s = DataPoint::totalSpeed(dp);
-        if (s != 0) dp.cAcc = dp.sAcc / s;
-        else        dp.cAcc = 0;
-
-        // Adjust heading
-        if (!firstHeading)
-        {
-            while (dp.heading <  prevHeading - 180) dp.heading += 360;
-            while (dp.heading >= prevHeading + 180) dp.heading -= 360;
-        }
-
-        // Relative heading
-        dp.theta = dp.heading - theta0;
-
-        firstHeading = false;
-        prevHeading = dp.heading;
-    }
-
-    // Parameters depending on velocity
-    for (int i = 0; i < data.size(); ++i)
-    {
-        DataPoint &dp = data[i];
-
-        dp.curv = getSlope(i, DataPoint::diveAngle);
-        dp.accel = getSlope(i, DataPoint::totalSpeed);
-        dp.omega = getSlope(i, DataPoint::course);
-    }
+    // Position, velocity, distance and heading
+    TrackUtil::updateVelocity(data, windE, windN, theta0, mWindAdjustment);
 
     // Initialize aerodynamics
     initAerodynamics(data);
@@ -1665,119 +1614,28 @@ void MainWindow::updateVelocity(
 void MainWindow::initAerodynamics(
         DataPoints &data)
 {
-    for (int i = 0; i < data.size(); ++i)
-    {
-        DataPoint &dp = data[i];
-
-        // Acceleration
-        double accelN = getSlope(i, DataPoint::northSpeed);
-        double accelE = getSlope(i, DataPoint::eastSpeed);
-        double accelD = getSlope(i, DataPoint::verticalSpeed);
-
-        // Subtract acceleration due to gravity
-        accelD -= A_GRAVITY;
-
-        // Calculate acceleration due to drag
-        const double vel = DataPoint::totalSpeed(dp);
-        const double proj = (accelN * dp.vy + accelE * dp.vx + accelD * dp.velD) / vel;
-
-        const double dragN = proj * dp.vy / vel;
-        const double dragE = proj * dp.vx / vel;
-        const double dragD = proj * dp.velD / vel;
-
-        const double accelDrag = sqrt(dragN * dragN + dragE * dragE + dragD * dragD);
-
-        // Calculate acceleration due to lift
-        const double liftN = accelN - dragN;
-        const double liftE = accelE - dragE;
-        const double liftD = accelD - dragD;
-
-        const double accelLift = sqrt(liftN * liftN + liftE * liftE + liftD * liftD);
-
-        // From https://en.wikipedia.org/wiki/Atmospheric_pressure#Altitude_variation
-        const double airPressure = SL_PRESSURE * pow(1 - LAPSE_RATE * dp.hMSL / SL_TEMP, A_GRAVITY * MM_AIR / GAS_CONST / LAPSE_RATE);
-
-        // From https://en.wikipedia.org/wiki/Lapse_rate
-        const double temperature = SL_TEMP - LAPSE_RATE * dp.hMSL;
-
-        // From https://en.wikipedia.org/wiki/Density_of_air
-        const double airDensity = airPressure / (GAS_CONST / MM_AIR) / temperature;
-
-        // From https://en.wikipedia.org/wiki/Dynamic_pressure
-        const double dynamicPressure = airDensity * vel * vel / 2;
-
-        // Calculate lift and drag coefficients
-        dp.lift = m_mass * accelLift / dynamicPressure / m_planformArea;
-        dp.drag = m_mass * accelDrag / dynamicPressure / m_planformArea;
-    }
+    TrackUtil::initAerodynamics(data, m_mass, m_planformArea);
 }
 
 double MainWindow::getSlope(
         const int center,
         double (*value)(const DataPoint &)) const
 {
-    int iMin = qMax (0, center - 4);
-    int iMax = qMin (m_data.size () - 1, center + 4);
-
-    double sumx = 0, sumy = 0, sumxx = 0, sumxy = 0;
-
-    for (int i = iMin; i <= iMax; ++i)
-    {
-        const DataPoint &dp = m_data[i];
-        double y = value(dp);
-
-        sumx += dp.t;
-        sumy += y;
-        sumxx += dp.t * dp.t;
-        sumxy += dp.t * y;
-    }
-
-    int n = iMax - iMin + 1;
-    return (sumxy - sumx * sumy / n) / (sumxx - sumx * sumx / n);
+    return TrackUtil::getSlope(m_data, center, value);
 }
 
 double MainWindow::getDistance(
         const DataPoint &dp1,
         const DataPoint &dp2)
 {
-    if (!mWindAdjustment && dp1.hasGeodetic && dp2.hasGeodetic)
-    {
-        const Geodesic &geod = Geodesic::WGS84();
-        double s12;
-
-        geod.Inverse(dp1.lat, dp1.lon, dp2.lat, dp2.lon, s12);
-
-        return s12;
-    }
-    else
-    {
-        const double dx = dp2.x - dp1.x;
-        const double dy = dp2.y - dp1.y;
-
-        return sqrt(dx * dx + dy * dy);
-    }
+    return TrackUtil::getDistance(dp1, dp2, mWindAdjustment);
 }
 
 double MainWindow::getBearing(
         const DataPoint &dp1,
         const DataPoint &dp2)
 {
-    if (!mWindAdjustment && dp1.hasGeodetic && dp2.hasGeodetic)
-    {
-        const Geodesic &geod = Geodesic::WGS84();
-        double azi1, azi2;
-
-        geod.Inverse(dp1.lat, dp1.lon, dp2.lat, dp2.lon, azi1, azi2);
-
-        return azi1 / 180 * PI;
-    }
-    else
-    {
-        const double dx = dp2.x - dp1.x;
-        const double dy = dp2.y - dp1.y;
-
-        return atan2(dx, dy);
-    }
+    return TrackUtil::getBearing(dp1, dp2, mWindAdjustment);
 }
 
 void MainWindow::setMark(
@@ -2127,8 +1985,12 @@ void MainWindow::on_actionWind_triggered()
     mWindAdjustment = !mWindAdjustment;
     m_ui->actionWind->setChecked(mWindAdjustment);
 
+    // Reprocess logbook with the new setting
+    updateReprocessQueue();
+
     // Update plot data
     updateVelocity(m_data, mTrackName, false);
+    mPhaseIndexValid = false;
 
     // Update checked tracks
     QMap< QString, DataPoints >::iterator p;
@@ -2347,10 +2209,14 @@ void MainWindow::on_actionPreferences_triggered()
 
             // Open/create database
             initDatabase();
+            mReprocessQueue->start(mDatabasePath);
 
             // Update views
             emit databaseChanged();
         }
+
+        // Reprocess tracks if derivation settings changed
+        updateReprocessQueue();
     }
 }
 
@@ -2384,10 +2250,8 @@ void MainWindow::on_actionImportVideo_triggered()
         videoView->setMainWindow(this);
 
         // Set up notifications for video view
-        connect(this, SIGNAL(dataChanged()),
-                videoView, SLOT(updateView()));
-        connect(this, SIGNAL(mediaCursorChanged()),
-                videoView, SLOT(updateView()));
+        mViewScheduler->addView(videoView, dockWidget, ViewScheduler::Data, "updateView");
+        mViewScheduler->addView(videoView, dockWidget, ViewScheduler::MediaCursor, "updateView");
         connect(this, SIGNAL(mediaPaused()),
                 videoView, SLOT(pauseMedia()));
 
@@ -2433,7 +2297,10 @@ void MainWindow::on_actionExportKML_triggered()
         }
 
         // Export to KML file
-        exportToKML(&file, description);
+        if (!exportToKML(&file, description, false))
+        {
+            QMessageBox::critical(0, tr("FlySight Viewer"), tr("Couldn't write KML file."));
+        }
     }
 }
 
@@ -2459,7 +2326,12 @@ void MainWindow::on_actionExportToGoogleEarth_triggered()
     }
 
     // Export to KML file
-    exportToKML(&temporaryFile, description);
+    if (!exportToKML(&temporaryFile, description, true))
+    {
+        QMessageBox::critical(0, tr("FlySight Viewer"), tr("Couldn't write temporary KML file."));
+        temporaryFile.remove();
+        return;
+    }
 
     // Open in Google Earth
     temporaryFile.close();
@@ -2468,56 +2340,34 @@ void MainWindow::on_actionExportToGoogleEarth_triggered()
 
 bool MainWindow::exportToKML(
         QIODevice *device,
-        QString name)
+        QString name,
+        bool speedColors)
 {
-    QTextStream stream(device);
+    KmlWriter writer;
+    writer.setName(name);
+    writer.setSpeedColors(speedColors);
 
-    // Write headers
-    stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << endl;
-    stream << "<kml xmlns=\"http://www.opengis.net/kml/2.2\">" << endl;
-    stream << "  <Placemark>" << endl;
-    stream << "    <name>" << name << "</name>" << endl;
-    stream << "    <LineString>" << endl;
-    stream << "      <altitudeMode>absolute</altitudeMode>" << endl;
-    stream << "      <coordinates>" << endl;
+    // Current track
+    writer.addTrack(name, m_data, rangeLower(), rangeUpper());
 
-    double lower = rangeLower();
-    double upper = rangeUpper();
-
-    bool first = true;
-    for (int i = 0; i < dataSize(); ++i)
+    // Checked tracks, over the same range relative to exit
+    QMap< QString, DataPoints >::const_iterator p;
+    for (p = mCheckedTracks.constBegin();
+         p != mCheckedTracks.constEnd();
+         ++p)
     {
-        const DataPoint &dp = dataPoint(i);
+        if (p.key() == mTrackName) continue;
 
-        if (lower <= dp.t && dp.t <= upper)
+        QString description = trackDescription(p.key());
+        if (description.isEmpty())
         {
-            if (first)
-            {
-                stream << "        ";
-                first = false;
-            }
-            else
-            {
-                stream << " ";
-            }
-
-            stream << QString("%1,%2,%3").arg(dp.lon, 0, 'f', 7).arg(dp.lat, 0, 'f', 7).arg(dp.hMSL, 0, 'f', 3);
+            description = dateTimeToUTC(trackStartTime(p.key()));
         }
-    }
 
-    if (!first)
-    {
-        stream << endl;
+        writer.addTrack(description, p.value(), rangeLower(), rangeUpper());
     }
 
-
-    // Write footers
-    stream << "      </coordinates>" << endl;
-    stream << "    </LineString>" << endl;
-    stream << "  </Placemark>" << endl;
-    stream << "</kml>" << endl;
-
-    return true;
+    return writer.write(device);
 }
 
 void MainWindow::on_actionExportPlot_triggered()
@@ -2546,36 +2396,50 @@ void MainWindow::on_actionExportPlot_triggered()
             return;
         }
 
-        QTextStream stream(&file);
+        ExportWriter out(&file);
 
-        // Write header
-        stream << "Time (UTC)";
-        stream << "," << m_ui->plotArea->xValue()->title(m_units);
+        // Visible plot values
+        PlotValue *xValue = m_ui->plotArea->xValue();
+        QVector< PlotValue * > yValues;
         for (int j = 0; j < DataPlot::yaLast; ++j)
         {
             if (!m_ui->plotArea->yValue(j)->visible()) continue;
-            stream << "," << m_ui->plotArea->yValue(j)->title(m_units);
+            yValues.append(m_ui->plotArea->yValue(j));
+        }
+
+        // Write header
+        out.write("Time (UTC)");
+        out.write(',');
+        out.write(xValue->title(m_units));
+        for (int j = 0; j < yValues.size(); ++j)
+        {
+            out.write(',');
+            out.write(yValues[j]->title(m_units));
         }
-        stream << endl;
+        out.write('\n');
 
-        double lower = rangeLower();
-        double upper = rangeUpper();
+        // Only points within the range
+        const int start = TrackUtil::findIndexBelowT(m_data, rangeLower()) + 1;
+        const int end = TrackUtil::findIndexAboveT(m_data, rangeUpper());
 
-        for (int i = 0; i < dataSize(); ++i)
+        for (int i = start; i < end; ++i)
         {
-            const DataPoint &dp = dataPoint(i);
+            const DataPoint &dp = m_data[i];
 
-            if (lower <= dp.t && dp.t <= upper)
+            out.writeDateTime(dp.dateTime);
+            out.write(',');
+            out.writeNumber(xValue->value(dp, m_units));
+            for (int j = 0; j < yValues.size(); ++j)
             {
-                stream << dateTimeToUTC(dp.dateTime);
-                stream << "," << m_ui->plotArea->xValue()->value(dp, m_units);
-                for (int j = 0; j < DataPlot::yaLast; ++j)
-                {
-                    if (!m_ui->plotArea->yValue(j)->visible()) continue;
-                    stream << QString(",%1").arg(m_ui->plotArea->yValue(j)->value(dp, m_units), 0, 'f');
-                }
-                stream << endl;
+                out.write(',');
+                out.writeFixed(yValues[j]->value(dp, m_units), 6);
             }
+            out.write('\n');
+        }
+
+        if (!out.flush())
+        {
+            QMessageBox::critical(0, tr("FlySight Viewer"), tr("Couldn't write plot file."));
         }
     }
 }
@@ -2606,47 +2470,41 @@ void MainWindow::on_actionExportTrack_triggered()
             return;
         }
 
-        QTextStream stream(&file);
-
-        // Write header
-        stream << "time,lat,lon,hMSL,velN,velE,velD,hAcc,vAcc,sAcc,heading,cAcc,gpsFix,numSV" << endl;
-        stream << ",(deg),(deg),(m),(m/s),(m/s),(m/s),(m),(m),(m/s),(deg),(deg),," << endl;
-
-        double lower = rangeLower();
-        double upper = rangeUpper();
-
-        for (int i = 0; i < dataSize(); ++i)
+        if (!TrackUtil::exportToCSV(&file, m_data, rangeLower(), rangeUpper()))
         {
-            const DataPoint &dp = dataPoint(i);
-
-            if (lower <= dp.t && dp.t <= upper)
-            {
-                stream << dateTimeToUTC(dp.dateTime) << ",";
-
-                stream << QString::number(dp.lat, 'f', 7) << ",";
-                stream << QString::number(dp.lon, 'f', 7) << ",";
-                stream << QString::number(dp.hMSL, 'f', 3) << ",";
+            QMessageBox::critical(0, tr("FlySight Viewer"), tr("Couldn't write track file."));
+        }
+    }
+}
 
-                stream << QString::number(dp.velN, 'f', 2) << ",";
-                stream << QString::number(dp.velE, 'f', 2) << ",";
-                stream << QString::number(dp.velD, 'f', 2) << ",";
+void MainWindow::on_actionExportColumns_triggered()
+{
+    // Initialize settings object
+    QSettings settings("FlySight", "Viewer");
 
-                stream << QString::number(dp.hAcc, 'f', 3) << ",";
-                stream << QString::number(dp.vAcc, 'f', 3) << ",";
-                stream << QString::number(dp.sAcc, 'f', 2) << ",";
+    // Get last file read
+    QString rootFolder = settings.value("columnFolder").toString();
 
-                // Get adjusted heading
-                double heading = dp.heading;
-                while (heading <  0)   heading += 360;
-                while (heading >= 360) heading -= 360;
+    QString fileName = QFileDialog::getSaveFileName(this,
+                                                    tr("Export Columns"),
+                                                    rootFolder,
+                                                    tr("Column Files (*.fsc *.FSC)"));
 
-                stream << QString::number(heading, 'f', 5) << ",";
-                stream << QString::number(dp.cAcc, 'f', 5) << ",";
+    if (!fileName.isEmpty())
+    {
+        // Remember last file read
+        settings.setValue("columnFolder", QFileInfo(fileName).absoluteFilePath());
 
-                stream << ",";  // gpsFix
+        // Get description for track
+        QString description = trackDescription(trackName());
+        if (description.isEmpty())
+        {
+            description = dateTimeToUTC(trackStartTime(trackName()));
+        }
 
-                stream << QString::number(dp.numSV) << endl;
-            }
+        if (!ColumnWriter::exportTrack(fileName, description, m_data, rangeLower(), rangeUpper()))
+        {
+            QMessageBox::critical(0, tr("FlySight Viewer"), tr("Couldn't write column file."));
         }
     }
 }
@@ -2654,11 +2512,7 @@ void MainWindow::on_actionExportTrack_triggered()
 QString MainWindow::dateTimeToUTC(
         const QDateTime &dt)
 {
-    QString ret;
-    ret += dt.toUTC().date().toString(Qt::ISODate) + "T";
-    ret += dt.toUTC().time().toString(Qt::ISODate) + ".";
-    ret += QString("%1").arg(dt.toUTC().time().msec(), 3, 10, QChar('0')) + "Z";
-    return ret;
+    return TrackUtil::dateTimeToUTC(dt);
 }
 
 void MainWindow::setRange(
@@ -2745,6 +2599,9 @@ void MainWindow::setZero(
     mZoomLevel.rangeLower -= dp0.t;
     mZoomLevel.rangeUpper -= dp0.t;
 
+    // Exit moved
+    mPhaseIndexValid = false;
+
     emit dataChanged();
 
     setTool(mPrevTool);
@@ -2771,6 +2628,7 @@ void MainWindow::setTrackGround(
     if (trackName == mTrackName)
     {
         updateGround(m_data, ground);
+        mPhaseIndexValid = false;
         emit dataChanged();
     }
 
@@ -2805,6 +2663,7 @@ void MainWindow::setTrackWindSpeed(
     if (trackName == mTrackName)
     {
         updateVelocity(m_data, mTrackName, false);
+        mPhaseIndexValid = false;
         emit dataChanged();
     }
 
@@ -2839,6 +2698,7 @@ void MainWindow::setTrackWindDir(
     if (trackName == mTrackName)
     {
         updateVelocity(m_data, mTrackName, false);
+        mPhaseIndexValid = false;
         emit dataChanged();
     }
 
@@ -2890,30 +2750,18 @@ bool MainWindow::setDatabaseValue(
         QString column,
         QString value)
 {
-    QSqlQuery query(mDatabase);
-
-    // Check the old value
-    if (!query.exec(QString("select * from files where (file_name='%1' and %2='%3')")
-                    .arg(trackName).arg(column).arg(value)))
-    {
-        QSqlError err = query.lastError();
-        QMessageBox::critical(0, tr("Query failed"), err.text());
-        return false;
-    }
-
     // Return now if value is not changed
-    if (query.next()) return true;
+    if (mTrackDatabase->hasValue(trackName, column, value)) return true;
 
-    // Change the value
-    if (!query.exec(QString("update files set %1='%2' where file_name='%3'")
-                    .arg(column).arg(value).arg(trackName)))
+    if (mTrackDatabase->lastError().isValid())
     {
-        QSqlError err = query.lastError();
+        QSqlError err = mTrackDatabase->lastError();
         QMessageBox::critical(0, tr("Query failed"), err.text());
         return false;
     }
 
-    emit databaseChanged();
+    // Change the value in the background
+    mTrackDatabase->setValue(trackName, column, value);
     return true;
 }
 
@@ -2922,26 +2770,30 @@ bool MainWindow::getDatabaseValue(
         QString column,
         QString &value)
 {
-    QSqlQuery query(mDatabase);
-
     // Read value from database
-    if (!query.exec(QString("select %1 from files where file_name='%2'")
-                    .arg(column).arg(trackName)))
+    if (mTrackDatabase->value(trackName, column, value)) return true;
+
+    if (mTrackDatabase->lastError().isValid())
     {
-        QSqlError err = query.lastError();
+        QSqlError err = mTrackDatabase->lastError();
         QMessageBox::critical(0, tr("Query failed"), err.text());
-        return false;
     }
 
-    // Check if there is a result
-    if (!query.next()) return false;
+    return false;
+}
 
-    // Handle empty results
-    if (query.value(0).toString().isEmpty()) return false;
+void MainWindow::onTrackWritten(
+        const QString &trackName,
+        const QStringList &columns)
+{
+    // Values used to derive the track
+    if (columns.contains("exit") || columns.contains("ground")
+            || columns.contains("wind_e") || columns.contains("wind_n"))
+    {
+        mReprocessQueue->invalidate(trackName);
+    }
 
-    // Return the result
-    value = query.value(0).toString();
-    return true;
+    emit trackChanged(trackName);
 }
 
 void MainWindow::setScoringVisible(
@@ -3020,6 +2872,7 @@ void MainWindow::setWind(
 
     // Update plot data
     updateVelocity(m_data, mTrackName, false);
+    mPhaseIndexValid = false;
 
     // Update checked tracks
     QMap< QString, DataPoints >::iterator p;
@@ -3101,8 +2954,6 @@ void MainWindow::saveZoomToDatabase()
     setDatabaseValue(mTrackName, "t_min", dateTimeToUTC(dp.dateTime));
     dp = interpolateDataT(mZoomLevel.rangeUpper);
     setDatabaseValue(mTrackName, "t_max", dateTimeToUTC(dp.dateTime));
-
-    emit databaseChanged();
 }
 
 void MainWindow::on_actionZoomToExtent_triggered()
@@ -3137,25 +2988,45 @@ void MainWindow::on_actionDeleteTrack_triggered()
         {
             // Clear track data
             m_data.clear();
+            mPhaseIndexValid = false;
             emit dataChanged();
 
             // Clear current track name;
             mTrackName = QString();
         }
 
-        // Get name of file in database
-        QString newName = QString("FlySight/Tracks/%1.csv").arg(uniqueName);
-        QString newPath = QDir(mDatabasePath).filePath(newName);
+        // Jumps share the file of their log, which is kept until
+        // the last of them is deleted
+        QString fileName = uniqueName;
+        bool deleteFile = true;
 
-        // Delete the track
-        if (!QFile::remove(newPath))
+        const QString parentName = TrackSegments::parentName(uniqueName);
+        if (parentName != uniqueName)
         {
-            QMessageBox::critical(0, tr("Operation failed"), tr("Couldn't delete track"));
+            TrackSegments::removeJump(mDatabase, uniqueName);
+            deleteFile = (TrackSegments::count(mDatabase, parentName) == 0);
+            if (deleteFile) fileName = parentName;
+        }
+
+        if (deleteFile)
+        {
+            // Get name of file in database
+            QString newPath = TrackArchive::trackPath(mDatabasePath, fileName);
+
+            // Delete the track
+            if (!QFile::remove(newPath))
+            {
+                QMessageBox::critical(0, tr("Operation failed"), tr("Couldn't delete track"));
+            }
         }
 
         // Remove track from database
         QSqlQuery query(mDatabase);
-        if (!query.exec(QString("delete from files where file_name='%1'").arg(uniqueName)))
+        query.prepare("delete from files where file_name in (?, ?)");
+        query.addBindValue(uniqueName);
+        query.addBindValue(fileName);
+
+        if (!query.exec())
         {
             QSqlError err = query.lastError();
             QMessageBox::critical(0, tr("Query failed"), err.text());
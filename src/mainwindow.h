@@ -35,12 +35,16 @@
 #include "dataplot.h"
 #include "datapoint.h"
 #include "dataview.h"
+#include "trackutil.h"
 
 class MapView;
 class QCPRange;
 class QCustomPlot;
+class ReprocessQueue;
 class ScoringMethod;
 class ScoringView;
+class TrackDatabase;
+class ViewScheduler;
 
 namespace Ui {
 class MainWindow;
@@ -82,6 +86,7 @@ public:
 
     const DataPoints &data() const { return m_data; }
     int dataSize() const { return m_data.size(); }
+    quint64 dataGeneration() const { return mDataGeneration; }
     const DataPoint &dataPoint(int i) const { return m_data[i]; }
 
     PlotValue::Units units() const { return m_units; }
@@ -134,6 +139,8 @@ public:
     int findIndexAboveT(double t) const;
     int findIndexForLanding();
 
+    const TrackUtil::PhaseIndex &phaseIndex() const;
+
     void setWindowMode(WindowMode mode);
     WindowMode windowMode() const { return mWindowMode; }
 
@@ -252,6 +259,7 @@ private slots:
     void on_actionExportKML_triggered();
     void on_actionExportPlot_triggered();
     void on_actionExportTrack_triggered();
+    void on_actionExportColumns_triggered();
     void on_actionExportToGoogleEarth_triggered();
 
     void on_actionUndoZoom_triggered();
@@ -271,6 +279,13 @@ private:
     Ui::MainWindow       *m_ui;
     DataPoints            m_data;
     DataPoints            m_optimal;
+    quint64               mDataGeneration;
+
+    bool                  mImporting;
+    QStringList           mPendingImports;
+
+    mutable TrackUtil::PhaseIndex mPhaseIndex;
+    mutable bool          mPhaseIndexValid;
 
     double                mMarkStart;
     double                mMarkEnd;
@@ -299,6 +314,7 @@ private:
     WindowMode            mWindowMode;
 
     ScoringView          *mScoringView;
+    ViewScheduler        *mViewScheduler;
 
     QVector< ScoringMethod* > mScoringMethods;
     ScoringMode               mScoringMode;
@@ -325,6 +341,8 @@ private:
 
     QString               mDatabasePath;
     QSqlDatabase          mDatabase;
+    ReprocessQueue       *mReprocessQueue;
+    TrackDatabase        *mTrackDatabase;
 
     QString               mTrackName;
     QVector< QString >    mSelectedTracks;
@@ -338,6 +356,8 @@ private:
     void readSettings();
 
     void initDatabase();
+    void initSearchIndexes();
+    void updateReprocessQueue();
     bool setDatabaseValue(QString trackName, QString column, QString value);
     bool getDatabaseValue(QString trackName, QString column, QString &value);
     void saveZoomToDatabase();
@@ -356,10 +376,12 @@ private:
     void initSingleView(const QString &title, const QString &objectName,
                         QAction *actionShow, DataView::Direction direction);
 
-    void importSingleRow(QString line, DataPoints &data);
-    void importNew(QTextStream &in, DataPoints &data, QString firstLne);
-    void importOld(QTextStream &in, DataPoints &data, QString firstLne);
     QString getDescription(const QString &fileName);
+    void findFiles(const QString &folderName, QStringList &fileNames);
+    bool importTrack(const QString &fileName, DataPoints &data, QString &uniqueName);
+    bool insertTrack(const QString &trackName);
+    void updateTrackInfo(const QString &trackName, const QString &description,
+                         const DataPoints &data);
     int import(QIODevice *device, DataPoints &data);
     void init(DataPoints &data, QString trackName, bool initDatabase);
     void initTime(DataPoints &data);
@@ -379,7 +401,7 @@ private:
     void updateGround(DataPoints &data, double ground);
     QString dateTimeToUTC(const QDateTime &dt);
 
-    bool exportToKML(QIODevice *device, QString name);
+    bool exportToKML(QIODevice *device, QString name, bool speedColors);
 
 signals:
     void dataLoaded();
@@ -391,16 +413,24 @@ signals:
     void aeroChanged();
     void rotationChanged(double rotation);
     void databaseChanged();
+    void summariesChanged();
+    void trackChanged(const QString &trackName);
     void mapModeChanged();
 
 public slots:
     void importFolder(QString folderName);
     void importFile(QString fileName);
+    void importFiles(const QStringList &fileNames);
 
 private slots:
     void setScoringVisible(bool visible);
     void saveZoom();
     void onDockWidgetTopLevelChanged(bool floating);
+    void onDataChanged();
+    void importPendingFiles();
+    void onTrackWritten(const QString &trackName, const QStringList &columns);
+    void onTrackWriteFailed(const QString &error);
+    void onReprocessFailed(const QString &trackName, const QString &error);
 };
 
 #endif // MAINWINDOW_H
@@ -48,7 +48,7 @@ public:
     }
 
 signals:
-    void setData(QList<QVariant> data);
+    void setData(const QString &path, int stride);
     void setBounds(QMap<QString, QVariant> sw, QMap<QString, QVariant> ne);
 
     void setMark(QMap<QString, QVariant> latLng);
@@ -58,8 +58,8 @@ signals:
     void clearMediaCursor();
 
     void clearAnnotations();
-    void addPolyline(QList<QVariant> data);
-    void addPolygon(QList<QVariant> data);
+    void addPolyline(const QString &path);
+    void addPolygon(const QString &path);
 
     void enableDrag();
     void disableDrag();
@@ -0,0 +1,102 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "mappath.h"
+
+#include <QByteArray>
+
+MapPath::MapPath(
+        bool hasValues):
+    mStride(hasValues ? 3 : 2)
+{
+
+}
+
+void MapPath::append(
+        double lat,
+        double lng)
+{
+    mCoords.append(lat);
+    mCoords.append(lng);
+    if (hasValues()) mCoords.append(0);
+}
+
+void MapPath::append(
+        double lat,
+        double lng,
+        double value)
+{
+    mCoords.append(lat);
+    mCoords.append(lng);
+    if (hasValues()) mCoords.append(value);
+}
+
+void MapPath::append(
+        const MapPath &path)
+{
+    for (int i = 0; i < path.size(); ++i)
+    {
+        append(path.lat(i), path.lng(i), path.value(i));
+    }
+}
+
+void MapPath::clear()
+{
+    mCoords.clear();
+}
+
+void MapPath::reserve(
+        int size)
+{
+    mCoords.reserve(size * mStride);
+}
+
+MapPath MapPath::reversed() const
+{
+    MapPath result(hasValues());
+    result.reserve(size());
+
+    for (int i = size() - 1; i >= 0; --i)
+    {
+        result.append(lat(i), lng(i), value(i));
+    }
+
+    return result;
+}
+
+QString MapPath::encode() const
+{
+    // Doubles are written in host byte order, which is also the byte order
+    // used by typed arrays in the embedded browser
+    QByteArray bytes = QByteArray::fromRawData(
+                (const char *) mCoords.constData(),
+                mCoords.size() * sizeof(double));
+
+    return QString::fromLatin1(bytes.toBase64());
+}
+
+bool MapPath::operator==(
+        const MapPath &other) const
+{
+    return mStride == other.mStride && mCoords == other.mCoords;
+}
@@ -0,0 +1,70 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef MAPPATH_H
+#define MAPPATH_H
+
+#include <QString>
+#include <QVector>
+
+/*
+    A list of map vertices stored as interleaved doubles (lat, lng and an
+    optional per-vertex value). Paths are sent to the map as a single base64
+    block which mapview.html decodes straight into a Float64Array, instead of
+    one QVariantMap per vertex.
+*/
+
+class MapPath
+{
+public:
+    explicit MapPath(bool hasValues = false);
+
+    void append(double lat, double lng);
+    void append(double lat, double lng, double value);
+    void append(const MapPath &path);
+
+    void clear();
+    void reserve(int size);
+
+    int size() const { return mCoords.size() / mStride; }
+    bool isEmpty() const { return mCoords.isEmpty(); }
+    bool hasValues() const { return mStride > 2; }
+    int stride() const { return mStride; }
+
+    double lat(int i) const { return mCoords[i * mStride]; }
+    double lng(int i) const { return mCoords[i * mStride + 1]; }
+    double value(int i) const { return hasValues() ? mCoords[i * mStride + 2] : 0; }
+
+    MapPath reversed() const;
+
+    QString encode() const;
+
+    bool operator==(const MapPath &other) const;
+    bool operator!=(const MapPath &other) const { return !(*this == other); }
+
+private:
+    int               mStride;
+    QVector< double > mCoords;
+};
+
+#endif // MAPPATH_H
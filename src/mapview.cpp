@@ -28,15 +28,21 @@
 #include <QVariant>
 #include <QWebChannel>
 
+#include <cmath>
+
 #include "common.h"
 #include "mainwindow.h"
 #include "mapcore.h"
+#include "mappath.h"
 #include "secrets.h"
 
 MapView::MapView(QWidget *parent) :
     QWebEngineView(parent),
     mMainWindow(0),
-    mDragging(false)
+    mDragging(false),
+    mLatMin(0), mLonMin(0),
+    mLatMax(0), mLonMax(0),
+    mSimplifierGeneration(0)
 {
     QFile file(":/html/mapview.html");
     if (file.open(QIODevice::ReadOnly))
@@ -127,41 +133,38 @@ void MapView::updateMarker(
     QPointF pos = QPointF(width() * (lng - mLonMin) / (mLonMax - mLonMin),
                           height() * (mLatMax - lat) / (mLatMax - mLatMin));
 
-    double lower = mMainWindow->rangeLower();
-    double upper = mMainWindow->rangeUpper();
-
-    double resultTime;
-    double resultDistance = std::numeric_limits<double>::max();
-
-    for (int i = 0; i + 1 < mMainWindow->dataSize(); ++i)
+    // Index the visible track the first time it is hovered
+    if (!mIndex.isBuilt())
     {
-        const DataPoint &dp1 = mMainWindow->dataPoint(i);
-        const DataPoint &dp2 = mMainWindow->dataPoint(i + 1);
+        double lower = mMainWindow->rangeLower();
+        double upper = mMainWindow->rangeUpper();
+
+        int start = mMainWindow->findIndexBelowT(lower) + 1;
+        int end   = mMainWindow->findIndexAboveT(upper);
 
-        if (lower <= dp1.t && dp1.t <= upper &&
-            lower <= dp2.t && dp2.t <= upper)
+        mIndex.clear();
+        for (int i = start; i < end; ++i)
         {
-            QPointF pt1 = QPointF(width() * (dp1.lon - mLonMin) / (mLonMax - mLonMin),
-                                  height() * (mLatMax - dp1.lat) / (mLatMax - mLatMin));
-            QPointF pt2 = QPointF(width() * (dp2.lon - mLonMin) / (mLonMax - mLonMin),
-                                  height() * (mLatMax - dp2.lat) / (mLatMax - mLatMin));
-
-            double mu;
-            double dist = sqrt(distSqrToLine(pt1, pt2, pos, mu));
-
-            if (dist < resultDistance)
-            {
-                double t1 = dp1.t;
-                double t2 = dp2.t;
-
-                resultTime = t1 + mu * (t2 - t1);
-                resultDistance = dist;
-            }
+            const DataPoint &dp = mMainWindow->dataPoint(i);
+            mIndex.addPoint(dp.lon, dp.lat, dp.t);
         }
+        mIndex.build();
     }
 
+    // Map from longitude/latitude to pixels
+    const double scaleX = width() / (mLonMax - mLonMin);
+    const double scaleY = height() / (mLatMax - mLatMin);
+    const QTransform transform(scaleX, 0,
+                               0, -scaleY,
+                               -mLonMin * scaleX, mLatMax * scaleY);
+
     const int selectionTolerance = 8;
-    if (resultDistance < selectionTolerance)
+
+    double resultTime;
+    double resultDistance;
+
+    if (mIndex.findNearest(transform, pos, selectionTolerance,
+                           resultTime, resultDistance))
     {
         mMainWindow->setMark(resultTime);
     }
@@ -175,14 +178,15 @@ void MapView::boundsChanged(
         QMap<QString, QVariant> sw,
         QMap<QString, QVariant> ne)
 {
-    double oldScale = metersPerPixel();
+    double oldTolerance = tolerance();
 
     mLatMin = sw["lat"].toDouble();
     mLonMin = sw["lng"].toDouble();
     mLatMax = ne["lat"].toDouble();
     mLonMax = ne["lng"].toDouble();
 
-    if (oldScale != metersPerPixel())
+    // Only redraw when the simplification level changes
+    if (oldTolerance != tolerance())
     {
         updateView();
     }
@@ -225,41 +229,52 @@ void MapView::initView()
 
 void MapView::updateView()
 {
-    double lower = mMainWindow->rangeLower();
-    double upper = mMainWindow->rangeUpper();
+    mIndex.clear();
 
-    // Distance threshold
-    const double threshold = metersPerPixel();
+    updateTrack();
 
-    QList<QVariant> data;
+    updateCursor();
 
-    double distPrev;
-    for (int i = 0; i < mMainWindow->dataSize(); ++i)
-    {
-        const DataPoint &dp = mMainWindow->dataPoint(i);
+    // Clear all annotations
+    mMapCore->clearAnnotations();
 
-        if (i > 0 && dp.dist2D - distPrev < threshold) continue;
-        distPrev = dp.dist2D;
+    // Draw annotations on map
+    mMainWindow->prepareMapView(this);
+}
 
-        if (lower <= dp.t && dp.t <= upper)
-        {
-            QMap<QString, QVariant> val;
-            val["lat"] = dp.lat;
-            val["lng"] = dp.lon;
+void MapView::updateTrack()
+{
+    const int size = mMainWindow->dataSize();
 
-            data.push_back(val);
+    // Rebuild the simplification hierarchy when the track changes
+    if (mSimplifier.size() != size
+            || mSimplifierGeneration != mMainWindow->dataGeneration())
+    {
+        MapPath path;
+        path.reserve(size);
+
+        for (int i = 0; i < size; ++i)
+        {
+            const DataPoint &dp = mMainWindow->dataPoint(i);
+            path.append(dp.lat, dp.lon);
         }
+
+        mSimplifier.setPath(path);
+        mSimplifierGeneration = mMainWindow->dataGeneration();
     }
 
-    mMapCore->setData(data);
+    // Indices of the visible range
+    int first = mMainWindow->findIndexBelowT(mMainWindow->rangeLower()) + 1;
+    int last = mMainWindow->findIndexAboveT(mMainWindow->rangeUpper()) - 1;
 
-    updateCursor();
+    MapPath path = mSimplifier.simplified(first, last, tolerance());
 
-    // Clear all annotations
-    mMapCore->clearAnnotations();
-
-    // Draw annotations on map
-    mMainWindow->prepareMapView(this);
+    // Only send the path if it has changed
+    if (path != mTrackPath)
+    {
+        mTrackPath = path;
+        mMapCore->setData(mTrackPath.encode(), mTrackPath.stride());
+    }
 }
 
 void MapView::updateCursor()
@@ -318,3 +333,12 @@ double MapView::metersPerPixel() const
     const double earthCircumference = 40075000; // m
     return earthCircumference * (mLatMax - mLatMin) / 360. / height();
 }
+
+double MapView::tolerance() const
+{
+    // Round the scale down to a power of two so that small zoom changes
+    // reuse the same simplified path
+    double scale = metersPerPixel();
+    if (!(scale > 0) || qIsInf(scale)) return 0;
+    return pow(2, floor(log2(scale)));
+}
@@ -26,6 +26,10 @@
 
 #include <QWebEngineView>
 
+#include "mappath.h"
+#include "pathsimplifier.h"
+#include "segmentindex.h"
+
 class MainWindow;
 
 class QWebChannel;
@@ -42,6 +46,7 @@ public:
     void setMainWindow(MainWindow *mainWindow) { mMainWindow = mainWindow; }
 
     double metersPerPixel() const;
+    double tolerance() const;
     MapCore *mapCore() { return mMapCore; }
 
 private:
@@ -54,6 +59,14 @@ private:
     double       mLatMin, mLonMin;
     double       mLatMax, mLonMax;
 
+    PathSimplifier mSimplifier;
+    quint64        mSimplifierGeneration;
+    MapPath        mTrackPath;
+
+    SegmentIndex   mIndex;
+
+    void updateTrack();
+
     bool updateReference(QMap<QString, QVariant> latLng);
     void updateMarker(QMap<QString, QVariant> latLng);
 
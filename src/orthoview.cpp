@@ -39,7 +39,8 @@ OrthoView::OrthoView(QWidget *parent) :
     m_pan(false),
     m_azimuth(-PI/2),
     m_elevation(PI/2),
-    m_scale(1)
+    m_scale(1),
+    mRadius(0)
 {
     setMouseTracking(true);
 
@@ -105,39 +106,42 @@ void OrthoView::mouseMoveEvent(
 
         m_beginPos = endPos;
 
-        updateView();
+        updateProjection();
+
+        // The projection changes with every step, so don't index it for
+        // picking until the drag ends
+        return;
     }
 
     if (QCPCurve *curve = qobject_cast<QCPCurve *>(plottable(0)))
     {
-        QSharedPointer<QCPCurveDataContainer> data = curve->data();
-
-        double resultTime;
-        double resultDistance = std::numeric_limits<double>::max();
-
-        for (QCPCurveDataContainer::const_iterator it = data->constBegin();
-             it != data->constEnd() && (it + 1) != data->constEnd();
-             ++ it)
+        // Index the curve the first time it is hovered
+        if (!mIndex.isBuilt())
         {
-            QPointF pt1 = QPointF(xAxis->coordToPixel(it->key),
-                                  yAxis->coordToPixel(it->value));
-            QPointF pt2 = QPointF(xAxis->coordToPixel((it + 1)->key),
-                                  yAxis->coordToPixel((it + 1)->value));
+            QSharedPointer<QCPCurveDataContainer> data = curve->data();
 
-            double mu;
-            double dist = sqrt(distSqrToLine(pt1, pt2, event->pos(), mu));
-
-            if (dist < resultDistance)
+            mIndex.clear();
+            for (QCPCurveDataContainer::const_iterator it = data->constBegin();
+                 it != data->constEnd();
+                 ++it)
             {
-                double t1 = it->t;
-                double t2 = (it + 1)->t;
-
-                resultTime = t1 + mu * (t2 - t1);
-                resultDistance = dist;
+                mIndex.addPoint(it->key, it->value, it->t);
             }
+            mIndex.build();
         }
 
-        if (resultDistance < selectionTolerance())
+        // Map from plot coordinates to pixels
+        const double x0 = xAxis->coordToPixel(0);
+        const double y0 = yAxis->coordToPixel(0);
+        const QTransform transform(xAxis->coordToPixel(1) - x0, 0,
+                                   0, yAxis->coordToPixel(1) - y0,
+                                   x0, y0);
+
+        double resultTime;
+        double resultDistance;
+
+        if (mIndex.findNearest(transform, event->pos(), selectionTolerance(),
+                               resultTime, resultDistance))
         {
             mMainWindow->setMark(resultTime);
         }
@@ -159,184 +163,184 @@ void OrthoView::wheelEvent(
     m_timer->start();
 
     // Update the view
-    updateView();
+    updateProjection();
 }
 
 void OrthoView::endTimer()
 {
-    updateView();
+    updateProjection();
 }
 
-void OrthoView::updateView()
+void OrthoView::updateCursor()
 {
-    clearPlottables();
-    clearItems();
+    // Cursor changes don't affect the projected track
+    mCursors.update(this, mMainWindow, *this);
 
-    // Return now if plot empty
-    if (mMainWindow->dataSize() == 0) return;
+    replot();
+}
+
+QPointF OrthoView::project(
+        const DataPoint &dp) const
+{
+    QVector3D rt, up, bk;
+    cameraVectors(rt, up, bk);
+
+    QVector3D cur(dp.x, dp.y, dp.z);
+    if (mMainWindow->units() != PlotValue::Metric)
+    {
+        cur *= METERS_TO_FEET;
+    }
+
+    return QPointF(QVector3D::dotProduct(cur, rt),
+                   QVector3D::dotProduct(cur, up));
+}
+
+void OrthoView::cameraVectors(
+        QVector3D &rt,
+        QVector3D &up,
+        QVector3D &bk) const
+{
+    up = QVector3D(-sin(m_elevation) * cos(m_azimuth),
+                   -sin(m_elevation) * sin(m_azimuth),
+                    cos(m_elevation));
+    bk = QVector3D(cos(m_elevation) * cos(m_azimuth),
+                   cos(m_elevation) * sin(m_azimuth),
+                   sin(m_elevation));
+    rt = QVector3D::crossProduct(up, bk);
+}
 
+void OrthoView::updateView()
+{
     // Get plot range
     double lower = mMainWindow->rangeLower();
     double upper = mMainWindow->rangeUpper();
 
-    // Calculate camera vectors
-    QVector3D up(-sin(m_elevation) * cos(m_azimuth),
-                 -sin(m_elevation) * sin(m_azimuth),
-                  cos(m_elevation));
-    QVector3D bk(cos(m_elevation) * cos(m_azimuth),
-                 cos(m_elevation) * sin(m_azimuth),
-                 sin(m_elevation));
-    QVector3D rt = QVector3D::crossProduct(up, bk);
+    int start = mMainWindow->findIndexBelowT(lower) + 1;
+    int end   = mMainWindow->findIndexAboveT(upper);
+
+    const int size = qMax(end - start, 0);
 
-    QVector< double > t, x, y, z;
+    mT.resize(size);
+    mX.resize(size);
+    mY.resize(size);
+    mZ.resize(size);
 
-    double xMin, xMax;
-    double yMin, yMax;
-    double zMin, zMax;
+    const double factor = (mMainWindow->units() == PlotValue::Metric) ? 1 : METERS_TO_FEET;
 
     double uMin, uMax;
     double vMin, vMax;
     double wMin, wMax;
 
-    bool first = true;
-
-    for (int i = 0; i < mMainWindow->dataSize(); ++i)
+    for (int i = 0; i < size; ++i)
     {
-        const DataPoint &dp = mMainWindow->dataPoint(i);
-
-        if (lower <= dp.t && dp.t <= upper)
-        {
-            t.append(dp.t);
-
-            QVector3D cur;
-            if (mMainWindow->units() == PlotValue::Metric)
-            {
-                cur = QVector3D(dp.x, dp.y, dp.z);
-            }
-            else
-            {
-                cur = QVector3D(dp.x, dp.y, dp.z) * METERS_TO_FEET;
-            }
-
-            x.append(QVector3D::dotProduct(cur, rt));
-            y.append(QVector3D::dotProduct(cur, up));
-            z.append(QVector3D::dotProduct(cur, bk));
-
-            if (first)
-            {
-                xMin = xMax = x.back();
-                yMin = yMax = y.back();
-                zMin = zMax = z.back();
-
-                uMin = uMax = dp.x;
-                vMin = vMax = dp.y;
-                wMin = wMax = dp.z;
-
-                first = false;
-            }
-            else
-            {
-                if (x.back() < xMin) xMin = x.back();
-                if (x.back() > xMax) xMax = x.back();
+        const DataPoint &dp = mMainWindow->dataPoint(start + i);
 
-                if (y.back() < yMin) yMin = y.back();
-                if (y.back() > yMax) yMax = y.back();
+        mT[i] = dp.t;
+        mX[i] = dp.x * factor;
+        mY[i] = dp.y * factor;
+        mZ[i] = dp.z * factor;
 
-                if (z.back() < zMin) zMin = z.back();
-                if (z.back() > zMax) zMax = z.back();
-
-                if (dp.x < uMin) uMin = dp.x;
-                if (dp.x > uMax) uMax = dp.x;
+        if (i == 0)
+        {
+            uMin = uMax = dp.x;
+            vMin = vMax = dp.y;
+            wMin = wMax = dp.z;
+        }
+        else
+        {
+            if (dp.x < uMin) uMin = dp.x;
+            if (dp.x > uMax) uMax = dp.x;
 
-                if (dp.y < vMin) vMin = dp.y;
-                if (dp.y > vMax) vMax = dp.y;
+            if (dp.y < vMin) vMin = dp.y;
+            if (dp.y > vMax) vMax = dp.y;
 
-                if (dp.z < wMin) wMin = dp.z;
-                if (dp.z > wMax) wMax = dp.z;
-            }
+            if (dp.z < wMin) wMin = dp.z;
+            if (dp.z > wMax) wMax = dp.z;
         }
     }
 
-    QCPCurve *curve = new QCPCurve(xAxis, yAxis);
-    curve->setData(t, x, y);
-    curve->setPen(QPen(Qt::black, mMainWindow->lineThickness()));
-
-    QVector3D mid((uMin + uMax) / 2,
-                  (vMin + vMax) / 2,
-                  (wMin + wMax) / 2);
-
-    double xMid = QVector3D::dotProduct(mid, rt);
-    double yMid = QVector3D::dotProduct(mid, up);
-    double zMid = QVector3D::dotProduct(mid, bk);
+    if (size > 0)
+    {
+        mMid = QVector3D((uMin + uMax) / 2,
+                         (vMin + vMax) / 2,
+                         (wMin + wMax) / 2);
+    }
 
+    // The camera rotation preserves distances, so the view radius can be
+    // found once here instead of for every camera angle
     double rMax = 0;
-    for (int i = 0; i < x.size(); ++i)
+    for (int i = 0; i < size; ++i)
     {
-        const double dx = x[i] - xMid;
-        const double dy = y[i] - yMid;
-        const double dz = z[i] - zMid;
+        const double dx = mX[i] - mMid.x();
+        const double dy = mY[i] - mMid.y();
+        const double dz = mZ[i] - mMid.z();
         const double r = dx * dx + dy * dy + dz * dz;
         if (r > rMax) rMax = r;
     }
-    rMax = sqrt(rMax);
+    mRadius = sqrt(rMax);
 
-    setViewRange(xMid - rMax / m_scale, xMid + rMax / m_scale,
-                 yMid - rMax / m_scale, yMid + rMax / m_scale);
+    updateProjection();
+}
 
-    if (mMainWindow->mediaCursorRef() > 0)
-    {
-        const DataPoint &dp = mMainWindow->interpolateDataT(mMainWindow->mediaCursor());
+void OrthoView::updateProjection()
+{
+    clearPlottables();
+    mCursors.forget();
+    mIndex.clear();
+    clearItems();
 
-        QVector< double > xMark, yMark, zMark;
+    // Return now if plot empty
+    if (mMainWindow->dataSize() == 0) return;
 
-        QVector3D cur;
-        if (mMainWindow->units() == PlotValue::Metric)
-        {
-            cur = QVector3D(dp.x, dp.y, dp.z);
-        }
-        else
-        {
-            cur = QVector3D(dp.x, dp.y, dp.z) * METERS_TO_FEET;
-        }
+    // Calculate camera vectors
+    QVector3D rt, up, bk;
+    cameraVectors(rt, up, bk);
 
-        xMark.append(QVector3D::dotProduct(cur, rt));
-        yMark.append(QVector3D::dotProduct(cur, up));
-        zMark.append(QVector3D::dotProduct(cur, bk));
+    // Project all points onto the screen plane
+    const int size = mT.size();
 
-        QCPGraph *graph = addGraph();
-        graph->setData(xMark, yMark);
-        graph->setPen(QPen(Qt::darkGray, mMainWindow->lineThickness()));
-        graph->setLineStyle(QCPGraph::lsNone);
-        graph->setScatterStyle(QCPScatterStyle::ssDisc);
-    }
+    mProjX.resize(size);
+    mProjY.resize(size);
 
-    if (mMainWindow->markActive())
-    {
-        const DataPoint &dpEnd = mMainWindow->interpolateDataT(mMainWindow->markEnd());
+    projectPoints(mX.constData(), mY.constData(), mZ.constData(), size,
+                  rt, up, mProjX.data(), mProjY.data());
 
-        QVector< double > xMark, yMark, zMark;
+    double xMid = QVector3D::dotProduct(mMid, rt);
+    double yMid = QVector3D::dotProduct(mMid, up);
 
-        QVector3D cur;
-        if (mMainWindow->units() == PlotValue::Metric)
-        {
-            cur = QVector3D(dpEnd.x, dpEnd.y, dpEnd.z);
-        }
-        else
+    setViewRange(xMid - mRadius / m_scale, xMid + mRadius / m_scale,
+                 yMid - mRadius / m_scale, yMid + mRadius / m_scale);
+
+    // Drop points less than half a pixel from the last one kept
+    const double valPerPix = xAxis->range().size() / axisRect()->width();
+    const double minDistSqr = valPerPix * valPerPix / 4;
+
+    QVector< double > t, x, y;
+
+    t.reserve(size);
+    x.reserve(size);
+    y.reserve(size);
+
+    for (int i = 0; i < size; ++i)
+    {
+        if (i > 0 && i + 1 < size)
         {
-            cur = QVector3D(dpEnd.x, dpEnd.y, dpEnd.z) * METERS_TO_FEET;
+            const double dx = mProjX[i] - x.back();
+            const double dy = mProjY[i] - y.back();
+            if (dx * dx + dy * dy < minDistSqr) continue;
         }
 
-        xMark.append(QVector3D::dotProduct(cur, rt));
-        yMark.append(QVector3D::dotProduct(cur, up));
-        zMark.append(QVector3D::dotProduct(cur, bk));
-
-        QCPGraph *graph = addGraph();
-        graph->setData(xMark, yMark);
-        graph->setPen(QPen(Qt::black, mMainWindow->lineThickness()));
-        graph->setLineStyle(QCPGraph::lsNone);
-        graph->setScatterStyle(QCPScatterStyle::ssDisc);
+        t.append(mT[i]);
+        x.append(mProjX[i]);
+        y.append(mProjY[i]);
     }
 
+    QCPCurve *curve = new QCPCurve(xAxis, yAxis);
+    curve->setData(t, x, y);
+    curve->setPen(QPen(Qt::black, mMainWindow->lineThickness()));
+
+    mCursors.update(this, mMainWindow, *this);
+
     if (mMainWindow->dataSize() > 0)
     {
         QVector< double > xMark, yMark, zMark;
@@ -410,13 +414,8 @@ void OrthoView::addOrientation()
     double valPerMM = valPerPix / mmPerPix;
 
     // Camera vectors
-    QVector3D up(-sin(m_elevation) * cos(m_azimuth),
-                 -sin(m_elevation) * sin(m_azimuth),
-                  cos(m_elevation));
-    QVector3D bk(cos(m_elevation) * cos(m_azimuth),
-                 cos(m_elevation) * sin(m_azimuth),
-                 sin(m_elevation));
-    QVector3D rt = QVector3D::crossProduct(up, bk);
+    QVector3D rt, up, bk;
+    cameraVectors(rt, up, bk);
 
     // Transformed basis
     QVector3D o(-rt.x() - rt.y() - rt.z(),
@@ -24,12 +24,16 @@
 #ifndef ORTHOVIEW_H
 #define ORTHOVIEW_H
 
+#include <QVector3D>
+
 #include "QCustomPlot/qcustomplot.h"
+#include "cursormarkers.h"
+#include "segmentindex.h"
 
 class MainWindow;
 class QTimer;
 
-class OrthoView : public QCustomPlot
+class OrthoView : public QCustomPlot, public CursorMarkers::Projection
 {
     Q_OBJECT
 
@@ -58,12 +62,24 @@ private:
 
     QTimer     *m_timer;
 
+    SegmentIndex mIndex;
+    CursorMarkers mCursors;
+
+    QVector< double > mT, mX, mY, mZ;
+    QVector< double > mProjX, mProjY;
+    QVector3D         mMid;
+    double            mRadius;
+
+    void updateProjection();
+    QPointF project(const DataPoint &dp) const;
+    void cameraVectors(QVector3D &rt, QVector3D &up, QVector3D &bk) const;
     void addOrientation();
     void setViewRange(double xMin, double xMax,
                       double yMin, double yMax);
 
 public slots:
     void updateView();
+    void updateCursor();
     void endTimer();
 };
 
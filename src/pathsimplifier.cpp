@@ -0,0 +1,185 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "pathsimplifier.h"
+
+#include <QPair>
+#include <QPointF>
+#include <QStack>
+#include <QVector3D>
+
+#include <cmath>
+#include <limits>
+
+#include "common.h"
+
+static double distSqrToLine(
+        const QVector3D &a,
+        const QVector3D &b,
+        const QVector3D &p)
+{
+    QVector3D v(b - a);
+
+    double vLengthSqr = v.lengthSquared();
+    if (!qFuzzyIsNull(vLengthSqr))
+    {
+        double mu = QVector3D::dotProduct(p - a, v) / vLengthSqr;
+        mu = qBound(0., mu, 1.);
+        return ((a + mu * v) - p).lengthSquared();
+    }
+    else
+    {
+        return (a - p).lengthSquared();
+    }
+}
+
+PathSimplifier::PathSimplifier()
+{
+
+}
+
+void PathSimplifier::setPath(
+        const MapPath &path,
+        const QVector< double > &heights)
+{
+    mPath = path;
+    mImportance.fill(0, path.size());
+
+    if (path.size() == 0) return;
+
+    // Project to local metres around the first point
+    const double earthCircumference = 40075000; // m
+    const double metersPerDegree = earthCircumference / 360.;
+
+    const double lat0 = path.lat(0);
+    const double lng0 = path.lng(0);
+    const double scaleLng = metersPerDegree * cos(lat0 / 180 * PI);
+
+    const bool useHeights = (heights.size() == path.size());
+
+    QVector< QPointF > points(path.size());
+    QVector< QVector3D > points3D(useHeights ? path.size() : 0);
+    for (int i = 0; i < path.size(); ++i)
+    {
+        points[i] = QPointF((path.lng(i) - lng0) * scaleLng,
+                            (path.lat(i) - lat0) * metersPerDegree);
+
+        if (useHeights)
+        {
+            points3D[i] = QVector3D(points[i].x(), points[i].y(),
+                                    heights[i] - heights[0]);
+        }
+    }
+
+    // End points are always kept
+    const double maxImportance = std::numeric_limits<double>::max();
+    mImportance.first() = maxImportance;
+    mImportance.last() = maxImportance;
+
+    // Split each span at its farthest vertex. A vertex never outranks the
+    // vertex whose split created its span, so thresholding the importance
+    // gives the same result as running Douglas-Peucker at that tolerance.
+    QStack< QPair< int, int > > spans;
+    QStack< double > limits;
+
+    spans.push(qMakePair(0, path.size() - 1));
+    limits.push(maxImportance);
+
+    while (!spans.isEmpty())
+    {
+        const QPair< int, int > span = spans.pop();
+        const double limit = limits.pop();
+
+        if (span.second - span.first < 2) continue;
+
+        int farthest = span.first + 1;
+        double farthestDist = -1;
+
+        for (int i = span.first + 1; i < span.second; ++i)
+        {
+            double mu;
+            double dist = useHeights
+                    ? distSqrToLine(points3D[span.first], points3D[span.second], points3D[i])
+                    : distSqrToLine(points[span.first], points[span.second], points[i], mu);
+
+            if (dist > farthestDist)
+            {
+                farthest = i;
+                farthestDist = dist;
+            }
+        }
+
+        const double importance = qMin(sqrt(farthestDist), limit);
+        mImportance[farthest] = importance;
+
+        spans.push(qMakePair(span.first, farthest));
+        limits.push(importance);
+
+        spans.push(qMakePair(farthest, span.second));
+        limits.push(importance);
+    }
+}
+
+void PathSimplifier::clear()
+{
+    mPath.clear();
+    mImportance.clear();
+}
+
+MapPath PathSimplifier::simplified(
+        int first,
+        int last,
+        double tolerance) const
+{
+    MapPath result(mPath.hasValues());
+
+    foreach (int i, indices(first, last, tolerance))
+    {
+        result.append(mPath.lat(i), mPath.lng(i), mPath.value(i));
+    }
+
+    return result;
+}
+
+QVector< int > PathSimplifier::indices(
+        int first,
+        int last,
+        double tolerance) const
+{
+    QVector< int > result;
+
+    first = qMax(first, 0);
+    last = qMin(last, mPath.size() - 1);
+
+    for (int i = first; i <= last; ++i)
+    {
+        // Keep the ends of the visible range even if they were simplified
+        // away in the full path
+        if (i == first || i == last || mImportance[i] > tolerance)
+        {
+            result.append(i);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,58 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef PATHSIMPLIFIER_H
+#define PATHSIMPLIFIER_H
+
+#include <QVector>
+
+#include "mappath.h"
+
+/* Douglas-Peucker simplification hierarchy for a map path. Each vertex is
+ * assigned the largest tolerance (in metres) at which it survives
+ * simplification, so the hierarchy is built once and any tolerance can be
+ * extracted afterwards with a single linear pass. If heights (in metres) are
+ * given, distances are measured in 3D. */
+class PathSimplifier
+{
+public:
+    PathSimplifier();
+
+    void setPath(const MapPath &path,
+                 const QVector< double > &heights = QVector< double >());
+    const MapPath &path() const { return mPath; }
+
+    void clear();
+
+    bool isEmpty() const { return mPath.isEmpty(); }
+    int size() const { return mPath.size(); }
+
+    MapPath simplified(int first, int last, double tolerance) const;
+    QVector< int > indices(int first, int last, double tolerance) const;
+
+private:
+    MapPath           mPath;
+    QVector< double > mImportance;
+};
+
+#endif // PATHSIMPLIFIER_H
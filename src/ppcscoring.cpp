@@ -33,8 +33,7 @@
 #include "mainwindow.h"
 #include "mapview.h"
 #include "mapcore.h"
-
-#define MAX_SPLIT_DEPTH 8
+#include "trackutil.h"
 
 using namespace GeographicLib;
 using namespace GeographicUtil;
@@ -49,7 +48,8 @@ PPCScoring::PPCScoring(
     mDrawLane(false),
     mEndLatitude(51.0500),
     mEndLongitude(-114.0667),
-    mLaneWidth(600)
+    mLaneWidth(600),
+    mWindAdjustment(false)
 {
 
 }
@@ -119,15 +119,23 @@ double PPCScoring::score(
         case Time:
             return dpBottom.t - dpTop.t;
         case Distance:
-            return mMainWindow->getDistance(dpTop, dpBottom);
+            return distance(dpTop, dpBottom);
         default: // Speed
-            return mMainWindow->getDistance(dpTop, dpBottom) / (dpBottom.t - dpTop.t);
+            return distance(dpTop, dpBottom) / (dpBottom.t - dpTop.t);
         }
     }
 
     return 0;
 }
 
+double PPCScoring::distance(
+        const DataPoint &dp1,
+        const DataPoint &dp2) const
+{
+    if (!mMainWindow) return TrackUtil::getDistance(dp1, dp2, mWindAdjustment);
+    return mMainWindow->getDistance(dp1, dp2);
+}
+
 QString PPCScoring::scoreAsText(
         double score)
 {
@@ -237,106 +245,17 @@ void PPCScoring::prepareMapView(
     if (!mDrawLane) return;
 
     // Distance threshold
-    const double threshold = view->metersPerPixel();
+    const double threshold = view->tolerance();
 
     // Get start point
     DataPoint dpTenMS = mMainWindow->performanceStart();
     DataPoint dpStart = mMainWindow->interpolateDataT(dpTenMS.t + 9.0);
 
-    // Draw lane center
-    QList<QVariant> data;
-
-    QMap<QString, QVariant> val;
-    val["lat"] = mEndLatitude;
-    val["lng"] = mEndLongitude;
-    data.push_back(val);
-
-    splitLine(data, mEndLatitude, mEndLongitude, dpStart.lat, dpStart.lon, threshold, 0);
-
-    val["lat"] = dpStart.lat;
-    val["lng"] = dpStart.lon;
-    data.push_back(val);
-
-    view->mapCore()->addPolyline(data);
-
-    // Draw shading around lane
-    QList<QVariant> lt, rt;
-    for (int i = 0; i < data.size(); ++i)
-    {
-        double lat1 = data[i].toMap()["lat"].toDouble();
-        double lon1 = data[i].toMap()["lng"].toDouble();
-
-        double ltBearing, rtBearing;
-
-        if (i + 1 < data.size())
-        {
-            double lat2 = data[i+1].toMap()["lat"].toDouble();
-            double lon2 = data[i+1].toMap()["lng"].toDouble();
-
-            double azi1, azi2;
-            Geodesic::WGS84().Inverse(lat1, lon1, lat2, lon2, azi1, azi2);
-
-            ltBearing = azi1 + 90;
-            rtBearing = azi1 - 90;
-        }
-        else if (i - 1 >= 0)
-        {
-            double lat2 = data[i-1].toMap()["lat"].toDouble();
-            double lon2 = data[i-1].toMap()["lng"].toDouble();
-
-            double azi1, azi2;
-            Geodesic::WGS84().Inverse(lat2, lon2, lat1, lon1, azi1, azi2);
-
-            ltBearing = azi2 + 90;
-            rtBearing = azi2 - 90;
-        }
-
-        double tempLat, tempLon;
-        Geodesic::WGS84().Direct(lat1, lon1, ltBearing, mLaneWidth / 2, tempLat, tempLon);
-
-        QMap<QString, QVariant> val;
-        val["lat"] = tempLat;
-        val["lng"] = tempLon;
-        lt.push_back(val);
-
-        Geodesic::WGS84().Direct(lat1, lon1, rtBearing, mLaneWidth / 2, tempLat, tempLon);
-
-        val["lat"] = tempLat;
-        val["lng"] = tempLon;
-        rt.push_front(val);
-    }
+    // Draw lane center and shading
+    mLane.update(mEndLatitude, mEndLongitude, dpStart.lat, dpStart.lon, mLaneWidth, threshold);
 
-    // Now take lt + rt to form loop
-    view->mapCore()->addPolygon(lt + rt);
-}
-
-void PPCScoring::splitLine(
-        QList<QVariant> &data,
-        double startLat,
-        double startLon,
-        double endLat,
-        double endLon,
-        double threshold,
-        int depth)
-{
-    GeodesicLine l = Geodesic::WGS84().InverseLine(startLat, startLon, endLat, endLon);
-    double midLat, midLon;
-    l.Position(l.Distance() / 2, midLat, midLon);
-
-    double dist;
-    Geodesic::WGS84().Inverse((startLat + endLat) / 2, (startLon + endLon) / 2, midLat, midLon, dist);
-
-    if (dist > threshold && depth < MAX_SPLIT_DEPTH)
-    {
-        splitLine(data, startLat, startLon, midLat, midLon, threshold, depth + 1);
-
-        QMap<QString, QVariant> val;
-        val["lat"] = midLat;
-        val["lng"] = midLon;
-        data.push_back(val);
-
-        splitLine(data, midLat, midLon, endLat, endLon, threshold, depth + 1);
-    }
+    view->mapCore()->addPolyline(mLane.centerLine());
+    view->mapCore()->addPolygon(mLane.outline());
 }
 
 bool PPCScoring::getWindowBounds(
@@ -348,7 +267,14 @@ bool PPCScoring::getWindowBounds(
     bool foundTop = false;
     int bottom, top;
 
-    for (int i = result.size() - 1; i >= 0; --i)
+    // Samples below the window bottom can't hold either crossing, so
+    // begin just after the last one above it
+    const TrackUtil::PhaseIndex *index = phaseIndex(mMainWindow, result);
+    const int end = index
+            ? qMin(TrackUtil::findIndexAboveZ(*index, mWindowBottom) + 1, result.size() - 1)
+            : result.size() - 1;
+
+    for (int i = end; i >= 0; --i)
     {
         const DataPoint &dp = result[i];
 
@@ -413,15 +339,22 @@ bool PPCScoring::getSEP(
 {
     bool found = false;
 
-    for (int i = result.size() - 1; i >= 0; --i)
+    // Get validation window
+    const double zBottom = mWindowBottom - 20;
+    const double zTop = mWindowTop + 20;
+
+    // Only samples between the first one below the top and the last
+    // one above the bottom can be inside
+    const TrackUtil::PhaseIndex *index = phaseIndex(mMainWindow, result);
+    const int first = index ? TrackUtil::findIndexBelowZ(*index, zTop) : 0;
+    const int last = index ? TrackUtil::findIndexAboveZ(*index, zBottom)
+                           : result.size() - 1;
+
+    for (int i = last; i >= first; --i)
     {
         // Get end point
         const DataPoint &dp = result[i];
 
-        // Get validation window
-        const double zBottom = mWindowBottom - 20;
-        const double zTop = mWindowTop + 20;
-
         // Check window conditions
         if (dp.t < 0) break;
         if (dp.z < zBottom) continue;
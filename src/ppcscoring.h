@@ -24,6 +24,7 @@
 #ifndef PPCSCORING_H
 #define PPCSCORING_H
 
+#include "lanecache.h"
 #include "scoringmethod.h"
 
 class MainWindow;
@@ -51,6 +52,9 @@ public:
     double endLongitude(void) const { return mEndLongitude; }
     void setEnd(double endLatitude, double endLongitude);
 
+    // Only used without a main window, which otherwise decides
+    void setWindAdjustment(bool windAdjustment) { mWindAdjustment = windAdjustment; }
+
     double score(const MainWindow::DataPoints &result);
     QString scoreAsText(double score);
 
@@ -70,6 +74,8 @@ public:
     void optimize() { ScoringMethod::optimize(mMainWindow, mWindowBottom); }
 
 private:
+    double distance(const DataPoint &dp1, const DataPoint &dp2) const;
+
     MainWindow *mMainWindow;
 
     Mode        mMode;
@@ -81,10 +87,9 @@ private:
     double      mEndLongitude;
     double      mLaneWidth;
 
-    void splitLine(QList<QVariant> &data,
-                   double startLat, double startLon,
-                   double endLat, double endLon,
-                   double threshold, int depth);
+    bool        mWindAdjustment;
+
+    LaneCache   mLane;
 
 signals:
 
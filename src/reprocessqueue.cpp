@@ -0,0 +1,387 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "reprocessqueue.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QMutexLocker>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QTimer>
+#include <QVariant>
+
+#include "tracksegments.h"
+#include "tracksummary.h"
+#include "trackutil.h"
+
+#define PROCESSING_VERSION  2       // Increment when derivation changes
+#define THROTTLE_MSEC       100     // Pause between tracks
+#define MAX_BACKOFF_MSEC    60000   // Longest pause after failures
+#define CONNECTION_NAME     "flysight-reprocess"
+
+ReprocessWorker::ReprocessWorker():
+    mTimer(0),
+    mOptions(BatchProcessor::defaultOptions()),
+    mCancel(0),
+    mProcessed(0),
+    mFailures(0)
+{
+    mSignature = signature(mOptions);
+}
+
+QString ReprocessWorker::signature(
+        const BatchProcessor::Options &options)
+{
+    return QString("%1;%2;%3;%4;%5;%6;%7;%8")
+            .arg(PROCESSING_VERSION)
+            .arg(options.mass)
+            .arg(options.planformArea)
+            .arg(options.windE)
+            .arg(options.windN)
+            .arg(options.fixedGround)
+            .arg(options.fixedReference)
+            .arg(options.windAdjustment);
+}
+
+void ReprocessWorker::setOptions(
+        const BatchProcessor::Options &options)
+{
+    QMutexLocker locker(&mMutex);
+    mOptions = options;
+    mSignature = signature(options);
+}
+
+QString ReprocessWorker::currentSignature()
+{
+    QMutexLocker locker(&mMutex);
+    return mSignature;
+}
+
+void ReprocessWorker::setPriorityTracks(
+        const QStringList &trackNames)
+{
+    QMutexLocker locker(&mMutex);
+    mPriorityTracks = trackNames;
+}
+
+void ReprocessWorker::invalidate(
+        const QString &trackName)
+{
+    QMutexLocker locker(&mMutex);
+    mInvalidTracks.insert(trackName);
+}
+
+void ReprocessWorker::cancel()
+{
+    mCancel.storeRelease(1);
+}
+
+void ReprocessWorker::open(
+        const QString &databasePath)
+{
+    close();
+
+    mDatabasePath = databasePath;
+
+    if (!mTimer)
+    {
+        mTimer = new QTimer(this);
+        mTimer->setSingleShot(true);
+        mTimer->setInterval(THROTTLE_MSEC);
+
+        connect(mTimer, SIGNAL(timeout()), this, SLOT(processNext()));
+    }
+
+    // Separate connection for this thread
+    mDatabase = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    mDatabase.setDatabaseName(QDir(databasePath).filePath("FlySight/FlySight.db"));
+    mDatabase.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+
+    if (!mDatabase.open()) return;
+
+    // Resume where the last run left off
+    wake();
+}
+
+void ReprocessWorker::close()
+{
+    if (mTimer) mTimer->stop();
+
+    if (mDatabase.isValid())
+    {
+        mDatabase.close();
+        mDatabase = QSqlDatabase();
+        QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    }
+}
+
+void ReprocessWorker::wake()
+{
+    if (mTimer && !mTimer->isActive())
+    {
+        mTimer->start();
+    }
+}
+
+void ReprocessWorker::processNext()
+{
+    if (mCancel.loadAcquire() || !mDatabase.isOpen()) return;
+
+    const QString trackName = nextTrack();
+
+    if (trackName.isEmpty())
+    {
+        // Let views refresh once the queue empties
+        if (mProcessed > 0)
+        {
+            mProcessed = 0;
+            emit idle();
+        }
+        return;
+    }
+
+    QSqlError error;
+    if (process(trackName, error))
+    {
+        ++mProcessed;
+
+        mFailures = 0;
+        mTimer->setInterval(THROTTLE_MSEC);
+    }
+    else
+    {
+        // The same track would be picked again, so back off instead of
+        // retrying it at full rate
+        if (mFailures == 0)
+        {
+            emit failed(trackName, error.text());
+        }
+
+        ++mFailures;
+        mTimer->setInterval(qMin(THROTTLE_MSEC << qMin(mFailures, 10), MAX_BACKOFF_MSEC));
+    }
+
+    // Leave time for the GUI thread between tracks
+    mTimer->start();
+}
+
+QString ReprocessWorker::nextTrack()
+{
+    QString signature;
+    QStringList priorityTracks;
+
+    {
+        QMutexLocker locker(&mMutex);
+
+        // Tracks edited by the user come first
+        if (!mInvalidTracks.isEmpty())
+        {
+            const QString trackName = *mInvalidTracks.begin();
+            mInvalidTracks.erase(mInvalidTracks.begin());
+            return trackName;
+        }
+
+        signature = mSignature;
+        priorityTracks = mPriorityTracks;
+    }
+
+    // Then the current and checked tracks
+    foreach (const QString &trackName, priorityTracks)
+    {
+        if (isStale(trackName, signature)) return trackName;
+    }
+
+    // Then everything else
+    // Logs split into jumps are summarized by jump
+    QSqlQuery query(mDatabase);
+    query.prepare("select files.file_name from files "
+                  "left join track_state on track_state.file_name = files.file_name "
+                  "where (track_state.signature is null or track_state.signature != ?) "
+                  "and files.file_name not in (select parent from jumps) "
+                  "limit 1");
+    query.addBindValue(signature);
+
+    if (!query.exec() || !query.next())
+    {
+        return QString();
+    }
+
+    return query.value(0).toString();
+}
+
+bool ReprocessWorker::isStale(
+        const QString &trackName,
+        const QString &signature)
+{
+    QSqlQuery query(mDatabase);
+    query.prepare("select track_state.signature from files "
+                  "left join track_state on track_state.file_name = files.file_name "
+                  "where files.file_name = ?");
+    query.addBindValue(trackName);
+
+    if (!query.exec() || !query.next())
+    {
+        return false;
+    }
+
+    return query.value(0).isNull() || query.value(0).toString() != signature;
+}
+
+bool ReprocessWorker::process(
+        const QString &trackName,
+        QSqlError &error)
+{
+    QSqlQuery query(mDatabase);
+
+    // Forget tracks removed from the logbook
+    query.prepare("select ground, exit, wind_e, wind_n from files where file_name = ?");
+    query.addBindValue(trackName);
+
+    if (!query.exec() || !query.next())
+    {
+        query.prepare("delete from track_state where file_name = ?");
+        query.addBindValue(trackName);
+
+        if (!query.exec())
+        {
+            error = query.lastError();
+            return false;
+        }
+
+        return true;
+    }
+
+    BatchProcessor::Options options;
+    QString signature;
+
+    {
+        QMutexLocker locker(&mMutex);
+        options = mOptions;
+        signature = mSignature;
+    }
+
+    // Use values saved for this track, as MainWindow::init does
+    if (!query.value(0).isNull())
+    {
+        options.fixedGround = true;
+        options.fixedReference = query.value(0).toDouble();
+    }
+
+    if (!query.value(2).isNull() && !query.value(3).isNull())
+    {
+        options.windE = query.value(2).toDouble();
+        options.windN = query.value(3).toDouble();
+    }
+
+    const QString exit = query.value(1).toString();
+
+    // Derive and summarize
+    TrackUtil::DataPoints data;
+
+    // Record the result, even on failure, so the track isn't retried
+    // until the settings change again
+    if (TrackSegments::load(mDatabase, mDatabasePath, trackName, data) >= 2)
+    {
+        BatchProcessor::derive(data, options);
+
+        if (!exit.isEmpty())
+        {
+            TrackUtil::setExit(data, QDateTime::fromString(exit, Qt::ISODate).toMSecsSinceEpoch());
+        }
+
+        const TrackSummary::Summary summary = TrackSummary::compute(data);
+        return TrackSummary::write(mDatabase, trackName, signature, &summary, &error);
+    }
+    else
+    {
+        return TrackSummary::write(mDatabase, trackName, signature, 0, &error);
+    }
+}
+
+ReprocessQueue::ReprocessQueue(
+        QObject *parent):
+    QObject(parent),
+    mThread(new QThread),
+    mWorker(new ReprocessWorker)
+{
+    mWorker->moveToThread(mThread);
+
+    connect(mWorker, SIGNAL(idle()), this, SIGNAL(idle()));
+    connect(mWorker, SIGNAL(failed(QString,QString)),
+            this, SIGNAL(failed(QString,QString)));
+
+    mThread->start(QThread::LowestPriority);
+}
+
+ReprocessQueue::~ReprocessQueue()
+{
+    // Finish the current track and close the connection on its thread
+    mWorker->cancel();
+    QMetaObject::invokeMethod(mWorker, "close", Qt::BlockingQueuedConnection);
+
+    mThread->quit();
+    mThread->wait();
+
+    delete mWorker;
+    delete mThread;
+}
+
+void ReprocessQueue::start(
+        const QString &databasePath)
+{
+    QMetaObject::invokeMethod(mWorker, "open", Qt::QueuedConnection,
+                              Q_ARG(QString, databasePath));
+}
+
+void ReprocessQueue::setOptions(
+        const BatchProcessor::Options &options)
+{
+    mWorker->setOptions(options);
+    wake();
+}
+
+QString ReprocessQueue::signature() const
+{
+    return mWorker->currentSignature();
+}
+
+void ReprocessQueue::setPriorityTracks(
+        const QStringList &trackNames)
+{
+    mWorker->setPriorityTracks(trackNames);
+    wake();
+}
+
+void ReprocessQueue::invalidate(
+        const QString &trackName)
+{
+    mWorker->invalidate(trackName);
+    wake();
+}
+
+void ReprocessQueue::wake()
+{
+    QMetaObject::invokeMethod(mWorker, "wake", Qt::QueuedConnection);
+}
@@ -0,0 +1,119 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef REPROCESSQUEUE_H
+#define REPROCESSQUEUE_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QStringList>
+
+#include "batchprocessor.h"
+
+class QSqlError;
+class QThread;
+class QTimer;
+
+/* Re-derives and summarizes logbook tracks in the background. Each track's
+ * summary is stored in the track_state table (see TrackSummary) with a
+ * signature of the settings it was derived with, so tracks are picked up
+ * again whenever the settings change, and unfinished work resumes on the
+ * next run. Methods are called from the GUI thread; the worker runs on its own
+ * low priority thread with its own database connection. If a summary can't be
+ * stored, the worker backs off and reports only the first failure. */
+class ReprocessWorker : public QObject
+{
+    Q_OBJECT
+public:
+    ReprocessWorker();
+
+    void setOptions(const BatchProcessor::Options &options);
+    QString currentSignature();
+    void setPriorityTracks(const QStringList &trackNames);
+    void invalidate(const QString &trackName);
+    void cancel();
+
+    static QString signature(const BatchProcessor::Options &options);
+
+private:
+    QString                 mDatabasePath;
+    QSqlDatabase            mDatabase;
+    QTimer                 *mTimer;
+
+    QMutex                  mMutex;
+    BatchProcessor::Options mOptions;
+    QString                 mSignature;
+    QStringList             mPriorityTracks;
+    QSet< QString >         mInvalidTracks;
+
+    QAtomicInt              mCancel;
+    int                     mProcessed;
+    int                     mFailures;
+
+    QString nextTrack();
+    bool isStale(const QString &trackName, const QString &signature);
+    bool process(const QString &trackName, QSqlError &error);
+
+signals:
+    void idle();
+    void failed(const QString &trackName, const QString &error);
+
+public slots:
+    void open(const QString &databasePath);
+    void close();
+    void wake();
+
+private slots:
+    void processNext();
+};
+
+class ReprocessQueue : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ReprocessQueue(QObject *parent = 0);
+    ~ReprocessQueue();
+
+    void start(const QString &databasePath);
+
+    void setOptions(const BatchProcessor::Options &options);
+    QString signature() const;
+    void setPriorityTracks(const QStringList &trackNames);
+    void invalidate(const QString &trackName);
+
+public slots:
+    void wake();
+
+signals:
+    void idle();
+    void failed(const QString &trackName, const QString &error);
+
+private:
+    QThread         *mThread;
+    ReprocessWorker *mWorker;
+};
+
+#endif // REPROCESSQUEUE_H
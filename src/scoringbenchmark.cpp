@@ -0,0 +1,254 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "scoringbenchmark.h"
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include "scoringserver.h"
+
+#define TIMEOUT 5000    // Response timeout (ms)
+
+typedef struct {
+    QVector< qint64 > latencies;    // Request latencies (ns)
+    int               failures;
+} ClientResult;
+
+// Sends a series of requests on one connection
+class BenchmarkClient
+{
+public:
+    typedef ClientResult result_type;
+
+    BenchmarkClient(quint16 port,
+                    const QByteArray &body,
+                    int requestCount):
+        mPort(port),
+        mBody(body),
+        mRequestCount(requestCount)
+    {
+
+    }
+
+    ClientResult operator()(int client) const;
+
+private:
+    quint16     mPort;
+    QByteArray  mBody;
+    int         mRequestCount;
+
+    static bool readResponse(QTcpSocket &socket);
+};
+
+ClientResult BenchmarkClient::operator()(
+        int client) const
+{
+    Q_UNUSED(client);
+
+    ClientResult result;
+    result.latencies.reserve(mRequestCount);
+    result.failures = 0;
+
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, mPort);
+    if (!socket.waitForConnected(TIMEOUT))
+    {
+        result.failures = mRequestCount;
+        return result;
+    }
+
+    const QByteArray request =
+            "POST /score HTTP/1.1\r\n"
+            "Host: localhost\r\n"
+            "Content-Type: application/json\r\n"
+            "Content-Length: " + QByteArray::number(mBody.size()) + "\r\n"
+            "\r\n" + mBody;
+
+    QElapsedTimer timer;
+
+    for (int i = 0; i < mRequestCount; ++i)
+    {
+        timer.start();
+
+        socket.write(request);
+        if (!readResponse(socket))
+        {
+            result.failures += mRequestCount - i;
+            break;
+        }
+
+        result.latencies.append(timer.nsecsElapsed());
+    }
+
+    socket.disconnectFromHost();
+
+    return result;
+}
+
+bool BenchmarkClient::readResponse(
+        QTcpSocket &socket)
+{
+    bool ok = false;
+    qint64 contentLength = 0;
+
+    // Read status line and headers
+    for (bool first = true; ; first = false)
+    {
+        while (!socket.canReadLine())
+        {
+            if (!socket.waitForReadyRead(TIMEOUT)) return false;
+        }
+
+        const QByteArray line = socket.readLine().trimmed();
+        if (line.isEmpty()) break;
+
+        if (first)
+        {
+            ok = line.startsWith("HTTP/1.1 200");
+        }
+        else if (line.toLower().startsWith("content-length:"))
+        {
+            contentLength = line.mid(15).trimmed().toLongLong();
+        }
+    }
+
+    // Discard body
+    while (contentLength > 0)
+    {
+        if (socket.bytesAvailable() == 0 && !socket.waitForReadyRead(TIMEOUT))
+        {
+            return false;
+        }
+
+        contentLength -= socket.read(contentLength).size();
+    }
+
+    return ok;
+}
+
+ScoringBenchmark::ScoringBenchmark():
+    mMethod("ppc"),
+    mThreadCount(QThread::idealThreadCount()),
+    mClientCount(QThread::idealThreadCount()),
+    mRequestCount(1000)
+{
+
+}
+
+int ScoringBenchmark::run()
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    ScoringServer server;
+    server.setThreadCount(mThreadCount);
+
+    if (!server.start(0))
+    {
+        err << QString("Couldn't start server: %1").arg(server.errorString()) << endl;
+        return 1;
+    }
+
+    QFile file(mTrackPath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        err << QString("Couldn't read %1").arg(mTrackPath) << endl;
+        return 1;
+    }
+
+    // Import directly so the cache is warm before timing starts
+    int status;
+    const QByteArray reply = server.handle("POST", "/import", file.readAll(), status);
+    if (status != 200)
+    {
+        err << QString("Couldn't import %1: %2").arg(mTrackPath).arg(QString(reply)) << endl;
+        return 1;
+    }
+
+    QJsonObject request;
+    request["id"] = QJsonDocument::fromJson(reply).object()["id"];
+    if (!mMethod.isEmpty()) request["method"] = mMethod;
+
+    const QByteArray body = QJsonDocument(request).toJson(QJsonDocument::Compact);
+
+    // Derive once so every timed request hits the cache
+    server.handle("POST", "/derive", body, status);
+
+    QVector< int > clients;
+    for (int i = 0; i < mClientCount; ++i)
+    {
+        clients.append(i);
+    }
+
+    QThreadPool::globalInstance()->setMaxThreadCount(mClientCount);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Server accepts connections on this thread, so wait in an event loop
+    QFutureWatcher< ClientResult > watcher;
+    QEventLoop loop;
+    QObject::connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+    watcher.setFuture(QtConcurrent::mapped(clients, BenchmarkClient(server.serverPort(), body, mRequestCount)));
+    loop.exec();
+
+    const double elapsed = timer.nsecsElapsed() / 1e9;
+
+    QVector< qint64 > latencies;
+    int failures = 0;
+
+    const QList< ClientResult > results = watcher.future().results();
+    foreach (const ClientResult &result, results)
+    {
+        latencies += result.latencies;
+        failures += result.failures;
+    }
+
+    qSort(latencies);
+
+    out << QString("Clients:      %1").arg(mClientCount) << endl;
+    out << QString("Threads:      %1").arg(mThreadCount) << endl;
+    out << QString("Requests:     %1 (%2 failed)").arg(latencies.size()).arg(failures) << endl;
+    out << QString("Elapsed:      %1 s").arg(elapsed, 0, 'f', 3) << endl;
+    out << QString("Throughput:   %1 requests/s").arg(latencies.size() / elapsed, 0, 'f', 1) << endl;
+
+    if (!latencies.isEmpty())
+    {
+        const int n = latencies.size();
+        out << QString("Latency p50:  %1 ms").arg(latencies[n / 2] / 1e6, 0, 'f', 3) << endl;
+        out << QString("Latency p95:  %1 ms").arg(latencies[qMin(n - 1, n * 95 / 100)] / 1e6, 0, 'f', 3) << endl;
+        out << QString("Latency p99:  %1 ms").arg(latencies[qMin(n - 1, n * 99 / 100)] / 1e6, 0, 'f', 3) << endl;
+    }
+
+    return (failures > 0) ? 2 : 0;
+}
@@ -0,0 +1,54 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef SCORINGBENCHMARK_H
+#define SCORINGBENCHMARK_H
+
+#include <QString>
+
+/* Load test for ScoringServer. Starts a server in this process, imports a
+ * track and has several clients request scores over keep-alive
+ * connections, then reports throughput and latency. Clients beyond the
+ * server thread count wait for a free thread. */
+class ScoringBenchmark
+{
+public:
+    ScoringBenchmark();
+
+    void setTrackPath(const QString &trackPath) { mTrackPath = trackPath; }
+    void setMethod(const QString &method) { mMethod = method; }
+    void setThreadCount(int threadCount) { mThreadCount = threadCount; }
+    void setClientCount(int clientCount) { mClientCount = clientCount; }
+    void setRequestCount(int requestCount) { mRequestCount = requestCount; }
+
+    int run();
+
+private:
+    QString mTrackPath;
+    QString mMethod;
+    int     mThreadCount;
+    int     mClientCount;
+    int     mRequestCount;
+};
+
+#endif // SCORINGBENCHMARK_H
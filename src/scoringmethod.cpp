@@ -37,11 +37,49 @@ void ScoringMethod::optimize(
 {
     if (mainWindow->dataSize() == 0) return;
 
-    const DataPoint &dp0 = mainWindow->interpolateDataT(0);
+    Optimization params;
+    params.minDrag = mainWindow->minDrag();
+    params.minLift = mainWindow->minLift();
+    params.maxLift = mainWindow->maxLift();
+    params.maxLD = mainWindow->maxLD();
+    params.simulationTime = mainWindow->simulationTime();
+    params.planformArea = mainWindow->planformArea();
+    params.mass = mainWindow->mass();
 
+    QProgressDialog progress("Initializing...",
+                             "Abort",
+                             0,
+                             0,
+                             mainWindow);
+    progress.setWindowModality(Qt::WindowModal);
+
+    const MainWindow::DataPoints result = evolve(params, mainWindow->interpolateDataT(0), windowBottom, &progress);
+
+    // Keep most fit individual
+    if (!result.isEmpty())
+    {
+        mainWindow->setOptimal(result);
+    }
+}
+
+const TrackUtil::PhaseIndex *ScoringMethod::phaseIndex(
+        const MainWindow *mainWindow,
+        const TrackUtil::DataPoints &result)
+{
+    // Headless scoring and optimizer results have no index
+    if (!mainWindow || &result != &mainWindow->data()) return 0;
+    return &mainWindow->phaseIndex();
+}
+
+MainWindow::DataPoints ScoringMethod::evolve(
+        const Optimization &params,
+        const DataPoint &dp0,
+        double windowBottom,
+        QProgressDialog *progress)
+{
     // y = ax^2 + c
-    const double m = 1 / mainWindow->maxLD();
-    const double c = mainWindow->minDrag();
+    const double m = 1 / params.maxLD;
+    const double c = params.minDrag;
     const double a = m * m / (4 * c);
 
     const int workingSize    = 100;     // Working population
@@ -57,7 +95,7 @@ void ScoringMethod::optimize(
     const double dt = 0.25; // Time step (s)
 
     int kLim = 0;
-    while (dt * (1 << kLim) < mainWindow->simulationTime())
+    while (dt * (1 << kLim) < params.simulationTime)
     {
         ++kLim;
     }
@@ -68,12 +106,10 @@ void ScoringMethod::optimize(
 
     GenePool genePool;
 
-    QProgressDialog progress("Initializing...",
-                             "Abort",
-                             0,
-                             (kMax - kMin + 1) * numGenerations * workingSize + workingSize,
-                             mainWindow);
-    progress.setWindowModality(Qt::WindowModal);
+    if (progress)
+    {
+        progress->setMaximum((kMax - kMin + 1) * numGenerations * workingSize + workingSize);
+    }
 
     double maxScore = 0;
     bool abort = false;
@@ -81,15 +117,18 @@ void ScoringMethod::optimize(
     // Add new individuals
     for (int i = 0; i < workingSize; ++i)
     {
-        progress.setValue(progress.value() + 1);
-        if (progress.wasCanceled())
+        if (progress)
         {
-            abort = true;
-            break;
+            progress->setValue(progress->value() + 1);
+            if (progress->wasCanceled())
+            {
+                abort = true;
+                break;
+            }
         }
 
-        Genome g(genomeSize, kMin, mainWindow->minLift(), mainWindow->maxLift());
-        const MainWindow::DataPoints result = g.simulate(dt, a, c, mainWindow->planformArea(), mainWindow->mass(), dp0, windowBottom);
+        Genome g(genomeSize, kMin, params.minLift, params.maxLift);
+        const MainWindow::DataPoints result = g.simulate(dt, a, c, params.planformArea, params.mass, dp0, windowBottom);
         const double s = score(result);
         genePool.append(Score(s, g));
 
@@ -102,11 +141,14 @@ void ScoringMethod::optimize(
         // Generations
         for (int j = 0; j < numGenerations && !abort; ++j)
         {
-            progress.setValue(progress.value() + keepSize);
-            if (progress.wasCanceled())
+            if (progress)
             {
-                abort = true;
-                break;
+                progress->setValue(progress->value() + keepSize);
+                if (progress->wasCanceled())
+                {
+                    abort = true;
+                    break;
+                }
             }
 
             // Sort gene pool by score
@@ -125,15 +167,18 @@ void ScoringMethod::optimize(
             // Add new individuals in first level
             for (int i = 0; k == kMin && i < newSize; ++i)
             {
-                progress.setValue(progress.value() + 1);
-                if (progress.wasCanceled())
+                if (progress)
                 {
-                    abort = true;
-                    break;
+                    progress->setValue(progress->value() + 1);
+                    if (progress->wasCanceled())
+                    {
+                        abort = true;
+                        break;
+                    }
                 }
 
-                Genome g(genomeSize, kMin, mainWindow->minLift(), mainWindow->maxLift());
-                const MainWindow::DataPoints result = g.simulate(dt, a, c, mainWindow->planformArea(), mainWindow->mass(), dp0, windowBottom);
+                Genome g(genomeSize, kMin, params.minLift, params.maxLift);
+                const MainWindow::DataPoints result = g.simulate(dt, a, c, params.planformArea, params.mass, dp0, windowBottom);
                 const double s = score(result);
                 newGenePool.append(Score(s, g));
 
@@ -143,11 +188,14 @@ void ScoringMethod::optimize(
             // Tournament selection
             while (newGenePool.size() < workingSize)
             {
-                progress.setValue(progress.value() + 1);
-                if (progress.wasCanceled())
+                if (progress)
                 {
-                    abort = true;
-                    break;
+                    progress->setValue(progress->value() + 1);
+                    if (progress->wasCanceled())
+                    {
+                        abort = true;
+                        break;
+                    }
                 }
 
                 const Genome &p1 = selectGenome(genePool, tournamentSize);
@@ -160,10 +208,10 @@ void ScoringMethod::optimize(
                 }
                 if (qrand() % 100 < mutationRate)
                 {
-                    g.mutate(k, kMin, mainWindow->minLift(), mainWindow->maxLift());
+                    g.mutate(k, kMin, params.minLift, params.maxLift);
                 }
 
-                const MainWindow::DataPoints result = g.simulate(dt, a, c, mainWindow->planformArea(), mainWindow->mass(), dp0, windowBottom);
+                const MainWindow::DataPoints result = g.simulate(dt, a, c, params.planformArea, params.mass, dp0, windowBottom);
                 const double s = score(result);
                 newGenePool.append(Score(s, g));
 
@@ -173,20 +221,28 @@ void ScoringMethod::optimize(
             genePool = newGenePool;
 
             // Show best score in progress dialog
-            QString labelText = scoreAsText(maxScore);
-            progress.setLabelText(QString("Optimizing (best score is ") +
-                                  labelText +
-                                  QString(")..."));
+            if (progress)
+            {
+                QString labelText = scoreAsText(maxScore);
+                progress->setLabelText(QString("Optimizing (best score is ") +
+                                       labelText +
+                                       QString(")..."));
+            }
         }
     }
 
-    progress.setValue((kMax - kMin + 1) * numGenerations * workingSize + workingSize);
+    if (progress)
+    {
+        progress->setValue(progress->maximum());
+    }
+
+    if (genePool.isEmpty()) return MainWindow::DataPoints();
 
     // Sort gene pool by score
     qSort(genePool);
 
-    // Keep most fit individual
-    mainWindow->setOptimal(genePool[0].second.simulate(dt, a, c, mainWindow->planformArea(), mainWindow->mass(), dp0, windowBottom));
+    // Return most fit individual
+    return genePool[0].second.simulate(dt, a, c, params.planformArea, params.mass, dp0, windowBottom);
 }
 
 const Genome &ScoringMethod::selectGenome(
@@ -30,10 +30,12 @@
 
 #include "datapoint.h"
 #include "genome.h"
+#include "trackutil.h"
 
 class DataPlot;
 class MainWindow;
 class MapView;
+class QProgressDialog;
 
 typedef QPair< double, Genome > Score;
 typedef QVector< Score > GenePool;
@@ -62,9 +64,28 @@ public:
     virtual void readSettings() {}
     virtual void writeSettings() {}
 
+    typedef struct {
+        double minDrag;
+        double minLift, maxLift;
+        double maxLD;
+        int    simulationTime;
+        double planformArea;
+        double mass;
+    } Optimization;
+
+    // Optimize a trajectory starting at dp0, reporting progress to the
+    // dialog if one is given
+    MainWindow::DataPoints evolve(const Optimization &params, const DataPoint &dp0,
+                                  double windowBottom, QProgressDialog *progress = 0);
+
 protected:
     void optimize(MainWindow *mainWindow, double windowBottom);
 
+    // Phase index cached by the main window for its track, or 0 for
+    // other results, which are short-lived and scanned in full
+    static const TrackUtil::PhaseIndex *phaseIndex(const MainWindow *mainWindow,
+                                                   const TrackUtil::DataPoints &result);
+
 private:
     const Genome &selectGenome(const GenePool &genePool, const int tournamentSize);
 
@@ -0,0 +1,642 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "scoringserver.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QSettings>
+#include <QTcpSocket>
+
+#include "flarescoring.h"
+#include "ppcscoring.h"
+#include "speedscoring.h"
+
+#define MAX_HEADER_SIZE (64 * 1024)         // Request line and headers (bytes)
+#define MAX_BODY_SIZE   (64 * 1024 * 1024)  // Request body (bytes)
+#define TIMEOUT         5000                // Timeout within a request (ms)
+#define IDLE_TIMEOUT    2000                // Keep-alive wait for the next request (ms)
+#define MAX_PENDING     64                  // Connections waiting for a thread
+
+// Serves requests on one connection until it is closed
+class ScoringConnection : public QRunnable
+{
+public:
+    ScoringConnection(ScoringServer *server,
+                      qintptr socketDescriptor):
+        mServer(server),
+        mSocketDescriptor(socketDescriptor)
+    {
+
+    }
+
+    void run();
+
+private:
+    ScoringServer *mServer;
+    qintptr        mSocketDescriptor;
+
+    void serve();
+
+    static bool readRequest(QTcpSocket &socket, int idleTimeout,
+                            QByteArray &method, QByteArray &path,
+                            QByteArray &body, bool &keepAlive, int &status);
+    static void writeResponse(QTcpSocket &socket, int status,
+                              const QByteArray &body, bool keepAlive);
+};
+
+void ScoringConnection::run()
+{
+    serve();
+
+    mServer->mConnections.deref();
+}
+
+void ScoringConnection::serve()
+{
+    QTcpSocket socket;
+    if (!socket.setSocketDescriptor(mSocketDescriptor)) return;
+
+    // Only serve local clients
+    if (!socket.peerAddress().isLoopback())
+    {
+        socket.abort();
+        return;
+    }
+
+    bool keepAlive = true;
+    for (int count = 0; keepAlive; ++count)
+    {
+        QByteArray method, path, body;
+        int status = 200;
+
+        // Don't hold the thread long for a client that may not send more
+        const int idleTimeout = (count == 0) ? TIMEOUT : IDLE_TIMEOUT;
+
+        if (!readRequest(socket, idleTimeout, method, path, body, keepAlive, status))
+        {
+            if (status != 200)
+            {
+                writeResponse(socket, status, "{\"error\":\"Malformed request\"}", false);
+            }
+            break;
+        }
+
+        const QByteArray reply = mServer->handle(method, path, body, status);
+
+        // Let waiting connections have the thread
+        if (mServer->isBusy()) keepAlive = false;
+
+        writeResponse(socket, status, reply, keepAlive);
+    }
+
+    socket.disconnectFromHost();
+    if (socket.state() != QAbstractSocket::UnconnectedState)
+    {
+        socket.waitForDisconnected(TIMEOUT);
+    }
+}
+
+bool ScoringConnection::readRequest(
+        QTcpSocket &socket,
+        int idleTimeout,
+        QByteArray &method,
+        QByteArray &path,
+        QByteArray &body,
+        bool &keepAlive,
+        int &status)
+{
+    QList< QByteArray > lines;
+    int headerSize = 0;
+
+    // Read request line and headers
+    while (true)
+    {
+        while (!socket.canReadLine())
+        {
+            if (socket.bytesAvailable() > MAX_HEADER_SIZE)
+            {
+                status = 413;
+                return false;
+            }
+
+            const bool idle = lines.isEmpty() && socket.bytesAvailable() == 0;
+            if (!socket.waitForReadyRead(idle ? idleTimeout : TIMEOUT)) return false;
+        }
+
+        const QByteArray line = socket.readLine().trimmed();
+        headerSize += line.size();
+
+        if (headerSize > MAX_HEADER_SIZE)
+        {
+            status = 413;
+            return false;
+        }
+
+        if (line.isEmpty())
+        {
+            if (lines.isEmpty()) continue;  // Tolerate stray line breaks
+            break;
+        }
+
+        lines.append(line);
+    }
+
+    const QList< QByteArray > request = lines.first().split(' ');
+    if (request.size() != 3)
+    {
+        status = 400;
+        return false;
+    }
+
+    method = request[0];
+    path = request[1];
+    keepAlive = (request[2] == "HTTP/1.1");
+
+    qint64 contentLength = 0;
+    for (int i = 1; i < lines.size(); ++i)
+    {
+        const int colon = lines[i].indexOf(':');
+        if (colon < 0) continue;
+
+        const QByteArray name = lines[i].left(colon).trimmed().toLower();
+        const QByteArray value = lines[i].mid(colon + 1).trimmed();
+
+        if (name == "content-length")
+        {
+            contentLength = value.toLongLong();
+        }
+        else if (name == "connection")
+        {
+            keepAlive = (value.toLower() == "keep-alive");
+        }
+    }
+
+    if (contentLength < 0 || contentLength > MAX_BODY_SIZE)
+    {
+        status = 413;
+        return false;
+    }
+
+    // Read body
+    body.reserve(contentLength);
+    while (body.size() < contentLength)
+    {
+        if (socket.bytesAvailable() == 0 && !socket.waitForReadyRead(TIMEOUT))
+        {
+            return false;
+        }
+
+        body.append(socket.read(contentLength - body.size()));
+    }
+
+    return true;
+}
+
+void ScoringConnection::writeResponse(
+        QTcpSocket &socket,
+        int status,
+        const QByteArray &body,
+        bool keepAlive)
+{
+    const char *reason;
+    switch (status)
+    {
+    case 200: reason = "OK"; break;
+    case 400: reason = "Bad Request"; break;
+    case 404: reason = "Not Found"; break;
+    case 405: reason = "Method Not Allowed"; break;
+    case 413: reason = "Payload Too Large"; break;
+    default:  reason = "Internal Server Error"; break;
+    }
+
+    QByteArray header;
+    header.reserve(128);
+    header += "HTTP/1.1 " + QByteArray::number(status) + " " + reason + "\r\n";
+    header += "Content-Type: application/json\r\n";
+    header += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    header += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+
+    socket.write(header);
+    socket.write(body);
+
+    while (socket.bytesToWrite() > 0)
+    {
+        if (!socket.waitForBytesWritten(TIMEOUT)) break;
+    }
+}
+
+ScoringServer::ScoringServer(QObject *parent) :
+    QTcpServer(parent),
+    mCache(64)
+{
+    mOptions = BatchProcessor::defaultOptions();
+
+    mOptimization.minDrag = 0.05;
+    mOptimization.minLift = 0.0;
+    mOptimization.maxLift = 0.5;
+    mOptimization.maxLD = 3.0;
+    mOptimization.simulationTime = 120;
+
+    // Use the same settings as the main window
+    QSettings settings("FlySight", "Viewer");
+
+    settings.beginGroup("mainWindow");
+        mOptimization.minDrag = settings.value("minDrag", mOptimization.minDrag).toDouble();
+        mOptimization.minLift = settings.value("minLift", mOptimization.minLift).toDouble();
+        mOptimization.maxLift = settings.value("maxLift", mOptimization.maxLift).toDouble();
+        mOptimization.maxLD = settings.value("maxLD", mOptimization.maxLD).toDouble();
+        mOptimization.simulationTime = settings.value("simulationTime", mOptimization.simulationTime).toInt();
+    settings.endGroup();
+}
+
+bool ScoringServer::start(
+        quint16 port)
+{
+    return listen(QHostAddress::LocalHost, port);
+}
+
+void ScoringServer::setThreadCount(
+        int threadCount)
+{
+    mPool.setMaxThreadCount(threadCount);
+}
+
+void ScoringServer::setCacheSize(
+        int cacheSize)
+{
+    QMutexLocker locker(&mMutex);
+    mCache.setMaxCost(cacheSize);
+}
+
+void ScoringServer::incomingConnection(
+        qintptr socketDescriptor)
+{
+    // Refuse connections rather than queue them without limit
+    if (mConnections.loadAcquire() >= mPool.maxThreadCount() + MAX_PENDING)
+    {
+        const QByteArray body = "{\"error\":\"Server busy\"}";
+
+        QTcpSocket *socket = new QTcpSocket(this);
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+
+        if (!socket->setSocketDescriptor(socketDescriptor))
+        {
+            delete socket;
+            return;
+        }
+
+        socket->write("HTTP/1.1 503 Service Unavailable\r\n"
+                      "Content-Type: application/json\r\n"
+                      "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                      "Connection: close\r\n\r\n" + body);
+        socket->disconnectFromHost();
+        return;
+    }
+
+    mConnections.ref();
+    mPool.start(new ScoringConnection(this, socketDescriptor));
+}
+
+bool ScoringServer::isBusy() const
+{
+    // Connections are waiting for a thread
+    return mConnections.loadAcquire() > mPool.maxThreadCount();
+}
+
+QByteArray ScoringServer::handle(
+        const QByteArray &method,
+        const QByteArray &path,
+        const QByteArray &body,
+        int &status)
+{
+    QJsonObject reply;
+    status = 200;
+
+    if (path == "/status")
+    {
+        QMutexLocker locker(&mMutex);
+        reply["tracks"] = mCache.size();
+        reply["threads"] = mPool.maxThreadCount();
+    }
+    else if (path != "/import" && path != "/derive"
+             && path != "/score" && path != "/optimize")
+    {
+        status = 404;
+        reply = error("Unknown endpoint");
+    }
+    else if (method != "POST")
+    {
+        status = 405;
+        reply = error("Use POST");
+    }
+    else if (path == "/import")
+    {
+        reply = importTrack(body, status);
+    }
+    else
+    {
+        QJsonParseError parseError;
+        const QJsonDocument document = QJsonDocument::fromJson(body, &parseError);
+
+        if (!document.isObject())
+        {
+            status = 400;
+            reply = error(parseError.errorString());
+        }
+        else if (path == "/derive")
+        {
+            reply = deriveTrack(document.object(), status);
+        }
+        else if (path == "/score")
+        {
+            reply = scoreTrack(document.object(), status);
+        }
+        else
+        {
+            reply = optimizeTrack(document.object(), status);
+        }
+    }
+
+    return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+}
+
+QJsonObject ScoringServer::importTrack(
+        const QByteArray &body,
+        int &status)
+{
+    QByteArray contents = body;
+
+    const QString id = QCryptographicHash::hash(contents, QCryptographicHash::Sha1).toHex();
+
+    QJsonObject reply;
+    reply["id"] = id;
+
+    {
+        QMutexLocker locker(&mMutex);
+        if (Track *track = mCache.object(id))
+        {
+            reply["samples"] = track->raw.size();
+            reply["cached"] = true;
+            return reply;
+        }
+    }
+
+    QBuffer buffer(&contents);
+    buffer.open(QIODevice::ReadOnly);
+
+    Track *track = new Track;
+    if (TrackUtil::import(&buffer, track->raw) < 2)
+    {
+        delete track;
+        status = 400;
+        return error("Not enough data");
+    }
+
+    reply["samples"] = track->raw.size();
+    reply["cached"] = false;
+
+    QMutexLocker locker(&mMutex);
+    mCache.insert(id, track);
+
+    return reply;
+}
+
+QJsonObject ScoringServer::deriveTrack(
+        const QJsonObject &request,
+        int &status)
+{
+    QJsonObject reply;
+
+    TrackUtil::DataPoints data;
+    if (!findTrack(request, data, reply, status)) return reply;
+
+    reply["id"] = request["id"];
+    reply["summary"] = BatchProcessor::summarize(data);
+
+    return reply;
+}
+
+QJsonObject ScoringServer::scoreTrack(
+        const QJsonObject &request,
+        int &status)
+{
+    QJsonObject reply;
+
+    TrackUtil::DataPoints data;
+    if (!findTrack(request, data, reply, status)) return reply;
+
+    reply["id"] = request["id"];
+
+    // Report all scores if no method is given
+    if (!request.contains("method"))
+    {
+        reply["scores"] = BatchProcessor::score(data, options(request));
+        return reply;
+    }
+
+    double windowBottom;
+    QScopedPointer< ScoringMethod > method(createMethod(request, windowBottom, reply, status));
+    if (method.isNull()) return reply;
+
+    reply["method"] = request["method"];
+    reply["score"] = method->score(data);
+
+    return reply;
+}
+
+QJsonObject ScoringServer::optimizeTrack(
+        const QJsonObject &request,
+        int &status)
+{
+    QJsonObject reply;
+
+    TrackUtil::DataPoints data;
+    if (!findTrack(request, data, reply, status)) return reply;
+
+    double windowBottom;
+    QScopedPointer< ScoringMethod > method(createMethod(request, windowBottom, reply, status));
+    if (method.isNull()) return reply;
+
+    const BatchProcessor::Options opts = options(request);
+
+    ScoringMethod::Optimization params = mOptimization;
+    params.mass = opts.mass;
+    params.planformArea = opts.planformArea;
+
+    const TrackUtil::DataPoints result =
+            method->evolve(params, TrackUtil::interpolateDataT(data, 0), windowBottom);
+
+    QJsonArray t, x, z;
+    for (int i = 0; i < result.size(); ++i)
+    {
+        const DataPoint &dp = result[i];
+        t.append(dp.t);
+        x.append(dp.x);
+        z.append(dp.z);
+    }
+
+    reply["id"] = request["id"];
+    reply["method"] = request["method"];
+    reply["score"] = method->score(result);
+    reply["t"] = t;
+    reply["x"] = x;
+    reply["z"] = z;
+
+    return reply;
+}
+
+bool ScoringServer::findTrack(
+        const QJsonObject &request,
+        TrackUtil::DataPoints &data,
+        QJsonObject &reply,
+        int &status)
+{
+    const QString id = request["id"].toString();
+
+    const BatchProcessor::Options opts = options(request);
+    const QString key = QString("%1,%2,%3,%4,%5,%6,%7")
+            .arg(opts.mass).arg(opts.planformArea)
+            .arg(opts.windE).arg(opts.windN)
+            .arg(opts.fixedGround).arg(opts.fixedReference)
+            .arg(opts.windAdjustment);
+
+    QMutexLocker locker(&mMutex);
+
+    Track *track = mCache.object(id);
+    if (!track)
+    {
+        status = 404;
+        reply = error("Unknown track; import it first");
+        return false;
+    }
+
+    // Data is implicitly shared, so copies are cheap
+    if (track->optionsKey == key && !track->data.isEmpty())
+    {
+        data = track->data;
+        return true;
+    }
+
+    data = track->raw;
+
+    // Derive without holding the lock
+    locker.unlock();
+    BatchProcessor::derive(data, opts);
+    locker.relock();
+
+    // Track may have been evicted in the meantime
+    track = mCache.object(id);
+    if (track)
+    {
+        track->data = data;
+        track->optionsKey = key;
+    }
+
+    return true;
+}
+
+BatchProcessor::Options ScoringServer::options(
+        const QJsonObject &request) const
+{
+    BatchProcessor::Options opts = mOptions;
+
+    if (request.contains("mass")) opts.mass = request["mass"].toDouble();
+    if (request.contains("planformArea")) opts.planformArea = request["planformArea"].toDouble();
+    if (request.contains("windE")) opts.windE = request["windE"].toDouble();
+    if (request.contains("windN")) opts.windN = request["windN"].toDouble();
+    if (request.contains("windAdjustment")) opts.windAdjustment = request["windAdjustment"].toBool();
+
+    if (request.contains("ground"))
+    {
+        opts.fixedGround = true;
+        opts.fixedReference = request["ground"].toDouble();
+    }
+
+    return opts;
+}
+
+ScoringMethod *ScoringServer::createMethod(
+        const QJsonObject &request,
+        double &windowBottom,
+        QJsonObject &reply,
+        int &status) const
+{
+    const QString name = request["method"].toString();
+
+    if (name == "ppc")
+    {
+        PPCScoring *method = new PPCScoring(0);
+        method->readSettings();
+
+        const QString mode = request["mode"].toString();
+        if (mode == "time") method->setMode(PPCScoring::Time);
+        else if (mode == "distance") method->setMode(PPCScoring::Distance);
+        else if (mode == "speed") method->setMode(PPCScoring::Speed);
+
+        method->setWindAdjustment(options(request).windAdjustment);
+
+        method->setWindow(request["windowBottom"].toDouble(method->windowBottom()),
+                          request["windowTop"].toDouble(method->windowTop()));
+
+        windowBottom = method->windowBottom();
+        return method;
+    }
+    else if (name == "speed")
+    {
+        SpeedScoring *method = new SpeedScoring(0);
+
+        method->setFromExit(request["fromExit"].toDouble(method->fromExit()));
+        method->setWindowBottom(request["windowBottom"].toDouble(method->windowBottom()));
+        method->setValidationWindow(request["validationWindow"].toDouble(method->validationWindow()));
+
+        windowBottom = method->windowBottom();
+        return method;
+    }
+    else if (name == "flare")
+    {
+        FlareScoring *method = new FlareScoring(0);
+
+        method->setWindowBottom(request["windowBottom"].toDouble(method->windowBottom()));
+
+        windowBottom = method->windowBottom();
+        return method;
+    }
+
+    status = 400;
+    reply = error("Unknown method; use ppc, speed or flare");
+    return 0;
+}
+
+QJsonObject ScoringServer::error(
+        const QString &message)
+{
+    QJsonObject reply;
+    reply["error"] = message;
+    return reply;
+}
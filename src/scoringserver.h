@@ -0,0 +1,106 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef SCORINGSERVER_H
+#define SCORINGSERVER_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QCache>
+#include <QJsonObject>
+#include <QMutex>
+#include <QTcpServer>
+#include <QThreadPool>
+
+#include "batchprocessor.h"
+#include "scoringmethod.h"
+
+/* Minimal HTTP/JSON service for competition tooling. Listens on localhost
+ * only and serves connections from a bounded pool of worker threads. A
+ * keep-alive connection gives up its thread when it goes idle, or after
+ * its current request if other connections are waiting; connections beyond
+ * the queue limit are refused with 503. Imported tracks are kept in a cache
+ * keyed by the SHA-1 of the log, along with the last derived version of
+ * each.
+ *
+ *   POST /import    CSV log                        -> {"id", "samples"}
+ *   POST /derive    {"id", options}                -> {"id", "summary"}
+ *   POST /score     {"id", "method", options}      -> {"id", "method", "score"}
+ *   POST /optimize  {"id", "method", options}      -> {"id", "method", "score", "t", "x", "z"}
+ *   GET  /status                                   -> {"tracks", "threads"}
+ *
+ * Options are mass, planformArea, windE, windN, ground and windAdjustment,
+ * defaulting to the main window settings. Methods are ppc, speed and
+ * flare, with their window settings as optional overrides. Without a
+ * method, /score returns all scores as in the batch report. */
+class ScoringServer : public QTcpServer
+{
+    Q_OBJECT
+public:
+    explicit ScoringServer(QObject *parent = 0);
+
+    bool start(quint16 port);
+
+    void setThreadCount(int threadCount);
+    void setCacheSize(int cacheSize);
+
+    QByteArray handle(const QByteArray &method, const QByteArray &path,
+                      const QByteArray &body, int &status);
+
+protected:
+    void incomingConnection(qintptr socketDescriptor);
+
+private:
+    friend class ScoringConnection;
+
+    typedef struct {
+        TrackUtil::DataPoints raw;
+        TrackUtil::DataPoints data;
+        QString               optionsKey;
+    } Track;
+
+    QThreadPool                     mPool;
+    QAtomicInt                      mConnections;
+    QMutex                          mMutex;
+    QCache< QString, Track >        mCache;
+
+    BatchProcessor::Options         mOptions;
+    ScoringMethod::Optimization     mOptimization;
+
+    QJsonObject importTrack(const QByteArray &body, int &status);
+    QJsonObject deriveTrack(const QJsonObject &request, int &status);
+    QJsonObject scoreTrack(const QJsonObject &request, int &status);
+    QJsonObject optimizeTrack(const QJsonObject &request, int &status);
+
+    bool findTrack(const QJsonObject &request, TrackUtil::DataPoints &data,
+                   QJsonObject &reply, int &status);
+    BatchProcessor::Options options(const QJsonObject &request) const;
+    ScoringMethod *createMethod(const QJsonObject &request, double &windowBottom,
+                                QJsonObject &reply, int &status) const;
+
+    bool isBusy() const;
+
+    static QJsonObject error(const QString &message);
+};
+
+#endif // SCORINGSERVER_H
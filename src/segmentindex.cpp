@@ -0,0 +1,252 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "segmentindex.h"
+
+#include <cmath>
+#include <limits>
+
+#include "common.h"
+
+#define MAX_GRID_SIZE 1024
+
+SegmentIndex::SegmentIndex():
+    mPathStart(0),
+    mBuilt(false),
+    mColumns(0),
+    mRows(0),
+    mCellWidth(0),
+    mCellHeight(0)
+{
+
+}
+
+void SegmentIndex::clear()
+{
+    mPoints.clear();
+    mTimes.clear();
+    mSegments.clear();
+    mCellStart.clear();
+    mCellItems.clear();
+
+    mPathStart = 0;
+    mBuilt = false;
+}
+
+void SegmentIndex::addPoint(
+        double x,
+        double y,
+        double t)
+{
+    mPoints.append(QPointF(x, y));
+    mTimes.append(t);
+
+    // Segment from the previous point in this path
+    if (mPoints.size() - 1 > mPathStart)
+    {
+        mSegments.append(mPoints.size() - 2);
+    }
+
+    mBuilt = false;
+}
+
+void SegmentIndex::endPath()
+{
+    // A path with a single point is indexed as a zero-length segment so
+    // that scatter plots can use the same query
+    if (mPoints.size() - 1 == mPathStart)
+    {
+        mPoints.append(mPoints.last());
+        mTimes.append(mTimes.last());
+        mSegments.append(mPoints.size() - 2);
+    }
+
+    mPathStart = mPoints.size();
+    mBuilt = false;
+}
+
+int SegmentIndex::column(
+        double x) const
+{
+    int i = (int) floor((x - mBounds.left()) / mCellWidth);
+    return qBound(0, i, mColumns - 1);
+}
+
+int SegmentIndex::row(
+        double y) const
+{
+    int i = (int) floor((y - mBounds.top()) / mCellHeight);
+    return qBound(0, i, mRows - 1);
+}
+
+void SegmentIndex::build()
+{
+    mCellStart.clear();
+    mCellItems.clear();
+    mBuilt = true;
+
+    if (mSegments.isEmpty()) return;
+
+    // Find bounds of all points
+    double xMin, xMax, yMin, yMax;
+    for (int i = 0; i < mPoints.size(); ++i)
+    {
+        const QPointF &pt = mPoints[i];
+
+        if (i == 0)
+        {
+            xMin = xMax = pt.x();
+            yMin = yMax = pt.y();
+        }
+        else
+        {
+            if (pt.x() < xMin) xMin = pt.x();
+            if (pt.x() > xMax) xMax = pt.x();
+
+            if (pt.y() < yMin) yMin = pt.y();
+            if (pt.y() > yMax) yMax = pt.y();
+        }
+    }
+
+    mBounds = QRectF(xMin, yMin, xMax - xMin, yMax - yMin);
+
+    // Aim for about one segment per cell
+    int size = (int) ceil(sqrt((double) mSegments.size()));
+    mColumns = mRows = qBound(1, size, MAX_GRID_SIZE);
+
+    mCellWidth = (mBounds.width() > 0) ? mBounds.width() / mColumns : 1;
+    mCellHeight = (mBounds.height() > 0) ? mBounds.height() / mRows : 1;
+
+    // Count segments in each cell
+    mCellStart.fill(0, mColumns * mRows + 1);
+
+    for (int k = 0; k < mSegments.size(); ++k)
+    {
+        const QPointF &p1 = mPoints[mSegments[k]];
+        const QPointF &p2 = mPoints[mSegments[k] + 1];
+
+        const int c1 = column(qMin(p1.x(), p2.x())), c2 = column(qMax(p1.x(), p2.x()));
+        const int r1 = row(qMin(p1.y(), p2.y())), r2 = row(qMax(p1.y(), p2.y()));
+
+        for (int r = r1; r <= r2; ++r)
+        {
+            for (int c = c1; c <= c2; ++c)
+            {
+                ++mCellStart[r * mColumns + c + 1];
+            }
+        }
+    }
+
+    for (int i = 0; i < mColumns * mRows; ++i)
+    {
+        mCellStart[i + 1] += mCellStart[i];
+    }
+
+    // Fill cells
+    QVector< int > next = mCellStart;
+    mCellItems.resize(mCellStart.last());
+
+    for (int k = 0; k < mSegments.size(); ++k)
+    {
+        const QPointF &p1 = mPoints[mSegments[k]];
+        const QPointF &p2 = mPoints[mSegments[k] + 1];
+
+        const int c1 = column(qMin(p1.x(), p2.x())), c2 = column(qMax(p1.x(), p2.x()));
+        const int r1 = row(qMin(p1.y(), p2.y())), r2 = row(qMax(p1.y(), p2.y()));
+
+        for (int r = r1; r <= r2; ++r)
+        {
+            for (int c = c1; c <= c2; ++c)
+            {
+                mCellItems[next[r * mColumns + c]++] = k;
+            }
+        }
+    }
+}
+
+bool SegmentIndex::findNearest(
+        const QTransform &transform,
+        const QPointF &pos,
+        double maxDist,
+        double &t,
+        double &dist) const
+{
+    if (!mBuilt || mCellItems.isEmpty()) return false;
+
+    bool invertible;
+    QTransform inverse = transform.inverted(&invertible);
+    if (!invertible) return false;
+
+    // Search window in data coordinates
+    QRectF window = inverse.mapRect(QRectF(pos.x() - maxDist, pos.y() - maxDist,
+                                           2 * maxDist, 2 * maxDist));
+
+    if (!window.intersects(mBounds.adjusted(-mCellWidth, -mCellHeight,
+                                            mCellWidth, mCellHeight)))
+    {
+        return false;
+    }
+
+    const int c1 = column(window.left()), c2 = column(window.right());
+    const int r1 = row(window.top()), r2 = row(window.bottom());
+
+    double resultDistance = std::numeric_limits<double>::max();
+    int resultSegment = -1;
+    double resultMu = 0;
+
+    for (int r = r1; r <= r2; ++r)
+    {
+        for (int c = c1; c <= c2; ++c)
+        {
+            const int cell = r * mColumns + c;
+            for (int j = mCellStart[cell]; j < mCellStart[cell + 1]; ++j)
+            {
+                const int k = mCellItems[j];
+                const int i = mSegments[k];
+
+                QPointF pt1 = transform.map(mPoints[i]);
+                QPointF pt2 = transform.map(mPoints[i + 1]);
+
+                double mu;
+                double distSqr = distSqrToLine(pt1, pt2, pos, mu);
+
+                if (distSqr < resultDistance)
+                {
+                    resultDistance = distSqr;
+                    resultSegment = k;
+                    resultMu = mu;
+                }
+            }
+        }
+    }
+
+    if (resultSegment < 0) return false;
+
+    dist = sqrt(resultDistance);
+    if (dist >= maxDist) return false;
+
+    const int i = mSegments[resultSegment];
+    t = mTimes[i] + resultMu * (mTimes[i + 1] - mTimes[i]);
+
+    return true;
+}
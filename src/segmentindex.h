@@ -0,0 +1,72 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef SEGMENTINDEX_H
+#define SEGMENTINDEX_H
+
+#include <QPointF>
+#include <QRectF>
+#include <QTransform>
+#include <QVector>
+
+/* Uniform grid over the segments of one or more polylines, used to find the
+ * segment nearest the mouse without scanning the whole track. Points are
+ * given in data coordinates; queries take the data-to-screen transform so
+ * the index stays valid while the view is panned or zoomed. */
+class SegmentIndex
+{
+public:
+    SegmentIndex();
+
+    void clear();
+    void addPoint(double x, double y, double t);
+    void endPath();
+
+    bool isEmpty() const { return mPoints.isEmpty(); }
+    bool isBuilt() const { return mBuilt; }
+
+    void build();
+
+    bool findNearest(const QTransform &transform, const QPointF &pos,
+                     double maxDist, double &t, double &dist) const;
+
+private:
+    QVector< QPointF > mPoints;
+    QVector< double >  mTimes;
+    QVector< int >     mSegments;   // index of first point of each segment
+
+    int                mPathStart;
+    bool               mBuilt;
+
+    QRectF             mBounds;
+    int                mColumns, mRows;
+    double             mCellWidth, mCellHeight;
+
+    QVector< int >     mCellStart;
+    QVector< int >     mCellItems;
+
+    int column(double x) const;
+    int row(double y) const;
+};
+
+#endif // SEGMENTINDEX_H
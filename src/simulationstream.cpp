@@ -0,0 +1,126 @@
+#include "simulationstream.h"
+
+#include <string.h>
+
+#include "audiosimulation.h"
+
+SimulationStream::SimulationStream(
+        AudioSimulation *simulation,
+        const QAudioFormat &format,
+        QObject *parent):
+    QIODevice(parent),
+    mSimulation(simulation),
+    mFormat(format),
+    mPosition(0),
+    mStep(((qint64) AUDIO_SAMPLE_RATE << 16) / format.sampleRate()),
+    mChunkIndex(-1)
+{
+
+}
+
+QAudioFormat SimulationStream::sourceFormat()
+{
+    QAudioFormat format;
+
+    format.setSampleRate(AUDIO_SAMPLE_RATE);
+    format.setChannelCount(1);
+    format.setSampleSize(8);
+    format.setCodec("audio/pcm");
+    format.setSampleType(QAudioFormat::UnSignedInt);
+
+    return format;
+}
+
+qint64 SimulationStream::bytesAvailable() const
+{
+    const qint64 frames = ((mSimulation->sampleCount() << 16) - mPosition) / mStep;
+    return qMax((qint64) 0, frames) * mFormat.bytesPerFrame() + QIODevice::bytesAvailable();
+}
+
+void SimulationStream::setPosition(
+        qint64 ms)
+{
+    mPosition = AudioSimulation::msecToSample(ms) << 16;
+}
+
+int SimulationStream::sample(
+        qint64 index)
+{
+    const int chunkSize = AudioSimulation::chunkSize();
+    const int chunkIndex = index / chunkSize;
+
+    if (chunkIndex != mChunkIndex)
+    {
+        mChunk = mSimulation->chunk(chunkIndex);
+        mChunkIndex = chunkIndex;
+    }
+
+    const int offset = index % chunkSize;
+    if (offset >= mChunk.size()) return 128;
+
+    return (unsigned char) mChunk[offset];
+}
+
+qint64 SimulationStream::readData(
+        char *data,
+        qint64 maxSize)
+{
+    const qint64 end = mSimulation->sampleCount() << 16;
+
+    const int channels = mFormat.channelCount();
+    const int bytesPerSample = mFormat.sampleSize() / 8;
+    const int bytesPerFrame = mFormat.bytesPerFrame();
+
+    qint64 size = 0;
+
+    while (size + bytesPerFrame <= maxSize && mPosition < end)
+    {
+        // Interpolate between neighbouring source samples
+        const qint64 index = mPosition >> 16;
+        const int frac = mPosition & 0xffff;
+
+        const int s1 = sample(index);
+        const int s2 = (frac == 0) ? s1 : sample(index + 1);
+        const int value = (s1 << 8) + (((s2 - s1) * frac) >> 8) - 32768;
+
+        for (int c = 0; c < channels; ++c)
+        {
+            char *out = data + size + c * bytesPerSample;
+
+            if (mFormat.sampleType() == QAudioFormat::Float)
+            {
+                const float f = value / 32768.0f;
+                memcpy(out, &f, sizeof(f));
+            }
+            else if (bytesPerSample == 1)
+            {
+                const int v = value >> 8;
+                *out = (mFormat.sampleType() == QAudioFormat::UnSignedInt) ? v + 128 : v;
+            }
+            else
+            {
+                // Widen to the output sample size in native byte order
+                const qint32 v = (mFormat.sampleType() == QAudioFormat::UnSignedInt) ?
+                            value + 32768 : value;
+                const qint64 wide = (qint64) v << (8 * bytesPerSample - 16);
+                memcpy(out, ((const char *) &wide) + ((Q_BYTE_ORDER == Q_BIG_ENDIAN) ? 8 - bytesPerSample : 0),
+                       bytesPerSample);
+            }
+        }
+
+        size += bytesPerFrame;
+        mPosition += mStep;
+    }
+
+    return size;
+}
+
+qint64 SimulationStream::writeData(
+        const char *data,
+        qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+
+    return -1;
+}
@@ -0,0 +1,45 @@
+#ifndef SIMULATIONSTREAM_H
+#define SIMULATIONSTREAM_H
+
+#include <QAudioFormat>
+#include <QByteArray>
+#include <QIODevice>
+
+class AudioSimulation;
+
+/* Sequential device feeding simulated audio to QAudioOutput. Samples are
+ * taken from the simulation's chunk cache, so only what is heard gets
+ * rendered, and converted to the output format with linear interpolation
+ * if the device doesn't take 8-bit audio at the simulated rate. */
+class SimulationStream : public QIODevice
+{
+    Q_OBJECT
+public:
+    SimulationStream(AudioSimulation *simulation, const QAudioFormat &format,
+                     QObject *parent = 0);
+
+    static QAudioFormat sourceFormat();
+
+    bool isSequential() const { return true; }
+    qint64 bytesAvailable() const;
+
+    void setPosition(qint64 ms);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize);
+    qint64 writeData(const char *data, qint64 maxSize);
+
+private:
+    AudioSimulation *mSimulation;
+    QAudioFormat     mFormat;
+
+    qint64           mPosition;     // Source position (samples << 16)
+    qint64           mStep;         // Source samples per frame (<< 16)
+
+    int              mChunkIndex;
+    QByteArray       mChunk;
+
+    int sample(qint64 index);
+};
+
+#endif // SIMULATIONSTREAM_H
@@ -1,18 +1,21 @@
 #include "simulationview.h"
 #include "ui_simulationview.h"
 
+#include <QAudioDeviceInfo>
+#include <QAudioOutput>
+#include <QDateTime>
 #include <QFile>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QSettings>
 #include <QTextStream>
+#include <QThread>
 
-#include <VLCQtCore/Common.h>
-#include <VLCQtCore/Instance.h>
-#include <VLCQtCore/Media.h>
-#include <VLCQtCore/MediaPlayer.h>
-
+#include "audiopool.h"
+#include "audiorenderer.h"
+#include "audiosimulation.h"
 #include "mainwindow.h"
+#include "simulationstream.h"
 
 #define POSITION_DIV 10
 
@@ -20,8 +23,14 @@ SimulationView::SimulationView(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::SimulationView),
     mMainWindow(0),
-    mMedia(0),
-    mBusy(false)
+    mSimulation(0),
+    mStream(0),
+    mOutput(0),
+    mStartPosition(0),
+    mPosition(0),
+    mBusy(false),
+    mRenderThread(0),
+    mRenderer(0)
 {
     ui->setupUi(this);
 
@@ -63,13 +72,6 @@ SimulationView::SimulationView(QWidget *parent) :
     ui->scrubDial->setPageStep(300);
     connect(ui->scrubDial, SIGNAL(valueChanged(int)), this, SLOT(setScrubPosition(int)));
 
-    mInstance = new VlcInstance(VlcCommon::args(), this);
-    mPlayer = new VlcMediaPlayer(mInstance);
-
-    connect(mPlayer, SIGNAL(stateChanged()), this, SLOT(stateChanged()));
-    connect(mPlayer, SIGNAL(timeChanged(int)), this, SLOT(timeChanged(int)));
-    connect(mPlayer, SIGNAL(lengthChanged(int)), this, SLOT(lengthChanged(int)));
-
     mAudioFile = new QTemporaryFile(QDir::temp().absoluteFilePath("FlySightViewer-XXXXXX.wav"));
     mAudioFile->open();
     mAudioFile->close();
@@ -78,9 +80,19 @@ SimulationView::SimulationView(QWidget *parent) :
 
 SimulationView::~SimulationView()
 {
-    delete mPlayer;
-    delete mMedia;
-    delete mInstance;
+    // Stop rendering
+    if (mRenderThread)
+    {
+        mRenderer->cancel();
+        mRenderThread->quit();
+        mRenderThread->wait();
+
+        delete mRenderer;
+        delete mRenderThread;
+    }
+
+    releaseSimulation();
+
     delete mAudioFile;
     delete ui;
 }
@@ -193,10 +205,63 @@ void SimulationView::on_audioCheckBox_stateChanged(int state)
 }
 
 void SimulationView::on_processButton_clicked()
+{
+    // Cancel rendering if it's already running
+    if (mRenderer)
+    {
+        mRenderer->cancel();
+        return;
+    }
+
+    // Return now if there's no data
+    if (mMainWindow->dataSize() == 0) return;
+
+    // Initialize progress bar
+    ui->progressBar->setRange(0, 100);
+    ui->progressBar->setValue(0);
+
+    ui->processButton->setText(tr("Cancel"));
+
+    // Render on a worker thread
+    mRenderThread = new QThread;
+    mRenderer = new AudioRenderer(readConfig(), mMainWindow->data(), mAudioFile->fileName());
+    mRenderer->moveToThread(mRenderThread);
+
+    connect(mRenderThread, SIGNAL(started()), mRenderer, SLOT(process()));
+    connect(mRenderer, SIGNAL(progress(int)), ui->progressBar, SLOT(setValue(int)));
+    connect(mRenderer, SIGNAL(finished(bool)), this, SLOT(renderFinished(bool)));
+
+    mRenderThread->start();
+}
+
+void SimulationView::renderFinished(
+        bool success)
+{
+    // Clean up worker thread
+    mRenderThread->quit();
+    mRenderThread->wait();
+
+    delete mRenderer;
+    delete mRenderThread;
+
+    mRenderer = 0;
+    mRenderThread = 0;
+
+    ui->processButton->setText(tr("Process"));
+
+    if (success)
+    {
+        ui->progressBar->setValue(100);
+    }
+    else
+    {
+        ui->progressBar->setValue(0);
+    }
+}
+
+Config SimulationView::readConfig() const
 {
     Config config;
-    Tone   tone(config);
-    UBX    ubx(config, tone);
 
     // Read root configuration
     QString fileName = ui->rootFileName->text();
@@ -224,123 +289,195 @@ void SimulationView::on_processButton_clicked()
         config.mConfigFolder = QFileInfo(ui->selectedFileName->text()).absolutePath();
     }
 
-    // Return now if there's no data
-    if (mMainWindow->dataSize() == 0) return;
+    // Preload speech prompts
+    config.mAudioPool = AudioPool::load(config.mAudioFolder);
 
-    const DataPoint &dpStart = mMainWindow->dataPoint(0);
-    const DataPoint &dpEnd = mMainWindow->dataPoint(mMainWindow->dataSize() - 1);
-    const qint64 numSamples = dpStart.dateTime.msecsTo(dpEnd.dateTime) * 8000 / 256;
+    return config;
+}
 
-    // Initialize progress bar
-    ui->progressBar->setRange(0, 100);
-    ui->progressBar->setValue(0);
+QString SimulationView::configKey() const
+{
+    QStringList key;
 
-    int iNextSample = 0;
-    DataPoint dpNext = mMainWindow->dataPoint(iNextSample);
-    qint64 msNextSample = dpStart.dateTime.msecsTo(dpNext.dateTime);
-    qint64 msNextTick = 0;
+    // Root configuration
+    QString fileName = ui->rootFileName->text();
+    key << fileName << QFileInfo(fileName).lastModified().toString(Qt::ISODate);
 
-    mAudioFile->open();
-    mAudioFile->resize(0);
+    // Selected configuration
+    if (ui->selectedCheckBox->isChecked())
+    {
+        QString fileName = ui->selectedFileName->text();
+        key << fileName << QFileInfo(fileName).lastModified().toString(Qt::ISODate);
+    }
 
-    const unsigned char header[] =
+    // Audio folder
+    if (ui->audioCheckBox->isChecked())
     {
-        0x52, 0x49, 0x46, 0x46, // ChunkID = "RIFF"
-        0x1C, 0x0B, 0x00, 0x00, // ChunkSize
-        0x57, 0x41, 0x56, 0x45, // Format = "WAVE"
-        0x66, 0x6D, 0x74, 0x20, // Subchunk1ID = "fmt "
-        0x10, 0x00, 0x00, 0x00, // Subchunk1Size
-        0x01, 0x00,             // AudioFormat
-        0x01, 0x00,             // NumChannels
-        0x12, 0x7A, 0x00, 0x00, // SampleRate = 31250
-        0x12, 0x7A, 0x00, 0x00, // ByteRate = 31250
-        0x01, 0x00,             // BlockAlign
-        0x08, 0x00,             // BitsPerSample
-        0x64, 0x61, 0x74, 0x61  // Subchunk2ID = "data"
-    };
-
-    mAudioFile->write((const char *) header, 40);
-
-    uint32_t numSamples32 = (uint32_t) numSamples;
-    mAudioFile->write((char *) &numSamples32, 4);
-
-    for (qint64 s = 0; s < numSamples; ++s)
+        key << ui->audioFolderName->text();
+    }
+
+    return key.join("|");
+}
+
+bool SimulationView::isCurrent() const
+{
+    return mSimulation
+            && mSimulationKey == configKey()
+            && mSimulation->data().isSharedWith(mMainWindow->data());
+}
+
+bool SimulationView::prepareSimulation()
+{
+    // Return now if there's no data
+    if (mMainWindow->dataSize() == 0) return false;
+
+    // Keep the rendered audio if nothing has changed
+    if (isCurrent()) return true;
+
+    releaseSimulation();
+
+    const Config config = readConfig();
+
+    mSimulation = new AudioSimulation(config, mMainWindow->data());
+    mSimulationKey = configKey();
+
+    // Report memory used by speech prompts
+    const AudioPool *pool = config.mAudioPool.data();
+    QString summary = tr("%1 prompts, %2 kB, loaded in %3 ms")
+            .arg(pool->count())
+            .arg((pool->size() + 1023) / 1024)
+            .arg(pool->loadTime());
+
+    if (!pool->errors().isEmpty())
     {
-        qint64 ms = s * 256 / 8000;
+        summary += QString("\n") + pool->errors().join("\n");
+    }
 
-        uint8_t sample = tone.sample();
-        mAudioFile->write((char *) &sample, 1);
+    ui->audioFolderName->setToolTip(summary);
 
-        if (ms >= msNextSample)
-        {
-            ubx.receiveMessage(dpNext);
+    // Use the simulated format if the device supports it
+    QAudioDeviceInfo device = QAudioDeviceInfo::defaultOutputDevice();
+    QAudioFormat format = SimulationStream::sourceFormat();
 
-            dpNext = mMainWindow->dataPoint(++iNextSample);
-            msNextSample = dpStart.dateTime.msecsTo(dpNext.dateTime);
-        }
+    if (!device.isFormatSupported(format))
+    {
+        format = device.nearestFormat(format);
+    }
+
+    mStream = new SimulationStream(mSimulation, format, this);
+    mStream->open(QIODevice::ReadOnly);
 
-        if (ms >= msNextTick)
-        {
-            tone.update();
+    mOutput = new QAudioOutput(device, format, this);
+    mOutput->setNotifyInterval(50);
 
-            ubx.task();
-            tone.task();
+    connect(mOutput, SIGNAL(stateChanged(QAudio::State)),
+            this, SLOT(stateChanged(QAudio::State)));
+    connect(mOutput, SIGNAL(notify()), this, SLOT(notify()));
 
-            ++msNextTick;
-        }
+    return true;
+}
 
-        // Update progress bar
-        ui->progressBar->setValue(static_cast<int>(100 * (s + 1) / numSamples));
+void SimulationView::releaseSimulation()
+{
+    if (mOutput)
+    {
+        mOutput->stop();
     }
 
-    mAudioFile->close();
+    delete mOutput;
+    delete mStream;
+    delete mSimulation;
+
+    mOutput = 0;
+    mStream = 0;
+    mSimulation = 0;
 
-    setMedia(mAudioFile->fileName());
+    ui->playButton->setIcon(style()->standardIcon(QStyle::SP_MediaPlay));
 }
 
-void SimulationView::setMedia(const QString &fileName)
+int SimulationView::length() const
 {
-    // Set media
-    delete mMedia;
-    mMedia = new VlcMedia(fileName, true, mInstance);
-    mPlayer->open(mMedia);
-
-    // Update buttons
-    ui->playButton->setEnabled(true);
-    ui->positionSlider->setEnabled(true);
-    ui->scrubDial->setEnabled(true);
+    if (mMainWindow->dataSize() == 0) return 0;
+
+    const DataPoint &dp0 = mMainWindow->data().first();
+    const DataPoint &dp1 = mMainWindow->data().last();
+
+    return dp0.dateTime.msecsTo(dp1.dateTime);
+}
+
+void SimulationView::seek(
+        int position,
+        bool play)
+{
+    position = qBound(0, position, length());
+
+    const bool playing = mOutput && mOutput->state() == QAudio::ActiveState;
+
+    if (mOutput)
+    {
+        mOutput->stop();
+    }
+
+    mStartPosition = position;
+    timeChanged(position);
+
+    // Restart output from the new position
+    if ((play || playing) && prepareSimulation())
+    {
+        mStream->setPosition(position);
+        mOutput->start(mStream);
+    }
 }
 
 void SimulationView::play()
 {
-    switch(mPlayer->state())
+    if (mOutput && mOutput->state() == QAudio::ActiveState)
     {
-    case Vlc::Playing:
-        mPlayer->pause();
-        break;
-    default:
-        mMainWindow->pauseMedia();
-        mPlayer->play();
-        break;
+        mOutput->suspend();
+        return;
+    }
+
+    mMainWindow->pauseMedia();
+
+    if (mOutput && mOutput->state() == QAudio::SuspendedState && isCurrent())
+    {
+        mOutput->resume();
+    }
+    else
+    {
+        seek(mPosition, true);
     }
 }
 
-void SimulationView::stateChanged()
+void SimulationView::stateChanged(
+        QAudio::State state)
 {
-    switch(mPlayer->state())
+    switch(state)
     {
-    case Vlc::Playing:
+    case QAudio::ActiveState:
         ui->playButton->setIcon(style()->standardIcon(QStyle::SP_MediaPause));
         break;
+    case QAudio::IdleState:
+        // Reached the end of the simulation
+        mOutput->stop();
+        // Fall through
     default:
         ui->playButton->setIcon(style()->standardIcon(QStyle::SP_MediaPlay));
         break;
     }
 }
 
+void SimulationView::notify()
+{
+    if (mOutput->state() != QAudio::ActiveState) return;
+
+    timeChanged(mStartPosition + mOutput->processedUSecs() / 1000);
+}
+
 void SimulationView::timeChanged(int position)
 {
     mBusy = true;
+    mPosition = position;
 
     // Update controls
     ui->positionSlider->setValue(position / POSITION_DIV);
@@ -363,18 +500,12 @@ void SimulationView::timeChanged(int position)
     mBusy = false;
 }
 
-void SimulationView::lengthChanged(int duration)
-{
-    ui->positionSlider->setRange(0, duration / POSITION_DIV);
-}
-
 void SimulationView::setPosition(int position)
 {
     if (!mBusy)
     {
-        // Update video position
-        mPlayer->setTime(position * POSITION_DIV);
-        timeChanged(position * POSITION_DIV);
+        // Update playback position
+        seek(position * POSITION_DIV, false);
     }
 }
 
@@ -382,23 +513,38 @@ void SimulationView::setScrubPosition(int position)
 {
     if (!mBusy)
     {
-        int oldPosition = mPlayer->time();
+        int oldPosition = mPosition;
         int newPosition = oldPosition - oldPosition % 1000 + position;
 
         while (newPosition <= oldPosition - 500) newPosition += 1000;
         while (newPosition >  oldPosition + 500) newPosition -= 1000;
 
-        // Update video position
-        mPlayer->setTime(newPosition);
-        timeChanged(newPosition);
+        // Update playback position
+        seek(newPosition, false);
     }
 }
 
 void SimulationView::updateView()
 {
-    if (mMainWindow->dataSize() == 0) return;
+    const bool enabled = mMainWindow->dataSize() > 0;
+
+    // Update controls
+    ui->playButton->setEnabled(enabled);
+    ui->positionSlider->setEnabled(enabled);
+    ui->scrubDial->setEnabled(enabled);
+
+    if (!enabled)
+    {
+        releaseSimulation();
+        return;
+    }
+
     if (mBusy) return;
 
+    mBusy = true;
+    ui->positionSlider->setRange(0, length() / POSITION_DIV);
+    mBusy = false;
+
     // Get media cursor
     const DataPoint &dp = mMainWindow->interpolateDataT(mMainWindow->mediaCursor());
     const DataPoint &dp0 = mMainWindow->data()[0];
@@ -406,16 +552,21 @@ void SimulationView::updateView()
     // Get playback position
     int position = (dp.t - dp0.t) * 1000;
 
-    // If playback position is within video bounds
-    if (0 <= position && position <= mPlayer->length())
+    // Ignore cursor updates we made ourselves
+    if (qAbs(position - mPosition) <= 1) return;
+
+    // If playback position is within simulation bounds
+    if (0 <= position && position <= length())
     {
-        // Update video position
-        mPlayer->setTime(position);
-        timeChanged(position);
+        // Update playback position
+        seek(position, false);
     }
 }
 
 void SimulationView::pauseMedia()
 {
-    mPlayer->pause();
+    if (mOutput && mOutput->state() == QAudio::ActiveState)
+    {
+        mOutput->suspend();
+    }
 }
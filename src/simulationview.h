@@ -1,6 +1,7 @@
 #ifndef SIMULATIONVIEW_H
 #define SIMULATIONVIEW_H
 
+#include <QAudio>
 #include <QTemporaryFile>
 #include <QWidget>
 
@@ -12,11 +13,13 @@ namespace Ui {
 class SimulationView;
 }
 
+class AudioRenderer;
+class AudioSimulation;
 class DataPoint;
 class MainWindow;
-class VlcInstance;
-class VlcMedia;
-class VlcMediaPlayer;
+class QAudioOutput;
+class QThread;
+class SimulationStream;
 
 class SimulationView : public QWidget
 {
@@ -38,15 +41,29 @@ private:
     Ui::SimulationView *ui;
     MainWindow         *mMainWindow;
 
-    VlcInstance        *mInstance;
-    VlcMedia           *mMedia;
-    VlcMediaPlayer     *mPlayer;
+    AudioSimulation    *mSimulation;
+    QString             mSimulationKey;
+    SimulationStream   *mStream;
+    QAudioOutput       *mOutput;
+    qint64              mStartPosition;
+    int                 mPosition;
 
     bool               mBusy;
 
     QTemporaryFile     *mAudioFile;
 
-    void setMedia(const QString &fileName);
+    QThread            *mRenderThread;
+    AudioRenderer      *mRenderer;
+
+    Config readConfig() const;
+    QString configKey() const;
+
+    bool isCurrent() const;
+    bool prepareSimulation();
+    void releaseSimulation();
+
+    int length() const;
+    void seek(int position, bool play);
 
 public slots:
     void play();
@@ -62,10 +79,11 @@ private slots:
     void on_audioCheckBox_stateChanged(int state);
 
     void on_processButton_clicked();
+    void renderFinished(bool success);
 
-    void stateChanged();
+    void stateChanged(QAudio::State state);
+    void notify();
     void timeChanged(int position);
-    void lengthChanged(int duration);
     void setPosition(int position);
     void setScrubPosition(int position);
 };
@@ -24,6 +24,7 @@
 #include "speedscoring.h"
 
 #include "mainwindow.h"
+#include "trackutil.h"
 
 #define TIME_DELTA 0.005
 
@@ -62,10 +63,18 @@ void SpeedScoring::setValidationWindow(
 double SpeedScoring::score(
         const MainWindow::DataPoints &result)
 {
-    if (mMainWindow->dataSize() == 0) return 0;
-
-    // Get exit
-    DataPoint dpExit = mMainWindow->performanceStart();
+    // Get exit from the main window track, or from the result when headless
+    DataPoint dpExit;
+    if (mMainWindow)
+    {
+        if (mMainWindow->dataSize() == 0) return 0;
+        dpExit = mMainWindow->performanceStart();
+    }
+    else
+    {
+        if (result.isEmpty()) return 0;
+        dpExit = TrackUtil::performanceStart(result);
+    }
 
     DataPoint dpBottom, dpTop;
     if (getWindowBounds(result, dpBottom, dpTop, dpExit))
@@ -176,10 +185,14 @@ bool SpeedScoring::getWindowBounds(
         const DataPoint &dpExit)
 {
     bool found = false;
-    int iStart = result.size() - 1;
     double maxScore = 0;
 
-    for (int iEnd = result.size() - 1; iEnd >= 0; --iEnd)
+    // Windows can't end below the last sample above the bottom
+    const TrackUtil::PhaseIndex *index = phaseIndex(mMainWindow, result);
+    int iStart = index ? TrackUtil::findIndexAboveZ(*index, mWindowBottom)
+                       : result.size() - 1;
+
+    for (int iEnd = iStart; iEnd >= 0; --iEnd)
     {
         // Get end point
         const DataPoint &dpEnd = result[iEnd];
@@ -223,15 +236,22 @@ bool SpeedScoring::getAccuracy(
 {
     bool found = false;
 
-    for (int i = result.size() - 1; i >= 0; --i)
+    // Get validation window
+    const double zBottom = qMax(dpExit.z - mFromExit, mWindowBottom);
+    const double zTop = zBottom + mValidationWindow;
+
+    // Only samples between the first one below the top and the last
+    // one above the bottom can be inside
+    const TrackUtil::PhaseIndex *index = phaseIndex(mMainWindow, result);
+    const int first = index ? TrackUtil::findIndexBelowZ(*index, zTop) : 0;
+    const int last = index ? TrackUtil::findIndexAboveZ(*index, zBottom)
+                           : result.size() - 1;
+
+    for (int i = last; i >= first; --i)
     {
         // Get end point
         const DataPoint &dp = result[i];
 
-        // Get validation window
-        const double zBottom = qMax(dpExit.z - mFromExit, mWindowBottom);
-        const double zTop = zBottom + mValidationWindow;
-
         // Check window conditions
         if (dp.t < 0) break;
         if (dp.z < zBottom) continue;
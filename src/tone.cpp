@@ -1,5 +1,8 @@
 #include "tone.h"
 
+#include <string.h>
+
+#include "audiopool.h"
 #include "config.h"
 
 #define MIN(a,b) (((a) < (b)) ?  (a) : (b))
@@ -72,6 +75,9 @@ Tone::Tone(const Config &config):
     mPhase = 0;
     mSampleCount = 0;
 
+    mWavPos = 0;
+    mWavSamples = 0;
+
     mSampleActive = false;
 }
 
@@ -184,8 +190,9 @@ void Tone::readFile(uint16_t size)
     uint16_t i;
     uint8_t  val;
 
-    size = MIN(size, mWavSamples);
-    br = mFile.read((char *) &mBuffer[mWrite % TONE_BUFFER_LEN], size);
+    br = MIN(size, mWavSamples);
+    memcpy(&mBuffer[mWrite % TONE_BUFFER_LEN], mWav.constData() + mWavPos, br);
+    mWavPos += br;
     mWavSamples -= br;
 
     for (i = 0; i < br; ++i)
@@ -270,7 +277,7 @@ void Tone::stop()
         case TONE_MODE_BEEP:
             break;
         case TONE_MODE_WAV:
-            mFile.close();
+            mWav.clear();
             break;
         }
 
@@ -327,14 +334,16 @@ void Tone::play(QString filename)
     {
         stop();
 
-        mFile.setFileName(mConfig.mAudioFolder + QString("/") + filename);
-
-        if (mFile.open(QIODevice::ReadOnly))
+        // Prompts are preloaded with the configuration
+        if (mConfig.mAudioPool)
         {
-            mFile.seek(40);
-            mFile.read((char *) &mWavSamples, sizeof(mWavSamples));
+            mWav = mConfig.mAudioPool->samples(filename);
+        }
 
-            mFile.seek(44);
+        if (!mWav.isEmpty())
+        {
+            mWavSamples = mWav.size();
+            mWavPos = 0;
 
             start(TONE_MODE_WAV);
         }
@@ -372,3 +381,39 @@ void Tone::release(void)
 {
     mHold = 0;
 }
+
+void Tone::copyState(const Tone &other)
+{
+    // Copy everything except the configuration reference
+    mRead = other.mRead;
+    mWrite = other.mWrite;
+
+    mStep = other.mStep;
+    mChirp = other.mChirp;
+    mLen = other.mLen;
+
+    mState = other.mState;
+    mMode = other.mMode;
+
+    mNextIndex = other.mNextIndex;
+    mNextChirp = other.mNextChirp;
+    mRate = other.mRate;
+
+    mFlags = other.mFlags;
+    mHold = other.mHold;
+
+    mWav = other.mWav;
+    mWavPos = other.mWavPos;
+    mWavSamples = other.mWavSamples;
+
+    mToneTimer = other.mToneTimer;
+    mPhase = other.mPhase;
+    mSampleCount = other.mSampleCount;
+    mSampleBegin = other.mSampleBegin;
+    mSampleEnd = other.mSampleEnd;
+    mSampleStep = other.mSampleStep;
+
+    memcpy(mBuffer, other.mBuffer, sizeof(mBuffer));
+
+    mSampleActive = other.mSampleActive;
+}
@@ -1,7 +1,8 @@
 #ifndef TONE_H
 #define TONE_H
 
-#include <QFile>
+#include <QByteArray>
+#include <QString>
 
 #include <stdint.h>
 
@@ -44,6 +45,11 @@ public:
     void hold();
     void release();
 
+    void copyState(const Tone &other);
+
+    uint16_t rate() const { return mRate; }
+    uint16_t pitch() const { return mNextIndex; }
+
 private:
     const Config &mConfig;
 
@@ -57,7 +63,8 @@ private:
     uint8_t  mState;
     uint8_t  mMode;
 
-    QFile    mFile;
+    QByteArray mWav;
+    int      mWavPos;
 
     uint16_t mNextIndex;
     uint32_t mNextChirp;
@@ -0,0 +1,525 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "trackarchive.h"
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QIODevice>
+#include <QSaveFile>
+
+#include <limits>
+#include <math.h>
+#include <string.h>
+
+using namespace TrackUtil;
+
+#define ARCHIVE_MAGIC   "FSTA"
+#define ARCHIVE_VERSION 1
+#define FLAG_COMPRESSED 0x01
+
+#define HEADER_SIZE     16      // Magic, version, flags, columns, rows, blocks
+#define INDEX_SIZE      32      // Start, end, rows, size, offset
+#define BLOCK_ROWS      256     // About a minute at 5 Hz
+#define MAX_DECIMALS    9       // Finest fixed-point scale tried
+#define RAW_DOUBLE      0xFF    // Column stored as raw IEEE doubles
+
+// Archived columns
+typedef enum {
+    Time = 0,
+    Lat,
+    Lon,
+    HMSL,
+    VelN,
+    VelE,
+    VelD,
+    HAcc,
+    VAcc,
+    SAcc,
+    NumSV,
+    ColumnCount
+} Column;
+
+// Decimal places FlySight writes for each column
+static const int defaultDecimals[ColumnCount] = {
+    0,      // ms
+    7,      // deg * 1e-7
+    7,      // deg * 1e-7
+    3,      // mm
+    2,      // cm/s
+    2,      // cm/s
+    2,      // cm/s
+    3,      // mm
+    3,      // mm
+    2,      // cm/s
+    0
+};
+
+typedef struct {
+    qint64  startMs;
+    qint64  endMs;
+    quint32 rows;
+    quint32 size;
+    quint64 offset;
+} BlockInfo;
+
+static double columnValue(
+        const DataPoint &dp,
+        int column)
+{
+    switch (column)
+    {
+    case Time:  return dp.dateTime.toMSecsSinceEpoch();
+    case Lat:   return dp.lat;
+    case Lon:   return dp.lon;
+    case HMSL:  return dp.hMSL;
+    case VelN:  return dp.velN;
+    case VelE:  return dp.velE;
+    case VelD:  return dp.velD;
+    case HAcc:  return dp.hAcc;
+    case VAcc:  return dp.vAcc;
+    case SAcc:  return dp.sAcc;
+    default:    return dp.numSV;
+    }
+}
+
+static void setColumnValue(
+        DataPoint &dp,
+        int column,
+        double value)
+{
+    switch (column)
+    {
+    case Time:  dp.dateTime = QDateTime::fromMSecsSinceEpoch((qint64) value, Qt::UTC); break;
+    case Lat:   dp.lat = value; break;
+    case Lon:   dp.lon = value; break;
+    case HMSL:  dp.hMSL = value; break;
+    case VelN:  dp.velN = value; break;
+    case VelE:  dp.velE = value; break;
+    case VelD:  dp.velD = value; break;
+    case HAcc:  dp.hAcc = value; break;
+    case VAcc:  dp.vAcc = value; break;
+    case SAcc:  dp.sAcc = value; break;
+    default:    dp.numSV = (int) value; break;
+    }
+}
+
+static quint64 toBits(
+        double value)
+{
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double fromBits(
+        quint64 bits)
+{
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void writeVarint(
+        QByteArray &out,
+        quint64 value)
+{
+    while (value >= 0x80)
+    {
+        out.append((char) ((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append((char) value);
+}
+
+static bool readVarint(
+        const QByteArray &in,
+        int &pos,
+        quint64 &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (pos >= in.size()) return false;
+
+        const quint8 byte = (quint8) in[pos++];
+        value |= (quint64) (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+
+    return false;
+}
+
+static quint64 zigZag(
+        qint64 value)
+{
+    return ((quint64) value << 1) ^ (quint64) (value >> 63);
+}
+
+static qint64 unZigZag(
+        quint64 value)
+{
+    return (qint64) (value >> 1) ^ -(qint64) (value & 1);
+}
+
+// Finest scale needed to represent a column exactly, or RAW_DOUBLE
+static int findDecimals(
+        const DataPoints &data,
+        int start,
+        int end,
+        int column)
+{
+    for (int decimals = defaultDecimals[column]; decimals <= MAX_DECIMALS; ++decimals)
+    {
+        const double scale = pow(10., decimals);
+
+        int i;
+        for (i = start; i < end; ++i)
+        {
+            const double value = columnValue(data[i], column);
+            const double scaled = value * scale;
+
+            if (!(fabs(scaled) < 9e15)) break;
+            if (qRound64(scaled) / scale != value) break;
+        }
+
+        if (i == end) return decimals;
+    }
+
+    return RAW_DOUBLE;
+}
+
+static QByteArray encodeBlock(
+        const DataPoints &data,
+        int start,
+        int end)
+{
+    QByteArray out;
+
+    for (int column = 0; column < ColumnCount; ++column)
+    {
+        const int decimals = findDecimals(data, start, end, column);
+        out.append((char) decimals);
+
+        if (decimals == RAW_DOUBLE)
+        {
+            quint64 prev = 0;
+            for (int i = start; i < end; ++i)
+            {
+                const quint64 bits = toBits(columnValue(data[i], column));
+                writeVarint(out, bits ^ prev);
+                prev = bits;
+            }
+        }
+        else
+        {
+            const double scale = pow(10., decimals);
+
+            qint64 prev = 0;
+            for (int i = start; i < end; ++i)
+            {
+                const qint64 value = qRound64(columnValue(data[i], column) * scale);
+                writeVarint(out, zigZag(value - prev));
+                prev = value;
+            }
+        }
+    }
+
+    return out;
+}
+
+static bool decodeBlock(
+        const QByteArray &in,
+        DataPoint *points,
+        int rows)
+{
+    int pos = 0;
+
+    for (int column = 0; column < ColumnCount; ++column)
+    {
+        if (pos >= in.size()) return false;
+        const int decimals = (quint8) in[pos++];
+
+        if (decimals == RAW_DOUBLE)
+        {
+            quint64 prev = 0;
+            for (int i = 0; i < rows; ++i)
+            {
+                quint64 delta;
+                if (!readVarint(in, pos, delta)) return false;
+
+                prev ^= delta;
+                setColumnValue(points[i], column, fromBits(prev));
+            }
+        }
+        else if (decimals <= MAX_DECIMALS)
+        {
+            const double scale = pow(10., decimals);
+
+            qint64 prev = 0;
+            for (int i = 0; i < rows; ++i)
+            {
+                quint64 delta;
+                if (!readVarint(in, pos, delta)) return false;
+
+                prev += unZigZag(delta);
+                setColumnValue(points[i], column, prev / scale);
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < rows; ++i)
+    {
+        points[i].hasGeodetic = true;
+    }
+
+    return true;
+}
+
+static bool readIndex(
+        QIODevice *device,
+        quint8 &flags,
+        QVector< BlockInfo > &index)
+{
+    QDataStream in(device);
+
+    char magic[4];
+    if (in.readRawData(magic, 4) != 4 || memcmp(magic, ARCHIVE_MAGIC, 4)) return false;
+
+    quint8 version;
+    quint16 columns;
+    quint32 rows, blocks;
+    in >> version >> flags >> columns >> rows >> blocks;
+
+    if (in.status() != QDataStream::Ok) return false;
+    if (version != ARCHIVE_VERSION || columns != ColumnCount) return false;
+
+    index.resize(blocks);
+    for (quint32 i = 0; i < blocks; ++i)
+    {
+        BlockInfo &info = index[i];
+        in >> info.startMs >> info.endMs >> info.rows >> info.size >> info.offset;
+    }
+
+    return in.status() == QDataStream::Ok;
+}
+
+bool TrackArchive::isArchive(
+        QIODevice *device)
+{
+    return device->peek(4) == ARCHIVE_MAGIC;
+}
+
+bool TrackArchive::write(
+        QIODevice *device,
+        const DataPoints &data,
+        bool compress)
+{
+    QVector< QByteArray > blocks;
+    QVector< BlockInfo > index;
+
+    // Encode blocks first so the index can be written ahead of them
+    quint64 offset = HEADER_SIZE;
+    for (int start = 0; start < data.size(); start += BLOCK_ROWS)
+    {
+        offset += INDEX_SIZE;
+    }
+
+    for (int start = 0; start < data.size(); start += BLOCK_ROWS)
+    {
+        const int end = qMin(start + BLOCK_ROWS, data.size());
+
+        QByteArray block = encodeBlock(data, start, end);
+        if (compress) block = qCompress(block);
+
+        BlockInfo info;
+        info.startMs = info.endMs = data[start].dateTime.toMSecsSinceEpoch();
+        for (int i = start + 1; i < end; ++i)
+        {
+            const qint64 ms = data[i].dateTime.toMSecsSinceEpoch();
+            info.startMs = qMin(info.startMs, ms);
+            info.endMs = qMax(info.endMs, ms);
+        }
+        info.rows = end - start;
+        info.size = block.size();
+        info.offset = offset;
+
+        offset += block.size();
+
+        blocks.append(block);
+        index.append(info);
+    }
+
+    QByteArray header;
+    QDataStream out(&header, QIODevice::WriteOnly);
+
+    out.writeRawData(ARCHIVE_MAGIC, 4);
+    out << (quint8) ARCHIVE_VERSION
+        << (quint8) (compress ? FLAG_COMPRESSED : 0)
+        << (quint16) ColumnCount
+        << (quint32) data.size()
+        << (quint32) blocks.size();
+
+    foreach (const BlockInfo &info, index)
+    {
+        out << info.startMs << info.endMs << info.rows << info.size << info.offset;
+    }
+
+    if (device->write(header) != header.size()) return false;
+
+    foreach (const QByteArray &block, blocks)
+    {
+        if (device->write(block) != block.size()) return false;
+    }
+
+    return true;
+}
+
+bool TrackArchive::read(
+        QIODevice *device,
+        DataPoints &data)
+{
+    return read(device, data, std::numeric_limits< qint64 >::min(),
+                std::numeric_limits< qint64 >::max());
+}
+
+bool TrackArchive::read(
+        QIODevice *device,
+        DataPoints &data,
+        qint64 startMs,
+        qint64 endMs)
+{
+    data.clear();
+
+    const qint64 base = device->pos();
+
+    quint8 flags;
+    QVector< BlockInfo > index;
+    if (!readIndex(device, flags, index)) return false;
+
+    // Only blocks overlapping the requested range
+    int rows = 0;
+    foreach (const BlockInfo &info, index)
+    {
+        if (info.endMs >= startMs && info.startMs <= endMs) rows += info.rows;
+    }
+
+    data.resize(rows);
+
+    int row = 0;
+    foreach (const BlockInfo &info, index)
+    {
+        if (info.endMs < startMs || info.startMs > endMs) continue;
+
+        if (!device->seek(base + info.offset))
+        {
+            data.clear();
+            return false;
+        }
+
+        QByteArray block = device->read(info.size);
+        if (flags & FLAG_COMPRESSED) block = qUncompress(block);
+
+        if (!decodeBlock(block, data.data() + row, info.rows))
+        {
+            data.clear();
+            return false;
+        }
+
+        row += info.rows;
+    }
+
+    return true;
+}
+
+bool TrackArchive::isEqual(
+        const DataPoints &data1,
+        const DataPoints &data2)
+{
+    if (data1.size() != data2.size()) return false;
+
+    for (int i = 0; i < data1.size(); ++i)
+    {
+        for (int column = 0; column < ColumnCount; ++column)
+        {
+            if (toBits(columnValue(data1[i], column))
+                    != toBits(columnValue(data2[i], column)))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+QString TrackArchive::archivePath(
+        const QString &databasePath,
+        const QString &trackName)
+{
+    return QDir(databasePath).filePath(QString("FlySight/Tracks/%1.fsa").arg(trackName));
+}
+
+QString TrackArchive::csvPath(
+        const QString &databasePath,
+        const QString &trackName)
+{
+    return QDir(databasePath).filePath(QString("FlySight/Tracks/%1.csv").arg(trackName));
+}
+
+QString TrackArchive::trackPath(
+        const QString &databasePath,
+        const QString &trackName)
+{
+    // Tracks imported before archiving was added are kept as CSV
+    const QString fileName = archivePath(databasePath, trackName);
+    if (QFile::exists(fileName)) return fileName;
+    else                         return csvPath(databasePath, trackName);
+}
+
+bool TrackArchive::save(
+        const QString &fileName,
+        const DataPoints &data)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+
+    if (!write(&buffer, data)) return false;
+
+    // Check the round trip before keeping the archive
+    DataPoints check;
+    buffer.seek(0);
+    if (!read(&buffer, check) || !isEqual(data, check)) return false;
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    file.write(buffer.data());
+    return file.commit();
+}
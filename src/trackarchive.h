@@ -0,0 +1,56 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef TRACKARCHIVE_H
+#define TRACKARCHIVE_H
+
+#include <QString>
+
+#include "trackutil.h"
+
+class QIODevice;
+
+/* Compact storage for imported tracks. Each GNSS column is scaled to fixed
+ * point at the precision FlySight writes it (the UBX units), delta encoded
+ * and written as zig-zag varints. Rows are grouped into blocks of about a
+ * minute, optionally compressed, with an index of block times at the start
+ * of the file so a time range can be read without decoding the rest.
+ * Values that don't fit the fixed-point scale are stored as raw doubles, so
+ * reading an archive gives back exactly the values read from the CSV. */
+namespace TrackArchive
+{
+    // Encoding
+    bool isArchive(QIODevice *device);
+    bool write(QIODevice *device, const TrackUtil::DataPoints &data, bool compress = true);
+    bool read(QIODevice *device, TrackUtil::DataPoints &data);
+    bool read(QIODevice *device, TrackUtil::DataPoints &data, qint64 startMs, qint64 endMs);
+    bool isEqual(const TrackUtil::DataPoints &data1, const TrackUtil::DataPoints &data2);
+
+    // Logbook storage in FlySight/Tracks
+    QString archivePath(const QString &databasePath, const QString &trackName);
+    QString csvPath(const QString &databasePath, const QString &trackName);
+    QString trackPath(const QString &databasePath, const QString &trackName);
+    bool save(const QString &fileName, const TrackUtil::DataPoints &data);
+}
+
+#endif // TRACKARCHIVE_H
@@ -0,0 +1,393 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "trackdatabase.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+#include <QVariant>
+
+#define FLUSH_MSEC          500     // Delay before queued values are written
+#define MAX_BACKOFF_MSEC    60000   // Longest delay after failed writes
+#define REPORT_FAILURES     5       // Failed writes in a row before reporting
+#define CLOSE_TIMEOUT_MSEC  10000   // Time allowed to write values on close
+#define CONNECTION_NAME     "flysight-writer"
+
+TrackWriter::TrackWriter():
+    mTimer(0),
+    mFailures(0)
+{
+
+}
+
+void TrackWriter::setValue(
+        const QString &trackName,
+        const QString &column,
+        const QString &value)
+{
+    QMutexLocker locker(&mMutex);
+    mPending[trackName][column] = value;
+}
+
+bool TrackWriter::pendingValue(
+        const QString &trackName,
+        const QString &column,
+        QString &value)
+{
+    QMutexLocker locker(&mMutex);
+
+    Values::const_iterator p = mPending.constFind(trackName);
+    if (p == mPending.constEnd() || !p->contains(column)) return false;
+
+    value = p->value(column);
+    return true;
+}
+
+void TrackWriter::open(
+        const QString &databasePath)
+{
+    close();
+
+    // Values kept from another database can't be written to this one
+    if (mDatabasePath != databasePath)
+    {
+        QMutexLocker locker(&mMutex);
+        if (!mDatabasePath.isEmpty()) mPending.clear();
+    }
+
+    mDatabasePath = databasePath;
+    mFailures = 0;
+
+    if (!mTimer)
+    {
+        mTimer = new QTimer(this);
+        mTimer->setSingleShot(true);
+        mTimer->setInterval(FLUSH_MSEC);
+
+        connect(mTimer, SIGNAL(timeout()), this, SLOT(flush()));
+    }
+
+    // Separate connection for this thread
+    mDatabase = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    mDatabase.setDatabaseName(QDir(databasePath).filePath("FlySight/FlySight.db"));
+    mDatabase.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+
+    if (!mDatabase.open()) return;
+
+    QSqlQuery query(mDatabase);
+    query.exec("pragma synchronous=normal");
+
+    // Write anything queued before the database was opened
+    schedule();
+}
+
+void TrackWriter::close()
+{
+    if (mTimer) mTimer->stop();
+
+    if (mDatabase.isValid())
+    {
+        // Finish writing to this database, giving another connection
+        // holding the lock time to finish
+        QElapsedTimer timer;
+        timer.start();
+
+        while (mDatabase.isOpen() && !flush()
+               && timer.elapsed() < CLOSE_TIMEOUT_MSEC)
+        {
+            QThread::msleep(FLUSH_MSEC);
+        }
+
+        if (mTimer) mTimer->stop();
+
+        // Keep anything left in case this database is opened again
+        QMutexLocker locker(&mMutex);
+        const int count = mPending.size();
+        locker.unlock();
+
+        if (count > 0)
+        {
+            emit failed(tr("Couldn't save changes to %1 tracks").arg(count));
+        }
+
+        mUpdates.clear();
+
+        mDatabase.close();
+        mDatabase = QSqlDatabase();
+        QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    }
+}
+
+void TrackWriter::schedule()
+{
+    if (mTimer && !mTimer->isActive())
+    {
+        mTimer->start();
+    }
+}
+
+QSqlQuery &TrackWriter::updateQuery(
+        const QString &column)
+{
+    QHash< QString, QSqlQuery >::iterator p = mUpdates.find(column);
+    if (p == mUpdates.end())
+    {
+        p = mUpdates.insert(column, QSqlQuery(mDatabase));
+        p->prepare(QString("update files set %1 = ? where file_name = ?").arg(column));
+    }
+
+    return *p;
+}
+
+bool TrackWriter::flush()
+{
+    if (!mDatabase.isOpen()) return false;
+
+    Values values;
+    {
+        QMutexLocker locker(&mMutex);
+        values = mPending;
+    }
+
+    if (values.isEmpty()) return true;
+
+    // Write everything in one transaction, taking the lock up front so
+    // the transaction sees rows committed while it was waiting
+    QSqlQuery transaction(mDatabase);
+    bool success = transaction.exec("begin immediate");
+
+    QSqlError error = transaction.lastError();
+
+    Values::const_iterator p;
+    for (p = values.constBegin(); success && p != values.constEnd(); ++p)
+    {
+        QMap< QString, QString >::const_iterator q;
+        for (q = p->constBegin(); success && q != p->constEnd(); ++q)
+        {
+            QSqlQuery &query = updateQuery(q.key());
+            query.addBindValue(q.value());
+            query.addBindValue(p.key());
+            success = query.exec();
+
+            if (!success) error = query.lastError();
+        }
+    }
+
+    if (success && !transaction.exec("commit"))
+    {
+        error = transaction.lastError();
+        success = false;
+    }
+
+    if (!success)
+    {
+        transaction.exec("rollback");
+
+        // Report once the failure persists, e.g. beyond an import
+        // holding the lock
+        if (++mFailures == REPORT_FAILURES)
+        {
+            emit failed(error.text());
+        }
+
+        // Try again later, backing off while it keeps failing
+        mTimer->start(qMin(FLUSH_MSEC << qMin(mFailures, 7), MAX_BACKOFF_MSEC));
+        return false;
+    }
+
+    mFailures = 0;
+    mTimer->setInterval(FLUSH_MSEC);
+
+    // Keep values that changed while we were writing
+    {
+        QMutexLocker locker(&mMutex);
+
+        for (p = values.constBegin(); p != values.constEnd(); ++p)
+        {
+            Values::iterator r = mPending.find(p.key());
+
+            QMap< QString, QString >::const_iterator q;
+            for (q = p->constBegin(); q != p->constEnd(); ++q)
+            {
+                if (r->value(q.key()) == q.value())
+                {
+                    r->remove(q.key());
+                }
+            }
+
+            if (r->isEmpty()) mPending.erase(r);
+        }
+
+        if (!mPending.isEmpty()) mTimer->start();
+    }
+
+    for (p = values.constBegin(); p != values.constEnd(); ++p)
+    {
+        emit written(p.key(), p->keys());
+    }
+
+    return true;
+}
+
+TrackDatabase::TrackDatabase(
+        QObject *parent):
+    QObject(parent),
+    mThread(new QThread),
+    mWriter(new TrackWriter)
+{
+    mWriter->moveToThread(mThread);
+
+    connect(mWriter, SIGNAL(written(QString,QStringList)),
+            this, SIGNAL(written(QString,QStringList)));
+    connect(mWriter, SIGNAL(failed(QString)),
+            this, SIGNAL(failed(QString)));
+
+    mThread->start();
+}
+
+TrackDatabase::~TrackDatabase()
+{
+    // Write queued values and close the connection on its thread
+    QMetaObject::invokeMethod(mWriter, "close", Qt::BlockingQueuedConnection);
+
+    mThread->quit();
+    mThread->wait();
+
+    delete mWriter;
+    delete mThread;
+}
+
+void TrackDatabase::open(
+        const QString &databasePath)
+{
+    QMetaObject::invokeMethod(mWriter, "open", Qt::QueuedConnection,
+                              Q_ARG(QString, databasePath));
+}
+
+void TrackDatabase::close()
+{
+    // Release statements before the GUI connection is replaced
+    mSelects.clear();
+    mMatches.clear();
+
+    QMetaObject::invokeMethod(mWriter, "close", Qt::BlockingQueuedConnection);
+}
+
+bool TrackDatabase::flush()
+{
+    bool success = false;
+    QMetaObject::invokeMethod(mWriter, "flush", Qt::BlockingQueuedConnection,
+                              Q_RETURN_ARG(bool, success));
+    return success;
+}
+
+QSqlQuery &TrackDatabase::cachedQuery(
+        QHash< QString, QSqlQuery > &cache,
+        const QString &column,
+        const QString &statement)
+{
+    QHash< QString, QSqlQuery >::iterator p = cache.find(column);
+    if (p == cache.end())
+    {
+        p = cache.insert(column, QSqlQuery(QSqlDatabase::database("flysight")));
+        p->prepare(statement.arg(column));
+    }
+
+    return *p;
+}
+
+bool TrackDatabase::value(
+        const QString &trackName,
+        const QString &column,
+        QString &value)
+{
+    mLastError = QSqlError();
+
+    // Values waiting to be written take precedence
+    QString result;
+    if (!mWriter->pendingValue(trackName, column, result))
+    {
+        QSqlQuery &query = cachedQuery(mSelects, column,
+                                       "select %1 from files where file_name = ?");
+        query.addBindValue(trackName);
+
+        if (!query.exec())
+        {
+            mLastError = query.lastError();
+            return false;
+        }
+
+        if (query.next()) result = query.value(0).toString();
+
+        // Don't hold the read transaction open
+        query.finish();
+    }
+
+    if (result.isEmpty()) return false;
+
+    value = result;
+    return true;
+}
+
+bool TrackDatabase::hasValue(
+        const QString &trackName,
+        const QString &column,
+        const QString &value)
+{
+    mLastError = QSqlError();
+
+    QString result;
+    if (mWriter->pendingValue(trackName, column, result))
+    {
+        return result == value;
+    }
+
+    // Compare in SQL so that e.g. 12.000 matches a stored 12.0
+    QSqlQuery &query = cachedQuery(mMatches, column,
+                                   "select 1 from files where file_name = ? and %1 = ?");
+    query.addBindValue(trackName);
+    query.addBindValue(value);
+
+    if (!query.exec())
+    {
+        mLastError = query.lastError();
+        return false;
+    }
+
+    const bool found = query.next();
+    query.finish();
+
+    return found;
+}
+
+void TrackDatabase::setValue(
+        const QString &trackName,
+        const QString &column,
+        const QString &value)
+{
+    mWriter->setValue(trackName, column, value);
+    QMetaObject::invokeMethod(mWriter, "schedule", Qt::QueuedConnection);
+}
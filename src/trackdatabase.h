@@ -0,0 +1,116 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef TRACKDATABASE_H
+#define TRACKDATABASE_H
+
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+
+class QThread;
+class QTimer;
+
+/* Writes per-track values to the files table on its own thread and
+ * connection. Values are queued and flushed together in one transaction,
+ * so a burst of changes to the same track reaches the disk once. Queued
+ * values stay visible to readers until they have been committed. Failed
+ * writes are retried with a growing delay and reported once they persist;
+ * values that still can't be written when the database is closed are kept
+ * in case the same database is opened again. */
+class TrackWriter : public QObject
+{
+    Q_OBJECT
+public:
+    TrackWriter();
+
+    void setValue(const QString &trackName, const QString &column, const QString &value);
+    bool pendingValue(const QString &trackName, const QString &column, QString &value);
+
+private:
+    typedef QMap< QString, QMap< QString, QString > > Values;
+
+    QString                     mDatabasePath;
+    QSqlDatabase                mDatabase;
+    QTimer                     *mTimer;
+    QHash< QString, QSqlQuery > mUpdates;
+    int                         mFailures;
+
+    QMutex                      mMutex;
+    Values                      mPending;
+
+    QSqlQuery &updateQuery(const QString &column);
+
+signals:
+    void written(const QString &trackName, const QStringList &columns);
+    void failed(const QString &error);
+
+public slots:
+    void open(const QString &databasePath);
+    void close();
+    void schedule();
+    bool flush();
+};
+
+/* Reads and writes per-track values in the files table. Reads run on the
+ * GUI connection with prepared statements cached per column; writes are
+ * handed to a TrackWriter. */
+class TrackDatabase : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TrackDatabase(QObject *parent = 0);
+    ~TrackDatabase();
+
+    void open(const QString &databasePath);
+    void close();
+    bool flush();
+
+    bool value(const QString &trackName, const QString &column, QString &value);
+    bool hasValue(const QString &trackName, const QString &column, const QString &value);
+    void setValue(const QString &trackName, const QString &column, const QString &value);
+
+    QSqlError lastError() const { return mLastError; }
+
+signals:
+    void written(const QString &trackName, const QStringList &columns);
+    void failed(const QString &error);
+
+private:
+    QThread                    *mThread;
+    TrackWriter                *mWriter;
+
+    QHash< QString, QSqlQuery > mSelects;
+    QHash< QString, QSqlQuery > mMatches;
+    QSqlError                   mLastError;
+
+    QSqlQuery &cachedQuery(QHash< QString, QSqlQuery > &cache, const QString &column,
+                           const QString &statement);
+};
+
+#endif // TRACKDATABASE_H
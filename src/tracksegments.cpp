@@ -0,0 +1,369 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "tracksegments.h"
+
+#include <QFile>
+#include <QSqlQuery>
+#include <QVariant>
+
+#include <limits>
+#include <math.h>
+
+#include "common.h"
+#include "trackarchive.h"
+
+#define CLIMB_VERTICAL_SPEED    2       // Climb rate in an aircraft (m/s)
+#define CLIMB_HORIZONTAL_SPEED  20      // Aircraft ground speed (m/s)
+#define CLIMB_HOLD_MSEC         10000
+#define EXIT_HOLD_MSEC          2000
+#define DEPLOY_SPEED            20      // Total speed under canopy (m/s)
+#define DEPLOY_HOLD_MSEC        3000
+#define LANDED_SPEED            2       // Total speed after landing (m/s)
+#define LANDED_HOLD_MSEC        10000
+
+#define PRE_EXIT_MSEC           120000  // Climb kept before each exit
+#define POST_LANDING_MSEC       30000   // Ground kept after each landing
+
+// Phase a sample suggests, and how long it must persist to be accepted
+static TrackSegments::Phase proposePhase(
+        TrackSegments::Phase phase,
+        const DataPoint &dp,
+        qint64 &hold)
+{
+    using namespace TrackSegments;
+
+    const double hSpeed = sqrt(dp.velN * dp.velN + dp.velE * dp.velE);
+    const double speed = sqrt(hSpeed * hSpeed + dp.velD * dp.velD);
+
+    switch (phase)
+    {
+    case Ground:
+    case Landed:
+        if (dp.velD > A_GRAVITY)
+        {
+            hold = EXIT_HOLD_MSEC;
+            return Freefall;
+        }
+        if (-dp.velD > CLIMB_VERTICAL_SPEED || hSpeed > CLIMB_HORIZONTAL_SPEED)
+        {
+            hold = CLIMB_HOLD_MSEC;
+            return Climb;
+        }
+        break;
+    case Climb:
+        if (dp.velD > A_GRAVITY)
+        {
+            hold = EXIT_HOLD_MSEC;
+            return Freefall;
+        }
+        if (speed < LANDED_SPEED)
+        {
+            // Rode the aircraft down
+            hold = LANDED_HOLD_MSEC;
+            return Ground;
+        }
+        break;
+    case Freefall:
+        if (speed < DEPLOY_SPEED)
+        {
+            hold = DEPLOY_HOLD_MSEC;
+            return Canopy;
+        }
+        break;
+    case Canopy:
+        if (speed < LANDED_SPEED)
+        {
+            hold = LANDED_HOLD_MSEC;
+            return Landed;
+        }
+        break;
+    }
+
+    return phase;
+}
+
+TrackSegments::Phases TrackSegments::classify(
+        const TrackUtil::DataPoints &data)
+{
+    Phases phases(data.size(), Ground);
+
+    Phase phase = Ground;
+    Phase pending = Ground;
+    int candidate = -1;
+    qint64 candidateTime = 0;
+
+    for (int i = 0; i < data.size(); ++i)
+    {
+        const DataPoint &dp = data[i];
+        const qint64 time = dp.dateTime.toMSecsSinceEpoch();
+
+        qint64 hold = 0;
+        const Phase proposed = proposePhase(phase, dp, hold);
+
+        // Track how long the same change has been suggested
+        if (proposed == phase)
+        {
+            candidate = -1;
+        }
+        else if (candidate < 0 || proposed != pending)
+        {
+            candidate = i;
+            candidateTime = time;
+            pending = proposed;
+        }
+
+        if (candidate >= 0 && time - candidateTime >= hold)
+        {
+            // The change started with the first sample that suggested it
+            for (int j = candidate; j < i; ++j)
+            {
+                phases[j] = pending;
+            }
+
+            phase = pending;
+            candidate = -1;
+        }
+
+        phases[i] = phase;
+    }
+
+    return phases;
+}
+
+TrackSegments::Jumps TrackSegments::findJumps(
+        const TrackUtil::DataPoints &data,
+        const Phases &phases)
+{
+    Jumps jumps;
+
+    // Exits and landings from phase changes
+    for (int i = 0; i < phases.size(); ++i)
+    {
+        if (phases[i] != Freefall) continue;
+        if (i > 0 && phases[i - 1] == Freefall) continue;
+
+        Jump jump;
+        jump.exit = i;
+        jump.landing = data.size() - 1;
+
+        for (int j = i + 1; j < phases.size(); ++j)
+        {
+            if (phases[j] != Freefall && phases[j] != Canopy)
+            {
+                jump.landing = j;
+                break;
+            }
+        }
+
+        jumps.append(jump);
+        i = jump.landing;
+    }
+
+    // Slices around each jump, without overlapping the next
+    for (int k = 0; k < jumps.size(); ++k)
+    {
+        Jump &jump = jumps[k];
+
+        const int first = (k > 0) ? jumps[k - 1].end : 0;
+        const int last = (k + 1 < jumps.size()) ? jumps[k + 1].exit : data.size();
+
+        const qint64 startTime = data[jump.exit].dateTime.toMSecsSinceEpoch() - PRE_EXIT_MSEC;
+        const qint64 endTime = data[jump.landing].dateTime.toMSecsSinceEpoch() + POST_LANDING_MSEC;
+
+        jump.start = jump.exit;
+        while (jump.start > first
+               && data[jump.start - 1].dateTime.toMSecsSinceEpoch() >= startTime)
+        {
+            --jump.start;
+        }
+
+        jump.end = jump.landing + 1;
+        while (jump.end < last
+               && data[jump.end].dateTime.toMSecsSinceEpoch() <= endTime)
+        {
+            ++jump.end;
+        }
+    }
+
+    return jumps;
+}
+
+bool TrackSegments::shouldSplit(
+        const TrackUtil::DataPoints &data,
+        const Jumps &jumps)
+{
+    // Several jumps, or one jump in a log that is mostly something else
+    if (jumps.size() > 1) return true;
+    if (jumps.size() == 1) return 2 * (jumps[0].end - jumps[0].start) < data.size();
+    return false;
+}
+
+QString TrackSegments::jumpName(
+        const QString &trackName,
+        int number)
+{
+    return QString("%1-%2").arg(trackName).arg(number);
+}
+
+QString TrackSegments::parentName(
+        const QString &trackName)
+{
+    return trackName.section('-', 0, 0);
+}
+
+bool TrackSegments::createTable(
+        QSqlDatabase &db)
+{
+    QSqlQuery query(db);
+    if (!query.exec("create table if not exists jumps ("
+                    "file_name text primary key, "
+                    "parent text, "
+                    "number integer, "
+                    "start_ms integer, "
+                    "end_ms integer, "
+                    "exit_ms integer, "
+                    "landing_ms integer)"))
+    {
+        return false;
+    }
+
+    return query.exec("create index if not exists jumps_parent on jumps (parent)");
+}
+
+bool TrackSegments::write(
+        QSqlDatabase &db,
+        const QString &trackName,
+        const QString &parentName,
+        int number,
+        const TrackUtil::DataPoints &data,
+        const Jump &jump)
+{
+    QSqlQuery query(db);
+    query.prepare("insert or replace into jumps "
+                  "(file_name, parent, number, start_ms, end_ms, exit_ms, landing_ms) "
+                  "values (?, ?, ?, ?, ?, ?, ?)");
+    query.addBindValue(trackName);
+    query.addBindValue(parentName);
+    query.addBindValue(number);
+    query.addBindValue(data[jump.start].dateTime.toMSecsSinceEpoch());
+    query.addBindValue(data[jump.end - 1].dateTime.toMSecsSinceEpoch());
+    query.addBindValue(data[jump.exit].dateTime.toMSecsSinceEpoch());
+    query.addBindValue(data[jump.landing].dateTime.toMSecsSinceEpoch());
+
+    return query.exec();
+}
+
+bool TrackSegments::remove(
+        QSqlDatabase &db,
+        const QString &parentName)
+{
+    QSqlQuery query(db);
+
+    query.prepare("delete from files where file_name in "
+                  "(select file_name from jumps where parent = ?)");
+    query.addBindValue(parentName);
+    if (!query.exec()) return false;
+
+    query.prepare("delete from jumps where parent = ?");
+    query.addBindValue(parentName);
+    return query.exec();
+}
+
+bool TrackSegments::removeJump(
+        QSqlDatabase &db,
+        const QString &trackName)
+{
+    QSqlQuery query(db);
+    query.prepare("delete from jumps where file_name = ?");
+    query.addBindValue(trackName);
+    return query.exec();
+}
+
+int TrackSegments::count(
+        QSqlDatabase &db,
+        const QString &parentName)
+{
+    QSqlQuery query(db);
+    query.prepare("select count(*) from jumps where parent = ?");
+    query.addBindValue(parentName);
+
+    if (!query.exec() || !query.next()) return 0;
+    return query.value(0).toInt();
+}
+
+int TrackSegments::load(
+        QSqlDatabase &db,
+        const QString &databasePath,
+        const QString &trackName,
+        TrackUtil::DataPoints &data)
+{
+    data.clear();
+
+    QString fileName = trackName;
+    qint64 startTime = std::numeric_limits< qint64 >::min();
+    qint64 endTime = std::numeric_limits< qint64 >::max();
+
+    // Jumps are read from their parent log
+    QSqlQuery query(db);
+    query.prepare("select parent, start_ms, end_ms from jumps where file_name = ?");
+    query.addBindValue(trackName);
+
+    const bool isJump = query.exec() && query.next();
+    if (isJump)
+    {
+        fileName = query.value(0).toString();
+        startTime = query.value(1).toLongLong();
+        endTime = query.value(2).toLongLong();
+    }
+    query.finish();
+
+    QFile file(TrackArchive::trackPath(databasePath, fileName));
+    if (!file.open(QIODevice::ReadOnly)) return 0;
+
+    // Archives only decode the blocks covering the slice
+    if (TrackArchive::isArchive(&file))
+    {
+        if (!TrackArchive::read(&file, data, startTime, endTime)) data.clear();
+    }
+    else
+    {
+        TrackUtil::import(&file, data);
+    }
+
+    if (isJump)
+    {
+        TrackUtil::DataPoints slice;
+        slice.reserve(data.size());
+
+        foreach (const DataPoint &dp, data)
+        {
+            const qint64 time = dp.dateTime.toMSecsSinceEpoch();
+            if (startTime <= time && time <= endTime) slice.append(dp);
+        }
+
+        data = slice;
+    }
+
+    return data.size();
+}
@@ -0,0 +1,78 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef TRACKSEGMENTS_H
+#define TRACKSEGMENTS_H
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QVector>
+
+#include "trackutil.h"
+
+/* Splits long logs into jumps. One pass over the raw GNSS samples
+ * classifies each into a flight phase, and every exit and landing is
+ * found from the phase changes. Each jump of a split log is stored in
+ * the jumps table and listed in the logbook as its own track, named after
+ * the log with a "-n" suffix; loading it reads only its time slice. */
+namespace TrackSegments
+{
+    typedef enum {
+        Ground = 0,
+        Climb,
+        Freefall,
+        Canopy,
+        Landed
+    } Phase;
+
+    typedef QVector< Phase > Phases;
+
+    typedef struct {
+        int start;      // First sample of the slice
+        int end;        // One past the last sample of the slice
+        int exit;       // First freefall sample
+        int landing;    // First landed sample, or the last sample
+    } Jump;
+
+    typedef QVector< Jump > Jumps;
+
+    Phases classify(const TrackUtil::DataPoints &data);
+    Jumps findJumps(const TrackUtil::DataPoints &data, const Phases &phases);
+    bool shouldSplit(const TrackUtil::DataPoints &data, const Jumps &jumps);
+
+    // Names
+    QString jumpName(const QString &trackName, int number);
+    QString parentName(const QString &trackName);
+
+    // Storage
+    bool createTable(QSqlDatabase &db);
+    bool write(QSqlDatabase &db, const QString &trackName, const QString &parentName,
+               int number, const TrackUtil::DataPoints &data, const Jump &jump);
+    bool remove(QSqlDatabase &db, const QString &parentName);
+    bool removeJump(QSqlDatabase &db, const QString &trackName);
+    int count(QSqlDatabase &db, const QString &parentName);
+    int load(QSqlDatabase &db, const QString &databasePath, const QString &trackName,
+             TrackUtil::DataPoints &data);
+}
+
+#endif // TRACKSEGMENTS_H
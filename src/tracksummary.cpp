@@ -0,0 +1,218 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "tracksummary.h"
+
+#include <QObject>
+#include <QSqlQuery>
+#include <QVariant>
+
+#define MIN_VERTICAL_SPEED  1       // Lower bound for glide ratio (m/s)
+
+TrackSummary::Summary TrackSummary::compute(
+        const TrackUtil::DataPoints &data)
+{
+    Summary summary;
+
+    const DataPoint &dpFirst = data.first();
+    const DataPoint dpExit = TrackUtil::interpolateDataT(data, 0);
+
+    const int landing = TrackUtil::findIndexForLanding(data);
+    const int iLanding = qBound(0, landing, data.size() - 1);
+    const int iDeploy = qBound(0, TrackUtil::findIndexForDeployment(data, landing), data.size() - 1);
+
+    const DataPoint &dpLanding = data[iLanding];
+    const DataPoint &dpDeploy = data[iDeploy];
+
+    double maxAltitude = dpFirst.z;
+    double maxHorizontalSpeed = 0, maxVerticalSpeed = 0, maxTotalSpeed = 0;
+    double sumHorizontalSpeed = 0, sumVerticalSpeed = 0;
+    int count = 0;
+
+    QVector< double > glideRatios;
+
+    for (int i = 0; i < data.size(); ++i)
+    {
+        const DataPoint &dp = data[i];
+
+        maxAltitude = qMax(maxAltitude, dp.z);
+
+        if (dp.t < 0 || dp.t > dpLanding.t) continue;
+
+        maxHorizontalSpeed = qMax(maxHorizontalSpeed, DataPoint::horizontalSpeed(dp));
+        maxVerticalSpeed = qMax(maxVerticalSpeed, DataPoint::verticalSpeed(dp));
+        maxTotalSpeed = qMax(maxTotalSpeed, DataPoint::totalSpeed(dp));
+
+        if (dp.t > dpDeploy.t) continue;
+
+        // Averages and glide over freefall only
+        sumHorizontalSpeed += DataPoint::horizontalSpeed(dp);
+        sumVerticalSpeed += DataPoint::verticalSpeed(dp);
+        ++count;
+
+        if (DataPoint::verticalSpeed(dp) > MIN_VERTICAL_SPEED)
+        {
+            glideRatios.append(DataPoint::glideRatio(dp));
+        }
+    }
+
+    qSort(glideRatios);
+
+    summary.exitAltitude = dpExit.z;
+    summary.maxAltitude = maxAltitude;
+    summary.deploymentAltitude = dpDeploy.z;
+    summary.freefallTime = dpDeploy.t;
+    summary.landingTime = dpLanding.t;
+    summary.distance2D = dpLanding.dist2D;
+    summary.distance3D = dpLanding.dist3D;
+    summary.maxHorizontalSpeed = maxHorizontalSpeed;
+    summary.maxVerticalSpeed = maxVerticalSpeed;
+    summary.maxTotalSpeed = maxTotalSpeed;
+    summary.meanHorizontalSpeed = (count > 0) ? sumHorizontalSpeed / count : 0;
+    summary.meanVerticalSpeed = (count > 0) ? sumVerticalSpeed / count : 0;
+    summary.glideRatio10 = glideRatios.isEmpty() ? 0 : glideRatios[glideRatios.size() / 10];
+    summary.glideRatio50 = glideRatios.isEmpty() ? 0 : glideRatios[glideRatios.size() / 2];
+    summary.glideRatio90 = glideRatios.isEmpty() ? 0 : glideRatios[glideRatios.size() * 9 / 10];
+
+    return summary;
+}
+
+QStringList TrackSummary::columns()
+{
+    // Same order as the values in write()
+    return QStringList()
+            << "exit_altitude"
+            << "max_altitude"
+            << "deployment_altitude"
+            << "freefall_time"
+            << "landing_time"
+            << "distance_2d"
+            << "distance_3d"
+            << "max_horizontal_speed"
+            << "max_vertical_speed"
+            << "max_total_speed"
+            << "mean_horizontal_speed"
+            << "mean_vertical_speed"
+            << "glide_ratio_p10"
+            << "glide_ratio_p50"
+            << "glide_ratio_p90";
+}
+
+QString TrackSummary::label(
+        const QString &column)
+{
+    if (column == "exit_altitude")          return QObject::tr("Exit Altitude (m)");
+    if (column == "max_altitude")           return QObject::tr("Maximum Altitude (m)");
+    if (column == "deployment_altitude")    return QObject::tr("Deployment Altitude (m)");
+    if (column == "freefall_time")          return QObject::tr("Freefall Time (s)");
+    if (column == "landing_time")           return QObject::tr("Landing Time (s)");
+    if (column == "distance_2d")            return QObject::tr("Horizontal Distance (m)");
+    if (column == "distance_3d")            return QObject::tr("Total Distance (m)");
+    if (column == "max_horizontal_speed")   return QObject::tr("Maximum Horizontal Speed (m/s)");
+    if (column == "max_vertical_speed")     return QObject::tr("Maximum Vertical Speed (m/s)");
+    if (column == "max_total_speed")        return QObject::tr("Maximum Total Speed (m/s)");
+    if (column == "mean_horizontal_speed")  return QObject::tr("Mean Horizontal Speed (m/s)");
+    if (column == "mean_vertical_speed")    return QObject::tr("Mean Vertical Speed (m/s)");
+    if (column == "glide_ratio_p10")        return QObject::tr("Glide Ratio, 10th Percentile");
+    if (column == "glide_ratio_p50")        return QObject::tr("Glide Ratio, Median");
+    if (column == "glide_ratio_p90")        return QObject::tr("Glide Ratio, 90th Percentile");
+
+    return column;
+}
+
+bool TrackSummary::createTable(
+        QSqlDatabase &db)
+{
+    QSqlQuery query(db);
+    if (!query.exec("create table if not exists track_state ("
+                    "file_name text primary key, "
+                    "signature text, "
+                    "processed_time text)"))
+    {
+        return false;
+    }
+
+    // Add summary columns, indexed for logbook queries
+    foreach (const QString &column, columns())
+    {
+        query.exec(QString("alter table track_state add column %1 real").arg(column));
+        query.exec(QString("create index if not exists track_state_%1 on track_state (%1)").arg(column));
+    }
+
+    return true;
+}
+
+bool TrackSummary::write(
+        QSqlDatabase &db,
+        const QString &trackName,
+        const QString &signature,
+        const Summary *summary,
+        QSqlError *error)
+{
+    const QStringList names = columns();
+
+    QVector< double > values;
+    if (summary)
+    {
+        values << summary->exitAltitude
+               << summary->maxAltitude
+               << summary->deploymentAltitude
+               << summary->freefallTime
+               << summary->landingTime
+               << summary->distance2D
+               << summary->distance3D
+               << summary->maxHorizontalSpeed
+               << summary->maxVerticalSpeed
+               << summary->maxTotalSpeed
+               << summary->meanHorizontalSpeed
+               << summary->meanVerticalSpeed
+               << summary->glideRatio10
+               << summary->glideRatio50
+               << summary->glideRatio90;
+    }
+
+    QSqlQuery query(db);
+    query.prepare(QString("insert or replace into track_state "
+                          "(file_name, signature, processed_time, %1) "
+                          "values (?, ?, ?%2)")
+                  .arg(names.join(", "))
+                  .arg(QString(", ?").repeated(names.size())));
+
+    query.addBindValue(trackName);
+    query.addBindValue(signature);
+    query.addBindValue(TrackUtil::dateTimeToUTC(QDateTime::currentDateTimeUtc()));
+
+    // Leave columns null if the track couldn't be summarized
+    for (int i = 0; i < names.size(); ++i)
+    {
+        query.addBindValue(summary ? QVariant(values[i]) : QVariant(QVariant::Double));
+    }
+
+    if (!query.exec())
+    {
+        if (error) *error = query.lastError();
+        return false;
+    }
+
+    return true;
+}
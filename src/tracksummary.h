@@ -0,0 +1,68 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef TRACKSUMMARY_H
+#define TRACKSUMMARY_H
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QString>
+#include <QStringList>
+
+#include "trackutil.h"
+
+/* Summary statistics for a derived track, kept in indexed columns of the
+ * track_state table so the logbook can filter tracks without reading
+ * them. Values are in SI units, with times relative to exit. */
+namespace TrackSummary
+{
+    typedef struct {
+        double exitAltitude;
+        double maxAltitude;
+        double deploymentAltitude;
+        double freefallTime;
+        double landingTime;
+        double distance2D;
+        double distance3D;
+        double maxHorizontalSpeed;
+        double maxVerticalSpeed;
+        double maxTotalSpeed;
+        double meanHorizontalSpeed;
+        double meanVerticalSpeed;
+        double glideRatio10;
+        double glideRatio50;
+        double glideRatio90;
+    } Summary;
+
+    Summary compute(const TrackUtil::DataPoints &data);
+
+    // Storage
+    QStringList columns();
+    QString label(const QString &column);
+    bool createTable(QSqlDatabase &db);
+    bool write(QSqlDatabase &db, const QString &trackName,
+               const QString &signature, const Summary *summary,
+               QSqlError *error = 0);
+}
+
+#endif // TRACKSUMMARY_H
@@ -0,0 +1,871 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "trackutil.h"
+
+#include <QIODevice>
+#include <QMap>
+#include <QStringList>
+#include <QTextStream>
+
+#include "GeographicLib/Geodesic.hpp"
+
+#include "exportwriter.h"
+#include "trackarchive.h"
+
+#define DEPLOY_MIN_SPEED    30      // Freefall speed before deployment (m/s)
+#define DEPLOY_SPEED        20      // Total speed under canopy (m/s)
+
+using namespace GeographicLib;
+using namespace TrackUtil;
+
+static void importSingleRow(
+        QString line,
+        DataPoints &data)
+{
+    QStringList cols = line.split(",");
+
+    // Skip truncated rows
+    if (cols[0] == "$GNSS" && cols.size() >= 12)
+    {
+        DataPoint pt;
+
+        pt.dateTime = QDateTime::fromString(cols[1], Qt::ISODate);
+
+        pt.hasGeodetic = true;
+
+        pt.lat   = cols[2].toDouble();
+        pt.lon   = cols[3].toDouble();
+        pt.hMSL  = cols[4].toDouble();
+
+        pt.velN  = cols[5].toDouble();
+        pt.velE  = cols[6].toDouble();
+        pt.velD  = cols[7].toDouble();
+
+        pt.hAcc  = cols[8].toDouble();
+        pt.vAcc  = cols[9].toDouble();
+        pt.sAcc  = cols[10].toDouble();
+
+        pt.numSV = cols[11].toInt();
+
+        data.append(pt);
+    }
+}
+
+static void importNew(
+        QTextStream &in,
+        DataPoints &data,
+        QString firstLine)
+{
+    data.clear();
+
+    importSingleRow(firstLine, data);
+
+    while (!in.atEnd())
+    {
+        importSingleRow(in.readLine(), data);
+    }
+}
+
+static void importOld(
+        QTextStream &in,
+        DataPoints &data,
+        QString firstLine)
+{
+    // Column enumeration
+    typedef enum {
+        Time = 0,
+        Lat,
+        Lon,
+        HMSL,
+        VelN,
+        VelE,
+        VelD,
+        HAcc,
+        VAcc,
+        SAcc,
+        Heading,
+        CAcc,
+        NumSV
+    } Columns;
+
+    // Read column labels
+    QMap< int, int > colMap;
+
+    QStringList cols = firstLine.split(",");
+
+    for (int i = 0; i < cols.size(); ++i)
+    {
+        const QString &s = cols[i];
+
+        if (s == "time")    colMap[Time]    = i;
+        if (s == "lat")     colMap[Lat]     = i;
+        if (s == "lon")     colMap[Lon]     = i;
+        if (s == "hMSL")    colMap[HMSL]    = i;
+        if (s == "velN")    colMap[VelN]    = i;
+        if (s == "velE")    colMap[VelE]    = i;
+        if (s == "velD")    colMap[VelD]    = i;
+        if (s == "hAcc")    colMap[HAcc]    = i;
+        if (s == "vAcc")    colMap[VAcc]    = i;
+        if (s == "sAcc")    colMap[SAcc]    = i;
+        if (s == "numSV")   colMap[NumSV]   = i;
+    }
+
+    data.clear();
+
+    // Every column read below must be present
+    const QList< int > required = QList< int >()
+            << Time << Lat << Lon << HMSL << VelN << VelE << VelD
+            << HAcc << VAcc << SAcc << NumSV;
+
+    int lastCol = 0;
+    foreach (int col, required)
+    {
+        if (!colMap.contains(col)) return;
+        lastCol = qMax(lastCol, colMap[col]);
+    }
+
+    // Skip next row
+    if (!in.atEnd()) in.readLine();
+
+    while (!in.atEnd())
+    {
+        QString line = in.readLine();
+        QStringList cols = line.split(",");
+
+        // Skip truncated rows
+        if (cols.size() <= lastCol) continue;
+
+        DataPoint pt;
+
+        pt.dateTime = QDateTime::fromString(cols[colMap[Time]], Qt::ISODate);
+
+        pt.hasGeodetic = true;
+
+        pt.lat   = cols[colMap[Lat]].toDouble();
+        pt.lon   = cols[colMap[Lon]].toDouble();
+        pt.hMSL  = cols[colMap[HMSL]].toDouble();
+
+        pt.velN  = cols[colMap[VelN]].toDouble();
+        pt.velE  = cols[colMap[VelE]].toDouble();
+        pt.velD  = cols[colMap[VelD]].toDouble();
+
+        pt.hAcc  = cols[colMap[HAcc]].toDouble();
+        pt.vAcc  = cols[colMap[VAcc]].toDouble();
+        pt.sAcc  = cols[colMap[SAcc]].toDouble();
+
+        pt.numSV = cols[colMap[NumSV]].toInt();
+
+        data.append(pt);
+    }
+}
+
+int TrackUtil::import(
+        QIODevice *device,
+        DataPoints &data)
+{
+    // Tracks stored in the logbook
+    if (TrackArchive::isArchive(device))
+    {
+        if (!TrackArchive::read(device, data)) data.clear();
+        return data.length();
+    }
+
+    QTextStream in(device);
+
+    if (!in.atEnd())
+    {
+        QString firstLine = in.readLine();
+
+        if (firstLine.startsWith('$'))
+        {
+            // Import from new format
+            importNew(in, data, firstLine);
+        }
+        else
+        {
+            // Import from old format
+            importOld(in, data, firstLine);
+        }
+    }
+
+    return data.length();
+}
+
+void TrackUtil::initTime(
+        DataPoints &data)
+{
+    const DataPoint &dp0 = data[0];
+    qint64 start = dp0.dateTime.toMSecsSinceEpoch();
+
+    for (int i = 0; i < data.size(); ++i)
+    {
+        DataPoint &dp = data[i];
+        qint64 end = dp.dateTime.toMSecsSinceEpoch();
+        dp.t = (double) (end - start) / 1000;
+    }
+}
+
+void TrackUtil::initAltitude(
+        DataPoints &data,
+        double ground)
+{
+    for (int i = 0; i < data.size(); ++i)
+    {
+        DataPoint &dp = data[i];
+        dp.z = dp.hMSL - ground;
+    }
+}
+
+void TrackUtil::initAcceleration(
+        DataPoints &data)
+{
+    for (int i = 0; i < data.size(); ++i)
+    {
+        DataPoint &dp = data[i];
+
+        // Acceleration
+        double accelN = getSlope(data, i, DataPoint::northSpeedRaw);
+        double accelE = getSlope(data, i, DataPoint::eastSpeedRaw);
+        double accelD = getSlope(data, i, DataPoint::verticalSpeed);
+
+        // Calculate acceleration in direction of flight
+        const double vh = sqrt(dp.velN * dp.velN + dp.velE * dp.velE);
+        dp.ax = (accelN * dp.velN + accelE * dp.velE) / vh;
+
+        // Calculate acceleration perpendicular to flight
+        dp.ay = (accelE * dp.velN - accelN * dp.velE) / vh;
+
+        // Calculate vertical acceleration
+        dp.az = accelD;
+
+        // Calculate total acceleration
+        dp.amag = sqrt(accelN * accelN + accelE * accelE + accelD * accelD);
+    }
+}
+
+qint64 TrackUtil::findExit(
+        const DataPoints &data)
+{
+    for (int i = 1; i < data.size(); ++i)
+    {
+        const DataPoint &dp1 = data[i - 1];
+        const DataPoint &dp2 = data[i];
+
+        // Get interpolation coefficient
+        const double velD = A_GRAVITY;
+        const double a = (velD - dp1.velD) / (dp2.velD - dp1.velD);
+
+        // Check vertical speed
+        if (a < 0 || 1 < a) continue;
+
+        // Check accuracy
+        const double vAcc = dp1.vAcc + a * (dp2.vAcc - dp1.vAcc);
+        if (vAcc > 10) continue;
+
+        // Check acceleration
+        const double az = dp1.az + a * (dp2.az - dp1.az);
+        if (az < A_GRAVITY / 5.) continue;
+
+        // Determine exit
+        const qint64 t1 = dp1.dateTime.toMSecsSinceEpoch();
+        const qint64 t2 = dp2.dateTime.toMSecsSinceEpoch();
+        return t1 + a * (t2 - t1) - velD / az * 1000.;
+    }
+
+    const DataPoint &dp0 = data[0];
+    return dp0.dateTime.toMSecsSinceEpoch();
+}
+
+void TrackUtil::setExit(
+        DataPoints &data,
+        qint64 start)
+{
+    for (int i = 0; i < data.size(); ++i)
+    {
+        DataPoint &dp = data[i];
+        qint64 end = dp.dateTime.toMSecsSinceEpoch();
+        dp.t = (double) (end - start) / 1000;
+    }
+}
+
+void TrackUtil::updateVelocity(
+        DataPoints &data,
+        double windE,
+        double windN,
+        double theta0,
+        bool windAdjustment)
+{
+    if (data.isEmpty()) return;
+
+    if (windAdjustment)
+    {
+        // Wind-adjusted position
+        for (int i = 0; i < data.size(); ++i)
+        {
+            const DataPoint &dp0 = interpolateDataT(data, 0);
+            DataPoint &dp = data[i];
+
+            double distance = getDistance(dp0, dp, windAdjustment);
+            double bearing = getBearing(dp0, dp, windAdjustment);
+
+            dp.x = distance * sin(bearing) - windE * dp.t;
+            dp.y = distance * cos(bearing) - windN * dp.t;
+        }
+
+        // Wind-adjusted velocity
+        for (int i = 0; i < data.size(); ++i)
+        {
+            DataPoint &dp = data[i];
+
+            dp.vx = dp.velE - windE;
+            dp.vy = dp.velN - windN;
+        }
+    }
+    else
+    {
+        // Unadjusted position
+        for (int i = 0; i < data.size(); ++i)
+        {
+            const DataPoint &dp0 = interpolateDataT(data, 0);
+            DataPoint &dp = data[i];
+
+            double distance = getDistance(dp0, dp, windAdjustment);
+            double bearing = getBearing(dp0, dp, windAdjustment);
+
+            dp.x = distance * sin(bearing);
+            dp.y = distance * cos(bearing);
+        }
+
+        // Unadjusted velocity
+        for (int i = 0; i < data.size(); ++i)
+        {
+            DataPoint &dp = data[i];
+
+            dp.vx = dp.velE;
+            dp.vy = dp.velN;
+        }
+    }
+
+    // Distance measurements
+    double dist2D = 0, dist3D = 0;
+
+    for (int i = 0; i < data.size(); ++i)
+    {
+        DataPoint &dp = data[i];
+
+        if (i > 0)
+        {
+            const DataPoint &dpPrev = data[i - 1];
+
+            double dx = dp.x - dpPrev.x;
+            double dy = dp.y - dpPrev.y;
+            double dh = sqrt(dx * dx + dy * dy);
+            double dz = dp.hMSL - dpPrev.hMSL;
+
+            dist2D += dh;
+            dist3D += sqrt(dh * dh + dz * dz);
+        }
+
+        dp.dist2D = dist2D;
+        dp.dist3D = dist3D;
+    }
+
+    // Adjust for exit
+    DataPoint dp0 = interpolateDataT(data, 0);
+
+    for (int i = 0; i < data.size(); ++i)
+    {
+        DataPoint &dp = data[i];
+
+        dp.x -= dp0.x;
+        dp.y -= dp0.y;
+
+        dp.dist2D -= dp0.dist2D;
+        dp.dist3D -= dp0.dist3D;
+    }
+
+    // Cumulative heading
+    double prevHeading;
+    bool firstHeading = true;
+
+    for (int i = 0; i < data.size(); ++i)
+    {
+        DataPoint &dp = data[i];
+
+        // Calculate heading
+        dp.heading = atan2(dp.vx, dp.vy) / PI * 180;
+
+        // Calculate heading accuracy
+        const double s = DataPoint::totalSpeed(dp);
+        if (s != 0) dp.cAcc = dp.sAcc / s;
+        else        dp.cAcc = 0;
+
+        // Adjust heading
+        if (!firstHeading)
+        {
+            while (dp.heading <  prevHeading - 180) dp.heading += 360;
+            while (dp.heading >= prevHeading + 180) dp.heading -= 360;
+        }
+
+        // Relative heading
+        dp.theta = dp.heading - theta0;
+
+        firstHeading = false;
+        prevHeading = dp.heading;
+    }
+
+    // Parameters depending on velocity
+    for (int i = 0; i < data.size(); ++i)
+    {
+        DataPoint &dp = data[i];
+
+        dp.curv = getSlope(data, i, DataPoint::diveAngle);
+        dp.accel = getSlope(data, i, DataPoint::totalSpeed);
+        dp.omega = getSlope(data, i, DataPoint::course);
+    }
+}
+
+void TrackUtil::initAerodynamics(
+        DataPoints &data,
+        double mass,
+        double planformArea)
+{
+    for (int i = 0; i < data.size(); ++i)
+    {
+        DataPoint &dp = data[i];
+
+        // Acceleration
+        double accelN = getSlope(data, i, DataPoint::northSpeed);
+        double accelE = getSlope(data, i, DataPoint::eastSpeed);
+        double accelD = getSlope(data, i, DataPoint::verticalSpeed);
+
+        // Subtract acceleration due to gravity
+        accelD -= A_GRAVITY;
+
+        // Calculate acceleration due to drag
+        const double vel = DataPoint::totalSpeed(dp);
+        const double proj = (accelN * dp.vy + accelE * dp.vx + accelD * dp.velD) / vel;
+
+        const double dragN = proj * dp.vy / vel;
+        const double dragE = proj * dp.vx / vel;
+        const double dragD = proj * dp.velD / vel;
+
+        const double accelDrag = sqrt(dragN * dragN + dragE * dragE + dragD * dragD);
+
+        // Calculate acceleration due to lift
+        const double liftN = accelN - dragN;
+        const double liftE = accelE - dragE;
+        const double liftD = accelD - dragD;
+
+        const double accelLift = sqrt(liftN * liftN + liftE * liftE + liftD * liftD);
+
+        // From https://en.wikipedia.org/wiki/Atmospheric_pressure#Altitude_variation
+        const double airPressure = SL_PRESSURE * pow(1 - LAPSE_RATE * dp.hMSL / SL_TEMP, A_GRAVITY * MM_AIR / GAS_CONST / LAPSE_RATE);
+
+        // From https://en.wikipedia.org/wiki/Lapse_rate
+        const double temperature = SL_TEMP - LAPSE_RATE * dp.hMSL;
+
+        // From https://en.wikipedia.org/wiki/Density_of_air
+        const double airDensity = airPressure / (GAS_CONST / MM_AIR) / temperature;
+
+        // From https://en.wikipedia.org/wiki/Dynamic_pressure
+        const double dynamicPressure = airDensity * vel * vel / 2;
+
+        // Calculate lift and drag coefficients
+        dp.lift = mass * accelLift / dynamicPressure / planformArea;
+        dp.drag = mass * accelDrag / dynamicPressure / planformArea;
+    }
+}
+
+int TrackUtil::findIndexBelowT(
+        const DataPoints &data,
+        double t)
+{
+    int below = -1;
+    int above = data.size();
+
+    while (below + 1 != above)
+    {
+        int mid = (below + above) / 2;
+        const DataPoint &dp = data[mid];
+
+        if (dp.t < t) below = mid;
+        else          above = mid;
+    }
+
+    return below;
+}
+
+int TrackUtil::findIndexAboveT(
+        const DataPoints &data,
+        double t)
+{
+    int below = -1;
+    int above = data.size();
+
+    while (below + 1 != above)
+    {
+        int mid = (below + above) / 2;
+        const DataPoint &dp = data[mid];
+
+        if (dp.t > t) above = mid;
+        else          below = mid;
+    }
+
+    return above;
+}
+
+int TrackUtil::findIndexForLanding(
+        const DataPoints &data)
+{
+    int i = findIndexBelowT(data, 0.0);
+
+    while (++i < data.size()-1) {
+        const DataPoint &p = data[i];
+        if (p.velE*p.velE + p.velN*p.velN + p.velD < 1.0)
+            break;
+    }
+
+    return i;
+}
+
+int TrackUtil::findIndexForDeployment(
+        const DataPoints &data,
+        int landing)
+{
+    bool inFreefall = false;
+    for (int i = qMax(0, findIndexAboveT(data, 0.0)); i < landing; ++i)
+    {
+        const double speed = DataPoint::totalSpeed(data[i]);
+
+        // Deployment is the first big slowdown after reaching freefall speed
+        if (speed > DEPLOY_MIN_SPEED) inFreefall = true;
+        else if (inFreefall && speed < DEPLOY_SPEED) return i;
+    }
+
+    return landing;
+}
+
+DataPoint TrackUtil::interpolateDataT(
+        const DataPoints &data,
+        double t)
+{
+    const int i1 = findIndexBelowT(data, t);
+    const int i2 = findIndexAboveT(data, t);
+
+    if (i1 < 0)
+    {
+        return data.first();
+    }
+    else if (i2 >= data.size())
+    {
+        return data.last();
+    }
+    else
+    {
+        const DataPoint &dp1 = data[i1];
+        const DataPoint &dp2 = data[i2];
+        return DataPoint::interpolate(dp1, dp2, (t - dp1.t) / (dp2.t - dp1.t));
+    }
+}
+
+DataPoint TrackUtil::performanceStart(
+        const DataPoints &data,
+        double threshold,
+        const PhaseIndex *index)
+{
+    // ------------------------------------------------------------------
+    //  Find the first data-point *after exit* ( t > 0 ).
+    // ------------------------------------------------------------------
+    const int firstAfterExit = findIndexAboveT(data, 0.0);     // -1 if none
+
+    if (firstAfterExit < 0 || firstAfterExit + 1 >= data.size())
+        return interpolateDataT(data, 0);                      // fall back to exit
+
+    // ------------------------------------------------------------------
+    //  Scan forward through *pairs of points* that are both after exit
+    //  until vertical speed (velD) first reaches or crosses `threshold`.
+    //  With a phase index, the run ends at landing.
+    // ------------------------------------------------------------------
+    const int end = index ? qMin(index->landing + 1, data.size()) : data.size();
+
+    for (int i = firstAfterExit + 1; i < end; ++i)
+    {
+        const DataPoint &p1 = data[i - 1];   // p1.t  > 0  by construction
+        const DataPoint &p2 = data[i];
+
+        if (p1.velD < threshold && p2.velD >= threshold)
+        {
+            double a = (threshold - p1.velD) / (p2.velD - p1.velD);
+            return DataPoint::interpolate(p1, p2, a);
+        }
+    }
+
+    // Never reached the threshold – return the first post-exit sample.
+    return data[firstAfterExit];
+}
+
+TrackUtil::PhaseIndex TrackUtil::indexPhases(
+        const DataPoints &data)
+{
+    PhaseIndex index;
+
+    index.start = qMax(0, findIndexBelowT(data, 0.0));
+    index.landing = findIndexForLanding(data);
+    index.deployment = findIndexForDeployment(data, index.landing);
+
+    // Running extremes, so altitude crossings are found by binary search
+    index.lowest.resize(data.size());
+    index.highest.resize(data.size());
+
+    for (int i = index.start; i < data.size(); ++i)
+    {
+        index.lowest[i] = (i > index.start) ? qMin(index.lowest[i - 1], data[i].z) : data[i].z;
+    }
+
+    for (int i = data.size() - 1; i >= 0; --i)
+    {
+        index.highest[i] = (i + 1 < data.size()) ? qMax(index.highest[i + 1], data[i].z) : data[i].z;
+    }
+
+    return index;
+}
+
+int TrackUtil::findIndexBelowZ(
+        const PhaseIndex &index,
+        double z)
+{
+    // First sample from start at or below z, or the size if none
+    int below = index.lowest.size();
+    int above = index.start - 1;
+
+    while (above + 1 != below)
+    {
+        int mid = (above + below) / 2;
+
+        if (index.lowest[mid] <= z) below = mid;
+        else                        above = mid;
+    }
+
+    return below;
+}
+
+int TrackUtil::findIndexAboveZ(
+        const PhaseIndex &index,
+        double z)
+{
+    // Last sample from start at or above z, or start - 1 if none
+    int above = index.start - 1;
+    int below = index.highest.size();
+
+    while (above + 1 != below)
+    {
+        int mid = (above + below) / 2;
+
+        if (index.highest[mid] >= z) above = mid;
+        else                         below = mid;
+    }
+
+    return above;
+}
+
+double TrackUtil::getSlope(
+        const DataPoints &data,
+        const int center,
+        double (*value)(const DataPoint &))
+{
+    int iMin = qMax (0, center - 4);
+    int iMax = qMin (data.size () - 1, center + 4);
+
+    double sumx = 0, sumy = 0, sumxx = 0, sumxy = 0;
+
+    for (int i = iMin; i <= iMax; ++i)
+    {
+        const DataPoint &dp = data[i];
+        double y = value(dp);
+
+        sumx += dp.t;
+        sumy += y;
+        sumxx += dp.t * dp.t;
+        sumxy += dp.t * y;
+    }
+
+    int n = iMax - iMin + 1;
+    return (sumxy - sumx * sumy / n) / (sumxx - sumx * sumx / n);
+}
+
+double TrackUtil::getDistance(
+        const DataPoint &dp1,
+        const DataPoint &dp2,
+        bool windAdjustment)
+{
+    if (!windAdjustment && dp1.hasGeodetic && dp2.hasGeodetic)
+    {
+        const Geodesic &geod = Geodesic::WGS84();
+        double s12;
+
+        geod.Inverse(dp1.lat, dp1.lon, dp2.lat, dp2.lon, s12);
+
+        return s12;
+    }
+    else
+    {
+        const double dx = dp2.x - dp1.x;
+        const double dy = dp2.y - dp1.y;
+
+        return sqrt(dx * dx + dy * dy);
+    }
+}
+
+double TrackUtil::getBearing(
+        const DataPoint &dp1,
+        const DataPoint &dp2,
+        bool windAdjustment)
+{
+    if (!windAdjustment && dp1.hasGeodetic && dp2.hasGeodetic)
+    {
+        const Geodesic &geod = Geodesic::WGS84();
+        double azi1, azi2;
+
+        geod.Inverse(dp1.lat, dp1.lon, dp2.lat, dp2.lon, azi1, azi2);
+
+        return azi1 / 180 * PI;
+    }
+    else
+    {
+        const double dx = dp2.x - dp1.x;
+        const double dy = dp2.y - dp1.y;
+
+        return atan2(dx, dy);
+    }
+}
+
+QString TrackUtil::dateTimeToUTC(
+        const QDateTime &dt)
+{
+    QString ret;
+    ret += dt.toUTC().date().toString(Qt::ISODate) + "T";
+    ret += dt.toUTC().time().toString(Qt::ISODate) + ".";
+    ret += QString("%1").arg(dt.toUTC().time().msec(), 3, 10, QChar('0')) + "Z";
+    return ret;
+}
+
+bool TrackUtil::exportToCSV(
+        QIODevice *device,
+        const DataPoints &data,
+        double lower,
+        double upper)
+{
+    ExportWriter out(device);
+
+    // Write header
+    out.write("time,lat,lon,hMSL,velN,velE,velD,hAcc,vAcc,sAcc,heading,cAcc,gpsFix,numSV\n");
+    out.write(",(deg),(deg),(m),(m/s),(m/s),(m/s),(m),(m),(m/s),(deg),(deg),,\n");
+
+    // Only points within the range
+    const int start = findIndexBelowT(data, lower) + 1;
+    const int end = findIndexAboveT(data, upper);
+
+    for (int i = start; i < end; ++i)
+    {
+        const DataPoint &dp = data[i];
+
+        out.writeDateTime(dp.dateTime);                 out.write(',');
+
+        out.writeFixed(dp.lat, 7);                      out.write(',');
+        out.writeFixed(dp.lon, 7);                      out.write(',');
+        out.writeFixed(dp.hMSL, 3);                     out.write(',');
+
+        out.writeFixed(dp.velN, 2);                     out.write(',');
+        out.writeFixed(dp.velE, 2);                     out.write(',');
+        out.writeFixed(dp.velD, 2);                     out.write(',');
+
+        out.writeFixed(dp.hAcc, 3);                     out.write(',');
+        out.writeFixed(dp.vAcc, 3);                     out.write(',');
+        out.writeFixed(dp.sAcc, 2);                     out.write(',');
+
+        // Get adjusted heading
+        double heading = dp.heading;
+        while (heading <  0)   heading += 360;
+        while (heading >= 360) heading -= 360;
+
+        out.writeFixed(heading, 5);                     out.write(',');
+        out.writeFixed(dp.cAcc, 5);                     out.write(',');
+
+        out.write(',');  // gpsFix
+
+        out.writeInt(dp.numSV);                         out.write('\n');
+    }
+
+    return out.flush();
+}
+
+bool TrackUtil::exportToKML(
+        QIODevice *device,
+        const QString &name,
+        const DataPoints &data,
+        double lower,
+        double upper)
+{
+    ExportWriter out(device);
+
+    // Write headers
+    out.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    out.write("<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n");
+    out.write("  <Placemark>\n");
+    out.write("    <name>");
+    out.write(name.toHtmlEscaped());
+    out.write("</name>\n");
+    out.write("    <LineString>\n");
+    out.write("      <altitudeMode>absolute</altitudeMode>\n");
+    out.write("      <coordinates>\n");
+
+    // Only points within the range
+    const int start = findIndexBelowT(data, lower) + 1;
+    const int end = findIndexAboveT(data, upper);
+
+    for (int i = start; i < end; ++i)
+    {
+        const DataPoint &dp = data[i];
+
+        out.write(i == start ? "        " : " ");
+
+        out.writeFixed(dp.lon, 7);      out.write(',');
+        out.writeFixed(dp.lat, 7);      out.write(',');
+        out.writeFixed(dp.hMSL, 3);
+    }
+
+    if (start < end)
+    {
+        out.write('\n');
+    }
+
+    // Write footers
+    out.write("      </coordinates>\n");
+    out.write("    </LineString>\n");
+    out.write("  </Placemark>\n");
+    out.write("</kml>\n");
+
+    return out.flush();
+}
@@ -0,0 +1,93 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef TRACKUTIL_H
+#define TRACKUTIL_H
+
+#include <QDateTime>
+#include <QString>
+#include <QVector>
+
+#include "datapoint.h"
+
+class QIODevice;
+
+/* Track import and derivation without any dependency on the user interface.
+ * MainWindow and the batch processor both go through these functions. */
+namespace TrackUtil
+{
+    typedef QVector< DataPoint > DataPoints;
+
+    // Where each phase of a jump lies, found once per track so scoring
+    // can look up the part after exit instead of scanning the whole track
+    typedef struct {
+        int start;                  // Last sample before exit, or 0
+        int deployment;             // First sample under canopy, or landing
+        int landing;                // First sample on the ground
+        QVector< double > lowest;   // Lowest altitude from start to each sample
+        QVector< double > highest;  // Highest altitude from each sample to the end
+    } PhaseIndex;
+
+    // Import
+    int import(QIODevice *device, DataPoints &data);
+
+    // Derived values
+    void initTime(DataPoints &data);
+    void initAltitude(DataPoints &data, double ground);
+    void initAcceleration(DataPoints &data);
+    qint64 findExit(const DataPoints &data);
+    void setExit(DataPoints &data, qint64 start);
+    void updateVelocity(DataPoints &data, double windE, double windN,
+                        double theta0, bool windAdjustment);
+    void initAerodynamics(DataPoints &data, double mass, double planformArea);
+
+    // Queries
+    int findIndexBelowT(const DataPoints &data, double t);
+    int findIndexAboveT(const DataPoints &data, double t);
+    int findIndexForLanding(const DataPoints &data);
+    int findIndexForDeployment(const DataPoints &data, int landing);
+    DataPoint interpolateDataT(const DataPoints &data, double t);
+    DataPoint performanceStart(const DataPoints &data, double threshold = 10.0,
+                               const PhaseIndex *index = 0);
+
+    // Phase index
+    PhaseIndex indexPhases(const DataPoints &data);
+    int findIndexBelowZ(const PhaseIndex &index, double z);
+    int findIndexAboveZ(const PhaseIndex &index, double z);
+
+    double getSlope(const DataPoints &data, const int center,
+                    double (*value)(const DataPoint &));
+    double getDistance(const DataPoint &dp1, const DataPoint &dp2,
+                       bool windAdjustment);
+    double getBearing(const DataPoint &dp1, const DataPoint &dp2,
+                      bool windAdjustment);
+
+    // Export
+    QString dateTimeToUTC(const QDateTime &dt);
+    bool exportToCSV(QIODevice *device, const DataPoints &data,
+                     double lower, double upper);
+    bool exportToKML(QIODevice *device, const QString &name,
+                     const DataPoints &data, double lower, double upper);
+}
+
+#endif // TRACKUTIL_H
@@ -1,6 +1,7 @@
 #include "ubx.h"
 
 #include <math.h>
+#include <string.h>
 
 #include "config.h"
 #include "datapoint.h"
@@ -50,6 +51,27 @@ UBX::UBX(
     mVal[0] = UBX_INVALID_VALUE;
 }
 
+void UBX::copyState(
+        const UBX &other)
+{
+    // Copy everything except the configuration and tone references
+    mCurSpeech = other.mCurSpeech;
+
+    mSpCounter = other.mSpCounter;
+
+    mFlags = other.mFlags;
+    mPrevFlags = other.mPrevFlags;
+
+    mPrevHMSL = other.mPrevHMSL;
+
+    mSuppressTone = other.mSuppressTone;
+
+    memcpy(mSpeechBuf, other.mSpeechBuf, sizeof(mSpeechBuf));
+    mSpeechPtr = mSpeechBuf + (other.mSpeechPtr - other.mSpeechBuf);
+
+    memcpy(mVal, other.mVal, sizeof(mVal));
+}
+
 char *UBX::writeInt32ToBuf(
     char    *ptr,
     int32_t val,
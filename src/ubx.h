@@ -16,6 +16,8 @@ public:
     void receiveMessage(const DataPoint &dp);
     void task();
 
+    void copyState(const UBX &other);
+
 private:
     typedef struct
     {
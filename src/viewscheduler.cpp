@@ -0,0 +1,192 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#include "viewscheduler.h"
+
+#include <QDockWidget>
+#include <QEvent>
+#include <QMetaObject>
+#include <QTimer>
+#include <QWidget>
+
+#define FRAME_INTERVAL 16 // ms
+
+ViewScheduler::ViewScheduler(QObject *parent) :
+    QObject(parent)
+{
+    mTimer = new QTimer(this);
+    mTimer->setSingleShot(true);
+
+    connect(mTimer, SIGNAL(timeout()), this, SLOT(flush()));
+
+    mLastFlush.start();
+}
+
+void ViewScheduler::addView(
+        QWidget *view,
+        QDockWidget *dockWidget,
+        Update update,
+        const char *slot)
+{
+    int i;
+    for (i = 0; i < mEntries.size(); ++i)
+    {
+        if (mEntries[i].view == view) break;
+    }
+
+    if (i == mEntries.size())
+    {
+        Entry entry;
+        entry.view = view;
+        entry.dockWidget = dockWidget;
+        entry.dirty = 0;
+        mEntries.append(entry);
+
+        // Views which were collapsed catch up when resized
+        view->installEventFilter(this);
+
+        if (dockWidget)
+        {
+            connect(dockWidget, SIGNAL(visibilityChanged(bool)),
+                    this, SLOT(onVisibilityChanged(bool)));
+        }
+    }
+
+    mEntries[i].methods[update] = slot;
+}
+
+void ViewScheduler::markData()
+{
+    mark(Data);
+}
+
+void ViewScheduler::markRange()
+{
+    mark(Range);
+}
+
+void ViewScheduler::markCursor()
+{
+    mark(Cursor);
+}
+
+void ViewScheduler::markMediaCursor()
+{
+    mark(MediaCursor);
+}
+
+void ViewScheduler::mark(
+        Update update)
+{
+    for (int i = 0; i < mEntries.size(); ++i)
+    {
+        Entry &entry = mEntries[i];
+        if (!entry.methods[update].isEmpty())
+        {
+            entry.dirty |= (1 << update);
+        }
+    }
+
+    schedule();
+}
+
+void ViewScheduler::schedule()
+{
+    if (mTimer->isActive()) return;
+
+    // Let other notifications from this event loop pass arrive first, and
+    // don't redraw more often than once per frame
+    qint64 elapsed = mLastFlush.elapsed();
+    mTimer->start(qMax((qint64) 0, FRAME_INTERVAL - elapsed));
+}
+
+bool ViewScheduler::isShown(
+        const Entry &entry) const
+{
+    if (entry.dockWidget && !entry.dockWidget->isVisible()) return false;
+    return entry.view->isVisible() && !entry.view->visibleRegion().isEmpty();
+}
+
+void ViewScheduler::flush()
+{
+    mLastFlush.restart();
+
+    for (int i = 0; i < mEntries.size(); )
+    {
+        Entry &entry = mEntries[i];
+
+        // Forget views which have been deleted
+        if (!entry.view)
+        {
+            mEntries.removeAt(i);
+            continue;
+        }
+
+        ++i;
+
+        if (!entry.dirty || !isShown(entry)) continue;
+
+        const int dirty = entry.dirty;
+        entry.dirty = 0;
+
+        QList< QByteArray > called;
+        for (int update = Data; update < updateLast; ++update)
+        {
+            if (!(dirty & (1 << update))) continue;
+
+            const QByteArray &slot = entry.methods[update];
+            if (called.contains(slot)) continue;
+
+            QMetaObject::invokeMethod(entry.view, slot.constData());
+            called.append(slot);
+
+            // Full updates include the cursors
+            if (update <= Range) break;
+        }
+    }
+}
+
+bool ViewScheduler::eventFilter(
+        QObject *watched,
+        QEvent *event)
+{
+    if (event->type() == QEvent::Show || event->type() == QEvent::Resize)
+    {
+        for (int i = 0; i < mEntries.size(); ++i)
+        {
+            if (mEntries[i].view == watched && mEntries[i].dirty)
+            {
+                schedule();
+                break;
+            }
+        }
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+
+void ViewScheduler::onVisibilityChanged(
+        bool visible)
+{
+    if (visible) schedule();
+}
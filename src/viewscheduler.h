@@ -0,0 +1,88 @@
+/***************************************************************************
+**                                                                        **
+**  FlySight Viewer                                                       **
+**  Copyright 2020 Michael Cooper                                         **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>. **
+**                                                                        **
+****************************************************************************
+**  Contact: Michael Cooper                                               **
+**  Website: http://flysight.ca/                                          **
+****************************************************************************/
+
+#ifndef VIEWSCHEDULER_H
+#define VIEWSCHEDULER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+
+class QDockWidget;
+class QTimer;
+class QWidget;
+
+/* Collects MainWindow change notifications and forwards them to the views at
+ * most once per frame. Views in hidden docks are left dirty and brought up to
+ * date when they are shown again. */
+class ViewScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Listed from most to least expensive. A Data or Range update is
+    // expected to redraw everything below it.
+    typedef enum {
+        Data = 0, Range, Cursor, MediaCursor, updateLast
+    } Update;
+
+    explicit ViewScheduler(QObject *parent = 0);
+
+    void addView(QWidget *view, QDockWidget *dockWidget,
+                 Update update, const char *slot);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event);
+
+private:
+    typedef struct {
+        QPointer< QWidget >     view;
+        QPointer< QDockWidget > dockWidget;
+        QByteArray              methods[updateLast];
+        int                     dirty;
+    } Entry;
+
+    QList< Entry > mEntries;
+
+    QTimer        *mTimer;
+    QElapsedTimer  mLastFlush;
+
+    void mark(Update update);
+    void schedule();
+    bool isShown(const Entry &entry) const;
+
+public slots:
+    void markData();
+    void markRange();
+    void markCursor();
+    void markMediaCursor();
+
+    void flush();
+
+private slots:
+    void onVisibilityChanged(bool visible);
+};
+
+#endif // VIEWSCHEDULER_H
@@ -27,12 +27,11 @@
 #include "GeographicLib/Constants.hpp"
 #include "GeographicLib/Geodesic.hpp"
 
-#include "geographicutil.h"
+#include "lanecoordinates.h"
 #include "mainwindow.h"
 #include "wideopendistancescoring.h"
 
 using namespace GeographicLib;
-using namespace GeographicUtil;
 
 WideOpenDistanceForm::WideOpenDistanceForm(QWidget *parent) :
     QWidget(parent),
@@ -134,21 +133,9 @@ void WideOpenDistanceForm::updateView()
     }
     else
     {
-        // Get projected point
-        double lat0, lon0;
-        intercept(dpTop.lat, dpTop.lon, endLatitude, endLongitude, dpBottom.lat, dpBottom.lon, lat0, lon0);
-
-        // Distance from top
-        double topDist;
-        Geodesic::WGS84().Inverse(dpTop.lat, dpTop.lon, lat0, lon0, topDist);
-
-        // Distance from bottom
-        double bottomDist;
-        Geodesic::WGS84().Inverse(endLatitude, endLongitude, lat0, lon0, bottomDist);
-
-        double s12;
-        if (topDist > bottomDist) s12 = topDist;
-        else                      s12 = laneLength - bottomDist;
+        // Distance along lane from top
+        LaneCoordinates lane(dpTop.lat, dpTop.lon, endLatitude, endLongitude);
+        const double s12 = lane.distance(dpBottom.lat, dpBottom.lon);
 
         ui->distanceEdit->setText(QString("%1").arg(
                                       (mMainWindow->units() == PlotValue::Metric) ?
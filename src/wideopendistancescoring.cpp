@@ -33,8 +33,7 @@
 #include "mainwindow.h"
 #include "mapview.h"
 #include "mapcore.h"
-
-#define MAX_SPLIT_DEPTH 8
+#include "mappath.h"
 
 using namespace GeographicLib;
 using namespace GeographicUtil;
@@ -172,78 +171,19 @@ void WideOpenDistanceScoring::prepareMapView(
     if (mMainWindow->dataSize() == 0) return;
 
     // Distance threshold
-    const double threshold = view->metersPerPixel();
+    const double threshold = view->tolerance();
 
     // Get start point
     double woProjLat, woProjLon;
     Geodesic::WGS84().Direct(mEndLatitude, mEndLongitude, mBearing, mLaneLength, woProjLat, woProjLon);
 
-    // Draw lane center
-    QList<QVariant> data;
-
-    QMap<QString, QVariant> val;
-    val["lat"] = mEndLatitude;
-    val["lng"] = mEndLongitude;
-    data.push_back(val);
-
-    splitLine(data, mEndLatitude, mEndLongitude, woProjLat, woProjLon, threshold, 0);
-
-    val["lat"] = woProjLat;
-    val["lng"] = woProjLon;
-    data.push_back(val);
-
-    // Add to map
-    view->mapCore()->addPolyline(data);
-
-    // Draw shading around lane
-    QList<QVariant> lt, rt;
-    for (int i = 0; i < data.size(); ++i)
-    {
-        double lat1 = data[i].toMap()["lat"].toDouble();
-        double lon1 = data[i].toMap()["lng"].toDouble();
-
-        double ltBearing, rtBearing;
-
-        if (i + 1 < data.size())
-        {
-            double lat2 = data[i+1].toMap()["lat"].toDouble();
-            double lon2 = data[i+1].toMap()["lng"].toDouble();
-
-            double azi1, azi2;
-            Geodesic::WGS84().Inverse(lat1, lon1, lat2, lon2, azi1, azi2);
-
-            ltBearing = azi1 + 90;
-            rtBearing = azi1 - 90;
-        }
-        else if (i - 1 >= 0)
-        {
-            double lat2 = data[i-1].toMap()["lat"].toDouble();
-            double lon2 = data[i-1].toMap()["lng"].toDouble();
-
-            double azi1, azi2;
-            Geodesic::WGS84().Inverse(lat2, lon2, lat1, lon1, azi1, azi2);
+    // Draw lane center and shading
+    mLane.update(mEndLatitude, mEndLongitude, woProjLat, woProjLon, mLaneWidth, threshold);
 
-            ltBearing = azi2 + 90;
-            rtBearing = azi2 - 90;
-        }
-
-        double tempLat, tempLon;
-        Geodesic::WGS84().Direct(lat1, lon1, ltBearing, mLaneWidth / 2, tempLat, tempLon);
-
-        QMap<QString, QVariant> val;
-        val["lat"] = tempLat;
-        val["lng"] = tempLon;
-        lt.push_back(val);
-
-        Geodesic::WGS84().Direct(lat1, lon1, rtBearing, mLaneWidth / 2, tempLat, tempLon);
+    view->mapCore()->addPolyline(mLane.centerLine());
+    view->mapCore()->addPolygon(mLane.outline());
 
-        val["lat"] = tempLat;
-        val["lng"] = tempLon;
-        rt.push_front(val);
-    }
-
-    // Now take lt + rt to form loop
-    view->mapCore()->addPolygon(lt + rt);
+    MapPath data;
 
     // Find exit point
     DataPoint dp0 = mMainWindow->interpolateDataT(0);
@@ -263,19 +203,14 @@ void WideOpenDistanceScoring::prepareMapView(
 
         data.clear();
 
-        QMap<QString, QVariant> val;
-        val["lat"] = woLeftLat;
-        val["lng"] = woLeftLon;
-        data.push_back(val);
+        data.append(woLeftLat, woLeftLon);
 
         splitLine(data, woLeftLat, woLeftLon, woRightLat, woRightLon, threshold, 0);
 
-        val["lat"] = woRightLat;
-        val["lng"] = woRightLon;
-        data.push_back(val);
+        data.append(woRightLat, woRightLon);
 
         // Add to map
-        view->mapCore()->addPolyline(data);
+        view->mapCore()->addPolyline(data.encode());
     }
     else if (dp0.z >= mBottom && success)
     {
@@ -306,28 +241,21 @@ void WideOpenDistanceScoring::prepareMapView(
 
                 data.clear();
 
-                QMap<QString, QVariant> val;
-                val["lat"] = woLeftLat;
-                val["lng"] = woLeftLon;
-                data.push_back(val);
+                data.append(woLeftLat, woLeftLon);
 
                 splitLine(data, woLeftLat, woLeftLon, mEndLatitude, mEndLongitude, threshold, 0);
 
-                val["lat"] = mEndLatitude;
-                val["lng"] = mEndLongitude;
-                data.push_back(val);
+                data.append(mEndLatitude, mEndLongitude);
 
                 // Draw second line of arrow
                 Geodesic::WGS84().Direct(mEndLatitude, mEndLongitude, mBearing - 45, mLaneWidth, woLeftLat, woLeftLon);
 
                 splitLine(data, mEndLatitude, mEndLongitude, woLeftLat, woLeftLon, threshold, 0);
 
-                val["lat"] = woLeftLat;
-                val["lng"] = woLeftLon;
-                data.push_back(val);
+                data.append(woLeftLat, woLeftLon);
 
                 // Add to map
-                view->mapCore()->addPolyline(data);
+                view->mapCore()->addPolyline(data.encode());
             }
         }
         else
@@ -344,28 +272,21 @@ void WideOpenDistanceScoring::prepareMapView(
 
                 data.clear();
 
-                QMap<QString, QVariant> val;
-                val["lat"] = woLeftLat;
-                val["lng"] = woLeftLon;
-                data.push_back(val);
+                data.append(woLeftLat, woLeftLon);
 
                 splitLine(data, woLeftLat, woLeftLon, woProjLat, woProjLon, threshold, 0);
 
-                val["lat"] = woProjLat;
-                val["lng"] = woProjLon;
-                data.push_back(val);
+                data.append(woProjLat, woProjLon);
 
                 // Draw second line of arrow
                 Geodesic::WGS84().Direct(woProjLat, woProjLon, mBearing - 135, mLaneWidth, woLeftLat, woLeftLon);
 
                 splitLine(data, woProjLat, woProjLon, woLeftLat, woLeftLon, threshold, 0);
 
-                val["lat"] = woLeftLat;
-                val["lng"] = woLeftLon;
-                data.push_back(val);
+                data.append(woLeftLat, woLeftLon);
 
                 // Add to map
-                view->mapCore()->addPolyline(data);
+                view->mapCore()->addPolyline(data.encode());
             }
         }
 
@@ -380,19 +301,14 @@ void WideOpenDistanceScoring::prepareMapView(
 
             data.clear();
 
-            QMap<QString, QVariant> val;
-            val["lat"] = woLeftLat;
-            val["lng"] = woLeftLon;
-            data.push_back(val);
+            data.append(woLeftLat, woLeftLon);
 
             splitLine(data, woLeftLat, woLeftLon, woRightLat, woRightLon, threshold, 0);
 
-            val["lat"] = woRightLat;
-            val["lng"] = woRightLon;
-            data.push_back(val);
+            data.append(woRightLat, woRightLon);
 
             // Add to map
-            view->mapCore()->addPolyline(data);
+            view->mapCore()->addPolyline(data.encode());
         }
     }
     else
@@ -406,19 +322,14 @@ void WideOpenDistanceScoring::prepareMapView(
 
         data.clear();
 
-        QMap<QString, QVariant> val;
-        val["lat"] = woLeftLat;
-        val["lng"] = woLeftLon;
-        data.push_back(val);
+        data.append(woLeftLat, woLeftLon);
 
         splitLine(data, woLeftLat, woLeftLon, woRightLat, woRightLon, threshold, 0);
 
-        val["lat"] = woRightLat;
-        val["lng"] = woRightLon;
-        data.push_back(val);
+        data.append(woRightLat, woRightLon);
 
         // Add to map
-        view->mapCore()->addPolyline(data);
+        view->mapCore()->addPolyline(data.encode());
 
         // Draw second line of 'X'
         Geodesic::WGS84().Direct(mEndLatitude, mEndLongitude, mBearing - 45, mLaneWidth, woLeftLat, woLeftLon);
@@ -426,47 +337,14 @@ void WideOpenDistanceScoring::prepareMapView(
 
         data.clear();
 
-        val["lat"] = woLeftLat;
-        val["lng"] = woLeftLon;
-        data.push_back(val);
+        data.append(woLeftLat, woLeftLon);
 
         splitLine(data, woLeftLat, woLeftLon, woRightLat, woRightLon, threshold, 0);
 
-        val["lat"] = woRightLat;
-        val["lng"] = woRightLon;
-        data.push_back(val);
+        data.append(woRightLat, woRightLon);
 
         // Add to map
-        view->mapCore()->addPolyline(data);
-    }
-}
-
-void WideOpenDistanceScoring::splitLine(
-        QList<QVariant> &data,
-        double startLat,
-        double startLon,
-        double endLat,
-        double endLon,
-        double threshold,
-        int depth)
-{
-    GeodesicLine l = Geodesic::WGS84().InverseLine(startLat, startLon, endLat, endLon);
-    double midLat, midLon;
-    l.Position(l.Distance() / 2, midLat, midLon);
-
-    double dist;
-    Geodesic::WGS84().Inverse((startLat + endLat) / 2, (startLon + endLon) / 2, midLat, midLon, dist);
-
-    if (dist > threshold && depth < MAX_SPLIT_DEPTH)
-    {
-        splitLine(data, startLat, startLon, midLat, midLon, threshold, depth + 1);
-
-        QMap<QString, QVariant> val;
-        val["lat"] = midLat;
-        val["lng"] = midLon;
-        data.push_back(val);
-
-        splitLine(data, midLat, midLon, endLat, endLon, threshold, depth + 1);
+        view->mapCore()->addPolyline(data.encode());
     }
 }
 
@@ -24,6 +24,7 @@
 #ifndef WIDEOPENDISTANCESCORING_H
 #define WIDEOPENDISTANCESCORING_H
 
+#include "lanecache.h"
 #include "scoringmethod.h"
 
 class MainWindow;
@@ -72,10 +73,7 @@ private:
     double      mLaneWidth;
     double      mLaneLength;
 
-    void splitLine(QList<QVariant> &data,
-                   double startLat, double startLon,
-                   double endLat, double endLon,
-                   double threshold, int depth);
+    LaneCache   mLane;
 
 signals:
 
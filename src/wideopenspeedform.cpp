@@ -27,13 +27,12 @@
 #include "GeographicLib/Constants.hpp"
 #include "GeographicLib/Geodesic.hpp"
 
-#include "geographicutil.h"
+#include "lanecoordinates.h"
 #include "mainwindow.h"
 #include "plotvalue.h"
 #include "wideopenspeedscoring.h"
 
 using namespace GeographicLib;
-using namespace GeographicUtil;
 
 WideOpenSpeedForm::WideOpenSpeedForm(QWidget *parent) :
     QWidget(parent),
@@ -145,48 +144,13 @@ void WideOpenSpeedForm::updateView()
     }
     else
     {
-        // Calculate time
-        int i, start = mMainWindow->findIndexBelowT(0) + 1;
-        double d1, t;
-        DataPoint dp1;
+        // Find where we cross the finish line
+        LaneCoordinates lane(dpTop.lat, dpTop.lon, endLatitude, endLongitude);
 
-        for (i = start; i < mMainWindow->dataSize(); ++i)
-        {
-            const DataPoint &dp2 = mMainWindow->dataPoint(i);
-
-            // Get projected point
-            double lat0, lon0;
-            intercept(dpTop.lat, dpTop.lon, endLatitude, endLongitude, dp2.lat, dp2.lon, lat0, lon0);
-
-            // Distance from top
-            double topDist;
-            Geodesic::WGS84().Inverse(dpTop.lat, dpTop.lon, lat0, lon0, topDist);
-
-            // Distance from bottom
-            double bottomDist;
-            Geodesic::WGS84().Inverse(endLatitude, endLongitude, lat0, lon0, bottomDist);
-
-            double d2;
-            if (topDist > bottomDist)
-            {
-                d2 = topDist;
-            }
-            else
-            {
-                d2 = laneLength - bottomDist;
-            }
-
-            if (i > start && d1 < laneLength && d2 >= laneLength)
-            {
-                t = dp1.t + (dp2.t - dp1.t) / (d2 - d1) * (laneLength - d1);
-                break;
-            }
-
-            d1 = d2;
-            dp1 = dp2;
-        }
+        double t;
+        const int i = lane.findCrossing(mMainWindow->data(), mMainWindow->findIndexBelowT(0) + 1, laneLength, t);
 
-        if (i < mMainWindow->dataSize())
+        if (i >= 0)
         {
             DataPoint dp = mMainWindow->interpolateDataT(t);
             method->setFinishPoint(dp);
@@ -24,6 +24,7 @@
 #ifndef WIDEOPENSPEEDSCORING_H
 #define WIDEOPENSPEEDSCORING_H
 
+#include "lanecache.h"
 #include "scoringmethod.h"
 
 class MainWindow;
@@ -75,14 +76,11 @@ private:
     double      mLaneWidth;
     double      mLaneLength;
 
+    LaneCache   mLane;
+
     bool        mFinishValid;
     DataPoint   mFinishPoint;
 
-    void splitLine(QList<QVariant> &data,
-                   double startLat, double startLon,
-                   double endLat, double endLon,
-                   double threshold, int depth);
-
 signals:
 
 public slots:
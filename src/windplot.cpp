@@ -54,34 +54,33 @@ void WindPlot::mouseMoveEvent(
 {
     if (QCPCurve *curve = qobject_cast<QCPCurve *>(plottable(0)))
     {
-        QSharedPointer<QCPCurveDataContainer> data = curve->data();
-
-        double resultTime;
-        double resultDistance = std::numeric_limits<double>::max();
-
-        for (QCPCurveDataContainer::const_iterator it = data->constBegin();
-             it != data->constEnd() && (it + 1) != data->constEnd();
-             ++ it)
+        // Index the curve the first time it is hovered
+        if (!mIndex.isBuilt())
         {
-            QPointF pt1 = QPointF(xAxis->coordToPixel(it->key),
-                                  yAxis->coordToPixel(it->value));
-            QPointF pt2 = QPointF(xAxis->coordToPixel((it + 1)->key),
-                                  yAxis->coordToPixel((it + 1)->value));
+            QSharedPointer<QCPCurveDataContainer> data = curve->data();
 
-            double mu;
-            double dist = sqrt(distSqrToLine(pt1, pt2, event->pos(), mu));
-
-            if (dist < resultDistance)
+            mIndex.clear();
+            for (QCPCurveDataContainer::const_iterator it = data->constBegin();
+                 it != data->constEnd();
+                 ++it)
             {
-                double t1 = it->t;
-                double t2 = (it + 1)->t;
-
-                resultTime = t1 + mu * (t2 - t1);
-                resultDistance = dist;
+                mIndex.addPoint(it->key, it->value, it->t);
             }
+            mIndex.build();
         }
 
-        if (resultDistance < selectionTolerance())
+        // Map from plot coordinates to pixels
+        const double x0 = xAxis->coordToPixel(0);
+        const double y0 = yAxis->coordToPixel(0);
+        const QTransform transform(xAxis->coordToPixel(1) - x0, 0,
+                                   0, yAxis->coordToPixel(1) - y0,
+                                   x0, y0);
+
+        double resultTime;
+        double resultDistance;
+
+        if (mIndex.findNearest(transform, event->pos(), selectionTolerance(),
+                               resultTime, resultDistance))
         {
             mMainWindow->setMark(resultTime);
         }
@@ -95,6 +94,8 @@ void WindPlot::mouseMoveEvent(
 void WindPlot::updatePlot()
 {
     clearPlottables();
+    mCursors.forget();
+    mIndex.clear();
     clearItems();
 
     // Return now if plot empty
@@ -152,62 +153,6 @@ void WindPlot::updatePlot()
 
     setViewRange(xMin, xMax, yMin, yMax);
 
-    if (mMainWindow->mediaCursorRef() > 0)
-    {
-        const DataPoint &dp = mMainWindow->interpolateDataT(mMainWindow->mediaCursor());
-
-        t.clear();
-        x.clear();
-        y.clear();
-
-        QVector< double > xMark, yMark;
-
-        if (mMainWindow->units() == PlotValue::Metric)
-        {
-            xMark.append(dp.velE * MPS_TO_KMH);
-            yMark.append(dp.velN * MPS_TO_KMH);
-        }
-        else
-        {
-            xMark.append(dp.velE * MPS_TO_MPH);
-            yMark.append(dp.velN * MPS_TO_MPH);
-        }
-
-        QCPGraph *graph = addGraph();
-        graph->setData(xMark, yMark);
-        graph->setPen(QPen(Qt::darkGray, mMainWindow->lineThickness()));
-        graph->setLineStyle(QCPGraph::lsNone);
-        graph->setScatterStyle(QCPScatterStyle::ssDisc);
-    }
-
-    if (mMainWindow->markActive())
-    {
-        const DataPoint &dpEnd = mMainWindow->interpolateDataT(mMainWindow->markEnd());
-
-        t.clear();
-        x.clear();
-        y.clear();
-
-        QVector< double > xMark, yMark;
-
-        if (mMainWindow->units() == PlotValue::Metric)
-        {
-            xMark.append(dpEnd.velE * MPS_TO_KMH);
-            yMark.append(dpEnd.velN * MPS_TO_KMH);
-        }
-        else
-        {
-            xMark.append(dpEnd.velE * MPS_TO_MPH);
-            yMark.append(dpEnd.velN * MPS_TO_MPH);
-        }
-
-        QCPGraph *graph = addGraph();
-        graph->setData(xMark, yMark);
-        graph->setPen(QPen(Qt::black, mMainWindow->lineThickness()));
-        graph->setLineStyle(QCPGraph::lsNone);
-        graph->setScatterStyle(QCPScatterStyle::ssDisc);
-    }
-
     updateWind(start, end);
 
     QVector< double > xMark, yMark;
@@ -289,6 +234,23 @@ void WindPlot::updatePlot()
                     .arg(mVelAircraft * factor)
                     .arg(units));
 
+    mCursors.update(this, mMainWindow, *this);
+
+    replot();
+}
+
+QPointF WindPlot::project(
+        const DataPoint &dp) const
+{
+    const double factor = (mMainWindow->units() == PlotValue::Metric) ? MPS_TO_KMH : MPS_TO_MPH;
+    return QPointF(dp.velE * factor, dp.velN * factor);
+}
+
+void WindPlot::updateCursor()
+{
+    // The track and its index are unchanged, so only move the markers
+    mCursors.update(this, mMainWindow, *this);
+
     replot();
 }
 
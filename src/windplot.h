@@ -26,9 +26,12 @@
 
 #include "QCustomPlot/qcustomplot.h"
 
+#include "cursormarkers.h"
+#include "segmentindex.h"
+
 class MainWindow;
 
-class WindPlot : public QCustomPlot
+class WindPlot : public QCustomPlot, public CursorMarkers::Projection
 {
     Q_OBJECT
 
@@ -48,13 +51,18 @@ private:
     double mWindE, mWindN;
     double mVelAircraft;
 
+    SegmentIndex mIndex;
+    CursorMarkers mCursors;
+
     void setViewRange(double xMin, double xMax,
                       double yMin, double yMax);
 
     void updateWind(const int start, const int end);
+    QPointF project(const DataPoint &dp) const;
 
 public slots:
     void updatePlot();
+    void updateCursor();
     void save();
 };
 